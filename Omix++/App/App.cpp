@@ -10,6 +10,8 @@
 #include <fstream>
 #include <stdexcept>
 #include <algorithm>
+#include <sstream>
+#include <cmath>
 
 using namespace std;
 #define MAX_PATH FILENAME_MAX
@@ -20,6 +22,8 @@ using namespace std;
 #include "OMAP/RAMStoreEnclaveInterface.h"
 #include "../Common/Common.h"
 #include "OMAP/Node.h"
+#include "Workload.h"
+#include "Experiments.h"
 /*
  * Copyright (C) 2011-2018 Intel Corporation. All rights reserved.
  *
@@ -499,6 +503,26 @@ void initializeNodes(bytes<Key> secretkey, map<Bid, string>* pairs, vector<block
     }
 }
 
+/* Runs workload operations through the OMAP ecalls */
+class EnclaveWorkloadTarget : public WorkloadTarget {
+public:
+
+    void read(long long key, char* value) {
+        Bid bid = key;
+        ecall_read_node(global_eid, (const char*) bid.id.data(), value);
+    }
+
+    void write(long long key, const char* value) {
+        Bid bid = key;
+        ecall_write_node(global_eid, (const char*) bid.id.data(), value);
+    }
+
+    void remove(long long key) {
+        Bid bid = key;
+        ecall_delete_node(global_eid, (const char*) bid.id.data());
+    }
+};
+
 int SGX_CDECL main(int argc, char *argv[]) {
     (void) (argc);
     (void) (argv);
@@ -519,7 +543,7 @@ int SGX_CDECL main(int argc, char *argv[]) {
     int maxSize = 32;
     int test_case = 6;
     int experiment = 0;
-    if (argc == 4) {
+    if (argc >= 4) {
         maxSize = stoi(argv[1]);
         test_case = stoi(argv[2]);
         experiment = stoi(argv[3]);
@@ -682,6 +706,268 @@ int SGX_CDECL main(int argc, char *argv[]) {
         sgx_destroy_enclave(global_eid);
         return 0;
     }
+    else if (experiment == 3) {
+        ecall_measure_stash_scan_speed(global_eid, maxSize);
+        sgx_destroy_enclave(global_eid);
+        return 0;
+    }
+    else if (experiment == 4) {
+        // stash occupancy of the OMAP's ORAM and of the heap under random inserts
+        ecall_setup_oram(global_eid, maxSize);
+        ecall_setup_oheap(global_eid, maxSize, 0);
+        for (int i = 1; i <= maxSize; i++) {
+            Bid key = (long long) (rand() % maxSize) + 1;
+            char value[16] = {0};
+            ecall_write_node(global_eid, (const char*) key.id.data(), value);
+            ecall_set_new_minheap_node(global_eid, i, rand() % maxSize);
+        }
+        const char* names[2] = {"OMAP", "DOHEAP"};
+        for (int structure = 0; structure < 2; structure++) {
+            vector<long long> histogram(256);
+            long long overflows = 0;
+            int maxOccupancy;
+            ecall_get_stash_stats(global_eid, &maxOccupancy, structure, histogram.data(), histogram.size(), &overflows);
+            printf("%s Max Stash Occupancy: %d\n", names[structure], maxOccupancy);
+            printf("%s Stash Overflows: %lld\n", names[structure], overflows);
+            for (int i = 0; i <= maxOccupancy && i < histogram.size(); i++) {
+                printf("%s Stash Occupancy %d: %lld\n", names[structure], i, histogram[i]);
+            }
+        }
+        sgx_destroy_enclave(global_eid);
+        return 0;
+    }
+    else if (experiment == 5) {
+        ecall_set_tracing(global_eid, 1);
+        ecall_measure_omap_speed(global_eid, &t, maxSize);
+        ecall_flush_trace(global_eid);
+        printTraceHistograms();
+        sgx_destroy_enclave(global_eid);
+        return 0;
+    }
+    else if (experiment == 6) {
+        // boundary and crypto cost per operation type
+        ecall_setup_oram(global_eid, maxSize);
+        ecall_setup_oheap(global_eid, maxSize, 0);
+        ecall_reset_io_stats(global_eid);
+        long long ocallsBefore = storeOcalls;
+        int tests = 100;
+        for (int i = 1; i <= tests; i++) {
+            Bid key = (long long) (rand() % maxSize) + 1;
+            char value[16] = {0};
+            ecall_write_node(global_eid, (const char*) key.id.data(), value);
+            ecall_read_node(global_eid, (const char*) key.id.data(), value);
+            ecall_delete_node(global_eid, (const char*) key.id.data());
+            ecall_set_new_minheap_node(global_eid, i, rand() % maxSize);
+        }
+        const char* operations[5] = {"OMAP Read", "OMAP Write", "OMAP Delete", "Heap", "Other"};
+        const char* counters[9] = {"Ecalls", "Ocalls", "Bytes In", "Bytes Out", "Buckets Read", "Buckets Written", "AES Calls", "Stash Total", "Stash Max"};
+        for (int op = 0; op < 5; op++) {
+            long long stats[9];
+            ecall_get_io_stats(global_eid, op, stats, 9);
+            if (stats[0] == 0) {
+                continue;
+            }
+            for (int c = 0; c < 9; c++) {
+                if (c == 0 || c == 8) {
+                    printf("%s %s: %lld\n", operations[op], counters[c], stats[c]);
+                } else {
+                    printf("%s %s per Operation: %f\n", operations[op], counters[c], (double) stats[c] / stats[0]);
+                }
+            }
+        }
+        printf("Store Ocalls: %lld\n", storeOcalls.load() - ocallsBefore);
+        printf("Store Bytes Received: %lld\n", storeBytesReceived.load());
+        printf("Store Bytes Sent: %lld\n", storeBytesSent.load());
+        sgx_destroy_enclave(global_eid);
+        return 0;
+    }
+    else if (experiment == 7) {
+        // YCSB style workload, options after the experiment number are key=value pairs
+        WorkloadConfig config;
+        config.recordCount = maxSize / 2;
+        config.capacity = maxSize;
+        for (int i = 4; i < argc; i++) {
+            if (!config.parse(argv[i])) {
+                printf("Unknown workload option: %s\n", argv[i]);
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+        }
+        ecall_setup_oram(global_eid, maxSize);
+        EnclaveWorkloadTarget target;
+        Workload workload(config, &target);
+        workload.load();
+        workload.run();
+        if (config.output.empty()) {
+            workload.report(cout);
+        } else {
+            ofstream file(config.output.c_str());
+            workload.report(file);
+        }
+        sgx_destroy_enclave(global_eid);
+        return 0;
+    }
+    else if (experiment == 8) {
+        // one ecall per read against ecall_execute_batch, the batch size follows the experiment number
+        int batchSize = argc >= 5 ? stoi(argv[4]) : 64;
+        int tests = 256;
+        ecall_setup_oram(global_eid, maxSize);
+        vector<omap_request> requests(batchSize);
+        vector<char> results(16 * batchSize);
+        int executed;
+        for (int i = 1; i <= maxSize / 2; i += batchSize) {
+            int count = min(batchSize, maxSize / 2 - i + 1);
+            for (int j = 0; j < count; j++) {
+                Bid key = (long long) (i + j);
+                requests[j].op = OMAP_OP_WRITE;
+                memcpy(requests[j].key, key.id.data(), ID_SIZE);
+                snprintf(requests[j].value, 16, "v%d", i + j);
+            }
+            ecall_execute_batch(global_eid, &executed, requests.data(), results.data(), count);
+        }
+        Utilities::startTimer(800);
+        for (int i = 0; i < tests; i++) {
+            Bid key = (long long) (rand() % (maxSize / 2)) + 1;
+            char value[16];
+            ecall_read_node(global_eid, (const char*) key.id.data(), value);
+        }
+        double single = Utilities::stopTimer(800);
+        Utilities::startTimer(800);
+        for (int i = 0; i < tests; i += batchSize) {
+            int count = min(batchSize, tests - i);
+            for (int j = 0; j < count; j++) {
+                Bid key = (long long) (rand() % (maxSize / 2)) + 1;
+                requests[j].op = OMAP_OP_READ;
+                memcpy(requests[j].key, key.id.data(), ID_SIZE);
+            }
+            ecall_execute_batch(global_eid, &executed, requests.data(), results.data(), count);
+        }
+        double batched = Utilities::stopTimer(800);
+        printf("Batch Size: %d\n", batchSize);
+        printf("Single Read Average Time: %f\n", single / tests);
+        printf("Batched Read Average Time: %f\n", batched / tests);
+        sgx_destroy_enclave(global_eid);
+        return 0;
+    }
+    else if (experiment == 9) {
+        // sharded OMAP throughput against the thread count and batch size, e.g. "9 1,2,4,8 32,128,512"
+        vector<int> shardCounts, batchSizes;
+        stringstream shardList(argc >= 5 ? argv[4] : "1,2,4,8");
+        stringstream batchList(argc >= 6 ? argv[5] : "32,128,512");
+        string item;
+        while (getline(shardList, item, ',')) {
+            shardCounts.push_back(stoi(item));
+        }
+        while (getline(batchList, item, ',')) {
+            batchSizes.push_back(stoi(item));
+        }
+        int largest = *max_element(batchSizes.begin(), batchSizes.end());
+        vector<omap_request> requests(largest);
+        vector<char> results(16 * largest);
+        int executed;
+        // the shards only run in parallel with a core each
+        printf("Cores: %ld\n", sysconf(_SC_NPROCESSORS_ONLN));
+        for (int shards : shardCounts) {
+            ecall_setup_sharded_omap(global_eid, shards, maxSize);
+            for (int i = 1; i <= maxSize / 2; i += largest) {
+                int count = min(largest, maxSize / 2 - i + 1);
+                for (int j = 0; j < count; j++) {
+                    Bid key = (long long) (i + j);
+                    requests[j].op = OMAP_OP_WRITE;
+                    memcpy(requests[j].key, key.id.data(), ID_SIZE);
+                    snprintf(requests[j].value, 16, "v%d", i + j);
+                }
+                ecall_execute_sharded_batch(global_eid, &executed, requests.data(), results.data(), count);
+            }
+            for (int batchSize : batchSizes) {
+                for (int j = 0; j < batchSize; j++) {
+                    Bid key = (long long) (rand() % (maxSize / 2)) + 1;
+                    requests[j].op = j % 2 == 0 ? OMAP_OP_READ : OMAP_OP_WRITE;
+                    memcpy(requests[j].key, key.id.data(), ID_SIZE);
+                    snprintf(requests[j].value, 16, "r%d", batchSize);
+                }
+                Utilities::startTimer(801);
+                ecall_execute_sharded_batch(global_eid, &executed, requests.data(), results.data(), batchSize);
+                double elapsed = Utilities::stopTimer(801);
+                printf("Shards %d Batch %d Throughput: %f\n", shards, batchSize, batchSize / (elapsed / 1000000));
+            }
+        }
+        sgx_destroy_enclave(global_eid);
+        return 0;
+    }
+    else if (experiment == 10) {
+        // reads with the next path fetched during eviction against the sequential path reads
+        int tests = 256;
+        const char* modes[] = {"Sequential", "Pipelined"};
+        for (int pipelined = 0; pipelined < 2; pipelined++) {
+            ecall_set_pipelining(global_eid, pipelined);
+            ecall_setup_oram(global_eid, maxSize);
+            for (int i = 1; i <= maxSize / 2; i++) {
+                Bid key = (long long) i;
+                char value[16] = {0};
+                snprintf(value, 16, "v%d", i);
+                ecall_write_node(global_eid, (const char*) key.id.data(), value);
+            }
+            ecall_flush_trace(global_eid);
+            memset(traceCount, 0, sizeof (traceCount));
+            memset(traceTotal, 0, sizeof (traceTotal));
+            ecall_set_tracing(global_eid, 1);
+            Utilities::startTimer(802);
+            for (int i = 0; i < tests; i++) {
+                Bid key = (long long) (rand() % (maxSize / 2)) + 1;
+                char value[16];
+                ecall_read_node(global_eid, (const char*) key.id.data(), value);
+            }
+            double elapsed = Utilities::stopTimer(802);
+            ecall_set_tracing(global_eid, 0);
+            ecall_flush_trace(global_eid);
+            printf("%s Read Average Time: %f\n", modes[pipelined], elapsed / tests);
+            // the fetch phase is the time an access is blocked on path reads
+            printf("%s Fetch Cycles per Read: %f\n", modes[pipelined], (double) traceTotal[0] / tests);
+        }
+        sgx_destroy_enclave(global_eid);
+        return 0;
+    }
+    else if (experiment == 11) {
+        // single against batched heap operations, e.g. "11 16,64,256" for the batch sizes
+        stringstream list(argc >= 5 ? argv[4] : "16,64,256");
+        string item;
+        const char* phases[] = {"Single Insert", "Batched Insert", "Single Extract-Min", "Batched Extract-Min"};
+        while (getline(list, item, ',')) {
+            int batchSize = stoi(item);
+            vector<int> ids(batchSize), dists(batchSize);
+            ecall_setup_oheap(global_eid, maxSize, 0);
+            printf("Batch Size: %d\n", batchSize);
+            for (int phase = 0; phase < 4; phase++) {
+                for (int i = 0; i < batchSize; i++) {
+                    ids[i] = phase * batchSize + i + 1;
+                    dists[i] = rand() % maxSize;
+                }
+                ecall_reset_io_stats(global_eid);
+                Utilities::startTimer(803);
+                if (phase % 2 == 1) {
+                    ecall_execute_heap_batch(global_eid, ids.data(), dists.data(), batchSize, phase < 2 ? 2 : 1);
+                } else {
+                    for (int i = 0; i < batchSize; i++) {
+                        ecall_execute_heap_operation(global_eid, &ids[i], &dists[i], phase < 2 ? 2 : 1);
+                    }
+                }
+                double elapsed = Utilities::stopTimer(803);
+                long long stats[2];
+                ecall_get_io_stats(global_eid, 3, stats, 2);
+                printf("%s Average Time: %f\n", phases[phase], elapsed / batchSize);
+                printf("%s Ocalls per Element: %f\n", phases[phase], (double) stats[1] / batchSize);
+            }
+        }
+        sgx_destroy_enclave(global_eid);
+        return 0;
+    }
+    else if (experiment >= 12 && experiment <= 22) {
+        // shared with the native benchmark, e.g. "12 datasets/V13E-256.in 1" for SSSP on a graph file from vertex 1
+        int result = runExperiment(global_eid, maxSize, experiment, vector<string>(argv + min(argc, 4), argv + argc));
+        sgx_destroy_enclave(global_eid);
+        return result;
+    }
 //    ecall_measure_omap_setup_speed(global_eid, &t, maxSize);
 
 
@@ -709,9 +995,9 @@ int SGX_CDECL main(int argc, char *argv[]) {
 //    }
 
     initializeORAM(maxSize, secretkey, rootKey, rootPos, &pairs, &indexes, &ciphertexts, blockCount, storeBlockSize);
-    ocall_setup_ramStore(blockCount, storeBlockSize);
-    ocall_nwrite_ramStore_by_client(&indexes, &ciphertexts);
-    ecall_setup_omap_by_client(global_eid, maxSize, (const char*) rootKey.id.data(), rootPos, (const char*) secretkey.data());
+    int clientStore = ocall_setup_ramStore(blockCount, storeBlockSize);
+    ocall_nwrite_ramStore_by_client(clientStore, &indexes, &ciphertexts);
+    ecall_setup_omap_by_client(global_eid, maxSize, (const char*) rootKey.id.data(), rootPos, (const char*) secretkey.data(), clientStore);
 
     AVL::Node *root = NULL;
     int it = 0;
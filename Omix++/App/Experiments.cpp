@@ -0,0 +1,419 @@
+#include "Experiments.h"
+#include "Enclave_u.h"
+#include "Graph.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+#include <map>
+
+static void toBid(long long key, char* bid) {
+    // Bid stores its least significant byte first in ID_SIZE (10) bytes
+    memset(bid, 0, 10);
+    for (int i = 0; i < 8; i++) {
+        bid[i] = (char) (key >> (i * 8));
+    }
+}
+
+static int intArgument(const vector<string>& args, size_t i, int fallback) {
+    return i < args.size() ? atoi(args[i].c_str()) : fallback;
+}
+
+static double microseconds(chrono::steady_clock::time_point begin) {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - begin).count();
+}
+
+static void streamEdges(sgx_enclave_id_t eid, const Graph& graph) {
+    for (long long i = 0; i < graph.edgeCount(); i += 4096) {
+        size_t count = (size_t) min(4096LL, graph.edgeCount() - i);
+        ecall_stream_graph_edges(eid, graph.sources.data() + i, graph.destinations.data() + i, graph.weights.data() + i, count);
+    }
+}
+
+/**
+ * Streams the graph of args[0] to the enclave: a graph file, read in chunks
+ * so the App never holds all of it, or else the average degree of a random
+ * graph of maxSize vertices
+ * @return number of vertices, 0 if the file cannot be read
+ */
+static int streamGraph(sgx_enclave_id_t eid, const vector<string>& args, int maxSize) {
+    if (!args.empty() && atoi(args[0].c_str()) == 0) {
+        GraphReader reader;
+        if (!reader.open(args[0])) {
+            printf("Cannot read %s\n", args[0].c_str());
+            return 0;
+        }
+        vector<int> sources, destinations, weights;
+        long long edgeCount = 0;
+        size_t count;
+        while ((count = reader.next(4096, sources, destinations, weights)) > 0) {
+            ecall_stream_graph_edges(eid, sources.data(), destinations.data(), weights.data(), count);
+            edgeCount += count;
+        }
+        printf("Vertices: %d Directed Edges: %lld\n", reader.vertexCount(), edgeCount);
+        return reader.vertexCount();
+    }
+    Graph graph;
+    graph.random(maxSize, intArgument(args, 0, 4), 16, 1);
+    printf("Vertices: %d Directed Edges: %lld\n", graph.vertexCount, graph.edgeCount());
+    streamEdges(eid, graph);
+    return graph.vertexCount;
+}
+
+int runExperiment(sgx_enclave_id_t eid, int maxSize, int experiment, const vector<string>& args) {
+    if (experiment == 12 || experiment == 13) {
+        const char* builds[] = {"Insert", "Bulk"};
+        int vertexCount = 0;
+        for (int bulk = experiment == 12 ? 1 : 0; bulk <= 1; bulk++) {
+            vertexCount = streamGraph(eid, args, maxSize);
+            if (vertexCount == 0) {
+                return -1;
+            }
+            double buildTime;
+            ecall_build_graph(eid, vertexCount, bulk, 0, &buildTime);
+            printf("%s Build Time: %f\n", builds[bulk], buildTime);
+        }
+        if (experiment == 12) {
+            vector<long long> distances(vertexCount + 1);
+            double phaseTimes[3];
+            ecall_run_sssp(eid, intArgument(args, 1, 1), distances.data(), distances.size(), phaseTimes);
+            const char* phases[] = {"Heap Setup", "Search", "Collect"};
+            for (int phase = 0; phase < 3; phase++) {
+                printf("%s Time: %f\n", phases[phase], phaseTimes[phase]);
+            }
+        }
+    } else if (experiment == 14) {
+        int accesses = intArgument(args, 0, 100);
+        vector<long long> indexes(accesses);
+        for (int i = 0; i < accesses; i++) {
+            indexes[i] = rand() % maxSize;
+        }
+        ecall_setup_oarray(eid, maxSize);
+        ecall_setup_oram(eid, maxSize);
+        // the IOStats operation of every phase: array, OMAP write, OMAP read
+        const char* phases[] = {"Array Write", "Array Read", "OMAP Write", "OMAP Read"};
+        int operations[] = {5, 5, 1, 0};
+        for (int phase = 0; phase < 4; phase++) {
+            ecall_reset_io_stats(eid);
+            auto begin = chrono::steady_clock::now();
+            for (int i = 0; i < accesses; i++) {
+                char value[16], bid[16];
+                memset(value, 0, sizeof (value));
+                memcpy(value, &indexes[i], sizeof (long long));
+                toBid(indexes[i] + 1, bid);
+                if (phase == 0) {
+                    ecall_write_oarray(eid, indexes[i], value);
+                } else if (phase == 1) {
+                    ecall_read_oarray(eid, indexes[i], value);
+                } else if (phase == 2) {
+                    ecall_write_node(eid, bid, value);
+                } else {
+                    ecall_read_node(eid, bid, value);
+                }
+            }
+            double elapsed = microseconds(begin);
+            long long stats[5];
+            ecall_get_io_stats(eid, operations[phase], stats, 5);
+            printf("%s Average Time: %f\n", phases[phase], elapsed / accesses);
+            printf("%s Buckets Read per Access: %f\n", phases[phase], (double) stats[4] / accesses);
+        }
+    } else if (experiment == 15) {
+        int count = min(intArgument(args, 0, 64), maxSize);
+        ecall_setup_oqueue(eid, maxSize);
+        ecall_setup_ostack(eid, maxSize);
+        ecall_setup_oheap(eid, maxSize, 0);
+        // DOHEAP serves as a queue with the push order as the key
+        const char* structures[] = {"Queue", "Stack", "Heap"};
+        int operations[] = {5, 5, 3};
+        for (int s = 0; s < 3; s++) {
+            for (int phase = 0; phase < 2; phase++) {
+                ecall_reset_io_stats(eid);
+                auto begin = chrono::steady_clock::now();
+                for (int i = 0; i < count; i++) {
+                    int value = i + 1, order = i, done;
+                    int op = phase == 0 ? 2 : 1;
+                    if (s == 0) {
+                        ecall_execute_queue_operation(eid, &done, &value, op);
+                    } else if (s == 1) {
+                        ecall_execute_stack_operation(eid, &done, &value, op);
+                    } else {
+                        ecall_execute_heap_operation(eid, &value, &order, op);
+                    }
+                }
+                double elapsed = microseconds(begin);
+                long long stats[2];
+                ecall_get_io_stats(eid, operations[s], stats, 2);
+                printf("%s %s Average Time: %f\n", structures[s], phase == 0 ? "Push" : "Pop", elapsed / count);
+                printf("%s %s Ocalls per Element: %f\n", structures[s], phase == 0 ? "Push" : "Pop", (double) stats[1] / count);
+            }
+        }
+    } else if (experiment == 16) {
+        int vertexCount = streamGraph(eid, args, maxSize);
+        if (vertexCount == 0) {
+            return -1;
+        }
+        int rounds = intArgument(args, 1, 0);
+        ecall_build_edge_list(eid, vertexCount);
+        vector<long long> labels(vertexCount + 1);
+        double time;
+        ecall_run_bfs(eid, 1, rounds, labels.data(), labels.size(), &time);
+        printf("BFS Time: %f\n", time);
+        ecall_run_components(eid, rounds, labels.data(), labels.size(), &time);
+        printf("Components Time: %f\n", time);
+    } else if (experiment == 17) {
+        stringstream list(args.size() > 0 ? args[0] : "64,128,256");
+        int iterations = intArgument(args, 1, 10);
+        string item;
+        while (getline(list, item, ',')) {
+            Graph graph;
+            graph.random(atoi(item.c_str()), 4, 1, 1);
+            printf("Vertices: %d Directed Edges: %lld\n", graph.vertexCount, graph.edgeCount());
+            streamEdges(eid, graph);
+            double buildTime, iterationTime;
+            ecall_build_pagerank_graph(eid, graph.vertexCount, &buildTime);
+            vector<double> ranks(graph.vertexCount + 1);
+            ecall_run_pagerank(eid, iterations, 0.85, ranks.data(), ranks.size(), &iterationTime);
+            printf("Build Time: %f\n", buildTime);
+            printf("Iteration Time: %f\n", iterationTime);
+        }
+    } else if (experiment == 18) {
+        // both builds consume the streamed edges
+        int vertexCount = 0;
+        for (int strategy = 0; strategy < 2; strategy++) {
+            vertexCount = streamGraph(eid, args, maxSize);
+            if (vertexCount == 0) {
+                return -1;
+            }
+            double buildTime;
+            if (strategy == 0) {
+                ecall_build_graph(eid, vertexCount, 1, 0, &buildTime);
+            } else {
+                ecall_build_edge_list(eid, vertexCount);
+            }
+        }
+        const char* strategies[] = {"Prim", "Boruvka"};
+        for (int strategy = 0; strategy < 2; strategy++) {
+            vector<int> sources(vertexCount), destinations(vertexCount), weights(vertexCount);
+            long long totalWeight;
+            int edgeCount;
+            double time;
+            ecall_run_mst(eid, strategy, &totalWeight, sources.data(), destinations.data(), weights.data(), sources.size(), &edgeCount, &time);
+            printf("%s Time: %f\n", strategies[strategy], time);
+            printf("%s Total Weight: %lld Edges: %d\n", strategies[strategy], totalWeight, edgeCount);
+        }
+    } else if (experiment == 19) {
+        int updates = intArgument(args, 0, 32);
+        Graph graph;
+        graph.random(maxSize, 4, 16, 1);
+        graph.simplify();
+        printf("Vertices: %d Directed Edges: %lld\n", graph.vertexCount, graph.edgeCount());
+        streamEdges(eid, graph);
+        double buildTime;
+        ecall_build_graph(eid, graph.vertexCount, 1, 2LL * updates, &buildTime);
+        // every other update removes an existing edge, the others add or reweight a random one, both directions each
+        vector<int> sources, destinations, weights, removes;
+        for (int i = 0; i < updates; i++) {
+            bool remove = i % 2 == 0 && graph.edgeCount() > 0;
+            int s, d, weight = rand() % 16 + 1;
+            if (remove) {
+                size_t edge = rand() % graph.edgeCount();
+                s = graph.sources[edge];
+                d = graph.destinations[edge];
+            } else {
+                s = rand() % graph.vertexCount + 1;
+                d = (s + rand() % (graph.vertexCount - 1)) % graph.vertexCount + 1;
+            }
+            graph.update(s, d, weight, remove);
+            int ends[] = {s, d};
+            for (int direction = 0; direction < 2; direction++) {
+                sources.push_back(ends[direction]);
+                destinations.push_back(ends[1 - direction]);
+                weights.push_back(weight);
+                removes.push_back(remove);
+            }
+        }
+        // the first half goes one ecall per update, the second half in one batch
+        size_t half = sources.size() / 2;
+        long long edgeCount = 0;
+        for (int phase = 0; phase < 2; phase++) {
+            ecall_reset_io_stats(eid);
+            auto begin = chrono::steady_clock::now();
+            if (phase == 0) {
+                for (size_t i = 0; i < half; i++) {
+                    if (removes[i]) {
+                        ecall_remove_graph_edge(eid, sources[i], destinations[i]);
+                    } else {
+                        ecall_add_graph_edge(eid, sources[i], destinations[i], weights[i]);
+                    }
+                }
+            } else {
+                ecall_update_graph_edges(eid, &edgeCount, sources.data() + half, destinations.data() + half, weights.data() + half, removes.data() + half, sources.size() - half);
+            }
+            double elapsed = microseconds(begin);
+            long long reads[6], writes[6];
+            ecall_get_io_stats(eid, 0, reads, 6);
+            ecall_get_io_stats(eid, 1, writes, 6);
+            size_t count = phase == 0 ? half : sources.size() - half;
+            printf("%s Average Time: %f\n", phase == 0 ? "Single Update" : "Batched Update", elapsed / count);
+            printf("%s Buckets Written per Update: %f\n", phase == 0 ? "Single Update" : "Batched Update", (double) (reads[5] + writes[5]) / count);
+        }
+        printf("Directed Edges after Updates: %lld\n", edgeCount);
+    } else if (experiment == 20) {
+        int keys = intArgument(args, 0, 8);
+        int values = intArgument(args, 1, 8);
+        ecall_setup_omultimap(eid, (long long) keys * values, values);
+        ecall_setup_oram(eid, keys * values);
+        map<int, vector<long long> > stored;
+        char bid[16];
+        int done;
+        for (int k = 1; k <= keys; k++) {
+            for (int i = 0; i < values; i++) {
+                long long value = rand() % 1000 + 1;
+                char node[16];
+                memset(node, 0, sizeof (node));
+                memcpy(node, &value, sizeof (value));
+                toBid(k, bid);
+                ecall_multimap_append(eid, &done, bid, value);
+                // the OMAP needs one key per value, key * values + i
+                toBid((long long) k * values + i, bid);
+                ecall_write_node(eid, bid, node);
+                stored[k].push_back(value);
+            }
+        }
+        // every get fetches all values of one key, the second round after half of them are removed from
+        // both ends of the chains and replaced by values in the freed slots
+        for (int round = 0; round < 2; round++) {
+            for (int s = 0; s < 2; s++) {
+                ecall_reset_io_stats(eid);
+                auto begin = chrono::steady_clock::now();
+                for (int k = 1; k <= keys; k++) {
+                    vector<long long> found(values, 0);
+                    if (s == 0) {
+                        int count;
+                        toBid(k, bid);
+                        ecall_multimap_get(eid, &count, bid, found.data(), found.size());
+                    } else {
+                        for (int i = 0; i < values; i++) {
+                            char res[16];
+                            toBid((long long) k * values + i, bid);
+                            ecall_read_node(eid, bid, res);
+                        }
+                    }
+                }
+                double elapsed = microseconds(begin);
+                long long stats[5];
+                ecall_get_io_stats(eid, s == 0 ? 6 : 0, stats, 5);
+                printf("%s Get Average Time: %f\n", s == 0 ? "Multimap" : "OMAP", elapsed / keys);
+                printf("%s Buckets Read per Get: %f\n", s == 0 ? "Multimap" : "OMAP", (double) stats[4] / keys);
+            }
+            if (round == 0) {
+                for (int k = 1; k <= keys; k++) {
+                    toBid(k, bid);
+                    for (int i = 0; i < values / 2; i++) {
+                        vector<long long>::iterator it = i % 2 == 0 ? stored[k].end() - 1 : stored[k].begin();
+                        ecall_multimap_remove(eid, &done, bid, *it);
+                        stored[k].erase(it);
+                    }
+                    for (int i = 0; i < values / 2; i++) {
+                        ecall_multimap_append(eid, &done, bid, rand() % 1000 + 1);
+                    }
+                }
+            }
+        }
+    } else if (experiment == 21) {
+        int chunkSize = intArgument(args, 0, 64);
+        int maxBytes = intArgument(args, 1, 320);
+        int maxChunks = (maxBytes + chunkSize - 1) / chunkSize;
+        ecall_setup_blob_store(eid, maxSize, (long long) maxSize * maxChunks, chunkSize, maxChunks);
+        ecall_setup_oram(eid, maxSize);
+        vector<char> buffer(maxBytes);
+        char bid[16];
+        int result;
+        // the second round gives every key a new length, so chains shrink, grow and take freed chunks
+        for (int round = 0; round < 2; round++) {
+            ecall_reset_io_stats(eid);
+            auto begin = chrono::steady_clock::now();
+            for (int k = 1; k <= maxSize; k++) {
+                string value(rand() % (maxBytes + 1), '\0');
+                for (size_t i = 0; i < value.size(); i++) {
+                    value[i] = (char) (rand() % 256);
+                }
+                toBid(k, bid);
+                ecall_write_blob(eid, &result, bid, value.data(), value.size());
+            }
+            double elapsed = microseconds(begin);
+            long long stats[6];
+            ecall_get_io_stats(eid, 7, stats, 6);
+            printf("Blob Write Average Time: %f\n", elapsed / maxSize);
+            printf("Blob Buckets Read and Written per Write: %f\n", (double) (stats[4] + stats[5]) / maxSize);
+
+            ecall_reset_io_stats(eid);
+            begin = chrono::steady_clock::now();
+            for (int k = 1; k <= maxSize; k++) {
+                toBid(k, bid);
+                ecall_read_blob(eid, &result, bid, buffer.data(), buffer.size());
+            }
+            elapsed = microseconds(begin);
+            ecall_get_io_stats(eid, 7, stats, 5);
+            printf("Blob Read Average Time: %f\n", elapsed / maxSize);
+            printf("Blob Buckets Read per Read: %f\n", (double) stats[4] / maxSize);
+            printf("Blob Bytes Read per Read: %f\n", (double) stats[2] / maxSize);
+        }
+
+        for (int k = 1; k <= maxSize; k++) {
+            char node[16] = {0};
+            toBid(k, bid);
+            ecall_write_node(eid, bid, node);
+        }
+        ecall_reset_io_stats(eid);
+        auto begin = chrono::steady_clock::now();
+        for (int k = 1; k <= maxSize; k++) {
+            char res[16];
+            toBid(k, bid);
+            ecall_read_node(eid, bid, res);
+        }
+        double elapsed = microseconds(begin);
+        long long stats[5];
+        ecall_get_io_stats(eid, 0, stats, 5);
+        printf("OMAP Read Average Time: %f\n", elapsed / maxSize);
+        printf("OMAP Buckets Read per Read: %f\n", (double) stats[4] / maxSize);
+        printf("OMAP Bytes Read per Read: %f\n", (double) stats[2] / maxSize);
+    } else if (experiment == 22) {
+        int count = maxSize / 2;
+        ecall_setup_oheap(eid, maxSize, 1);
+        vector<int> keys(count + 1);
+        int decreases = 0;
+        double decreaseTime = 0;
+        auto decrease = [&](int id, int key) {
+            // the ecall overwrites both arguments
+            int value = id, dist = key;
+            auto begin = chrono::steady_clock::now();
+            ecall_execute_heap_operation(eid, &value, &dist, 4);
+            decreaseTime += microseconds(begin);
+            decreases++;
+        };
+        // every other element is decreased as soon as it is in, so it is often still in the stash
+        for (int id = 1; id <= count; id++) {
+            int value = id, key = 1000 + rand() % 1000;
+            keys[id] = key;
+            ecall_execute_heap_operation(eid, &value, &key, 2);
+            if (id % 2 == 0) {
+                decrease(id, keys[id] - 500);
+            }
+        }
+        // lower and higher keys, then missing ids and ids past maxSize
+        for (int id = 1; id <= count; id += 2) {
+            decrease(id, id % 4 == 1 ? keys[id] - 700 : keys[id] + 5000);
+        }
+        for (int id = count + 1; id <= maxSize + 4; id++) {
+            decrease(id, 1);
+        }
+        printf("Decrease Average Time: %f\n", decreaseTime / decreases);
+    } else {
+        printf("Unknown experiment %d\n", experiment);
+        return -1;
+    }
+    return 0;
+}
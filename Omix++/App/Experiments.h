@@ -0,0 +1,42 @@
+#ifndef EXPERIMENTS_H
+#define EXPERIMENTS_H
+
+#include <string>
+#include <vector>
+#include "sgx_eid.h"
+
+using namespace std;
+
+/**
+ * Experiments 12-22, shared by the App and the native benchmark. They call
+ * the ecalls as the App does, the native build maps those calls to the
+ * enclave code linked in. Results are checked by make native-test, the
+ * experiments only measure.
+ *
+ *  12: oblivious SSSP, [graph=4] [source=1] follow the experiment, graph is
+ *      a graph file or the average degree of a random graph of maxSize vertices
+ *  13: graph ingestion with one OMAP insert per entry against the bulk build, [graph=4]
+ *  14: oblivious array against OMAP for integer keys, [accesses=100]
+ *  15: oblivious queue and stack against DOHEAP used as a queue, [count=64]
+ *  16: sort-and-scan BFS and connected components, [graph=4] [rounds], rounds pads
+ *      the propagation to that many rounds instead of maxSize - 1
+ *  17: sort-and-scan PageRank over an encrypted untrusted edge store on random graphs of
+ *      average degree 4, [sizeList=64,128,256] [iterations=10]
+ *  18: minimum spanning forest by Prim over DOHEAP and by sort-and-scan Borůvka, [graph=4]
+ *  19: edge additions and removals on the adjacency OMAP of a random graph of average
+ *      degree 4, one ecall per update against batches, [updates=32]
+ *  20: oblivious multimap against one OMAP find per value under composite keys,
+ *      [keys=8] [values=8]
+ *  21: values of up to a few hundred bytes in chunks of a blob ORAM for maxSize keys, written
+ *      twice with random lengths and read back, against OMAP reads of 16 byte values,
+ *      [chunkSize=64] [maxBytes=320]
+ *  22: DOHEAP decrease-key to a lower and a higher key, of missing and untracked ids and of
+ *      elements right after their insert
+ *
+ * @param args the arguments after the experiment number
+ * @return exit code of the driver, -1 if experiment is not one of these or
+ * its input cannot be read
+ */
+int runExperiment(sgx_enclave_id_t eid, int maxSize, int experiment, const vector<string>& args);
+
+#endif /* EXPERIMENTS_H */
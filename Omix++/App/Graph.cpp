@@ -0,0 +1,279 @@
+#include "Graph.h"
+#include <sstream>
+#include <queue>
+#include <random>
+#include <functional>
+#include <algorithm>
+#include <set>
+
+int GraphReader::vertex(long long name) {
+    map<long long, int>::iterator it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    int id = (int) ids.size() + 1;
+    ids[name] = id;
+    return id;
+}
+
+bool GraphReader::open(string file) {
+    in.open(file.c_str());
+    ids.clear();
+    return (bool) in;
+}
+
+size_t GraphReader::next(size_t count, vector<int>& sources, vector<int>& destinations, vector<int>& weights) {
+    sources.clear();
+    destinations.clear();
+    weights.clear();
+    string line;
+    while (sources.size() < count && getline(in, line)) {
+        stringstream row(line);
+        long long source, destination;
+        int flag, weight = 1;
+        if (!(row >> source >> destination >> flag)) {
+            continue;
+        }
+        row >> weight;
+        if (flag == 1) {
+            vertex(source);
+            continue;
+        }
+        int s = vertex(source);
+        int d = vertex(destination);
+        sources.push_back(s);
+        destinations.push_back(d);
+        weights.push_back(weight);
+        sources.push_back(d);
+        destinations.push_back(s);
+        weights.push_back(weight);
+    }
+    return sources.size();
+}
+
+int GraphReader::vertexCount() const {
+    return (int) ids.size();
+}
+
+bool Graph::read(string file) {
+    GraphReader reader;
+    if (!reader.open(file)) {
+        return false;
+    }
+    vector<int> s, d, w;
+    while (reader.next(1 << 16, s, d, w) > 0) {
+        sources.insert(sources.end(), s.begin(), s.end());
+        destinations.insert(destinations.end(), d.begin(), d.end());
+        weights.insert(weights.end(), w.begin(), w.end());
+    }
+    vertexCount = reader.vertexCount();
+    return true;
+}
+
+void Graph::random(int vertexCount, int degree, int maxWeight, unsigned long long seed) {
+    mt19937_64 rng(seed);
+    this->vertexCount = vertexCount;
+    sources.clear();
+    destinations.clear();
+    weights.clear();
+    for (long long i = 0; i < (long long) vertexCount * degree / 2; i++) {
+        int s = (int) (rng() % vertexCount) + 1;
+        int d = (int) (rng() % vertexCount) + 1;
+        int weight = (int) (rng() % maxWeight) + 1;
+        sources.push_back(s);
+        destinations.push_back(d);
+        weights.push_back(weight);
+        sources.push_back(d);
+        destinations.push_back(s);
+        weights.push_back(weight);
+    }
+}
+
+long long Graph::edgeCount() const {
+    return (long long) sources.size();
+}
+
+void Graph::simplify() {
+    set<pair<int, int> > seen;
+    size_t kept = 0;
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (sources[i] != destinations[i] && seen.insert(make_pair(sources[i], destinations[i])).second) {
+            sources[kept] = sources[i];
+            destinations[kept] = destinations[i];
+            weights[kept] = weights[i];
+            kept++;
+        }
+    }
+    sources.resize(kept);
+    destinations.resize(kept);
+    weights.resize(kept);
+}
+
+void Graph::update(int s, int d, int weight, bool remove) {
+    size_t kept = 0;
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (!((sources[i] == s && destinations[i] == d) || (sources[i] == d && destinations[i] == s))) {
+            sources[kept] = sources[i];
+            destinations[kept] = destinations[i];
+            weights[kept] = weights[i];
+            kept++;
+        }
+    }
+    sources.resize(kept);
+    destinations.resize(kept);
+    weights.resize(kept);
+    if (!remove) {
+        sources.push_back(s);
+        destinations.push_back(d);
+        weights.push_back(weight);
+        sources.push_back(d);
+        destinations.push_back(s);
+        weights.push_back(weight);
+    }
+}
+
+vector<long long> Graph::shortestPaths(int source) const {
+    vector<vector<pair<int, int> > > adjacency(vertexCount + 1);
+    for (size_t i = 0; i < sources.size(); i++) {
+        adjacency[sources[i]].push_back(make_pair(destinations[i], weights[i]));
+    }
+    vector<long long> dist(vertexCount + 1, -1);
+    priority_queue<pair<long long, int>, vector<pair<long long, int> >, greater<pair<long long, int> > > queue;
+    dist[source] = 0;
+    queue.push(make_pair(0LL, source));
+    while (!queue.empty()) {
+        pair<long long, int> top = queue.top();
+        queue.pop();
+        if (top.first > dist[top.second]) {
+            continue;
+        }
+        for (pair<int, int> edge : adjacency[top.second]) {
+            long long candidate = top.first + edge.second;
+            if (dist[edge.first] == -1 || candidate < dist[edge.first]) {
+                dist[edge.first] = candidate;
+                queue.push(make_pair(candidate, edge.first));
+            }
+        }
+    }
+    return dist;
+}
+
+vector<long long> Graph::hops(int source) const {
+    vector<vector<int> > adjacency(vertexCount + 1);
+    for (size_t i = 0; i < sources.size(); i++) {
+        adjacency[sources[i]].push_back(destinations[i]);
+    }
+    vector<long long> hops(vertexCount + 1, -1);
+    queue<int> frontier;
+    hops[source] = 0;
+    frontier.push(source);
+    while (!frontier.empty()) {
+        int u = frontier.front();
+        frontier.pop();
+        for (int w : adjacency[u]) {
+            if (hops[w] == -1) {
+                hops[w] = hops[u] + 1;
+                frontier.push(w);
+            }
+        }
+    }
+    return hops;
+}
+
+vector<long long> Graph::components() const {
+    vector<vector<int> > adjacency(vertexCount + 1);
+    for (size_t i = 0; i < sources.size(); i++) {
+        adjacency[sources[i]].push_back(destinations[i]);
+        adjacency[destinations[i]].push_back(sources[i]);
+    }
+    vector<long long> labels(vertexCount + 1, 0);
+    for (int v = 1; v <= vertexCount; v++) {
+        if (labels[v] != 0) {
+            continue;
+        }
+        // vertices are visited in increasing order, so v is the smallest id of its component
+        vector<int> stack(1, v);
+        labels[v] = v;
+        while (!stack.empty()) {
+            int u = stack.back();
+            stack.pop_back();
+            for (int w : adjacency[u]) {
+                if (labels[w] == 0) {
+                    labels[w] = v;
+                    stack.push_back(w);
+                }
+            }
+        }
+    }
+    return labels;
+}
+
+long long Graph::spanningForestWeight() const {
+    vector<pair<int, size_t> > order;
+    for (size_t i = 0; i < sources.size(); i++) {
+        order.push_back(make_pair(weights[i], i));
+    }
+    sort(order.begin(), order.end());
+    vector<int> parent(vertexCount + 1);
+    for (int v = 0; v <= vertexCount; v++) {
+        parent[v] = v;
+    }
+    function<int(int) > root = [&](int v) {
+        return parent[v] == v ? v : parent[v] = root(parent[v]);
+    };
+    long long total = 0;
+    for (pair<int, size_t> edge : order) {
+        int s = root(sources[edge.second]), d = root(destinations[edge.second]);
+        if (s != d) {
+            parent[s] = d;
+            total += edge.first;
+        }
+    }
+    return total;
+}
+
+int Graph::forestErrors(const vector<int>& sources, const vector<int>& destinations, const vector<int>& weights, long long totalWeight) const {
+    vector<int> parent(vertexCount + 1);
+    for (int v = 0; v <= vertexCount; v++) {
+        parent[v] = v;
+    }
+    function<int(int) > root = [&](int v) {
+        return parent[v] == v ? v : parent[v] = root(parent[v]);
+    };
+    int errors = 0;
+    long long sum = 0;
+    for (size_t i = 0; i < sources.size(); i++) {
+        int s = root(sources[i]), d = root(destinations[i]);
+        errors += s == d;
+        parent[s] = d;
+        sum += weights[i];
+    }
+    vector<long long> labels = components();
+    long long trees = 0;
+    for (int v = 1; v <= vertexCount; v++) {
+        trees += labels[v] == v;
+    }
+    errors += sum != totalWeight;
+    errors += totalWeight != spanningForestWeight();
+    errors += (long long) sources.size() != vertexCount - trees;
+    return errors;
+}
+
+vector<double> Graph::pageRank(int iterations, double damping) const {
+    vector<long long> degree(vertexCount + 1, 0);
+    for (size_t i = 0; i < sources.size(); i++) {
+        degree[sources[i]]++;
+    }
+    vector<double> ranks(vertexCount + 1, 1.0 / vertexCount);
+    ranks[0] = 0;
+    for (int iteration = 0; iteration < max(iterations, 1); iteration++) {
+        vector<double> sums(vertexCount + 1, 0);
+        for (size_t i = 0; i < sources.size(); i++) {
+            sums[destinations[i]] += ranks[sources[i]] / degree[sources[i]];
+        }
+        for (int v = 1; v <= vertexCount; v++) {
+            ranks[v] = (1 - damping) / vertexCount + damping * sums[v];
+        }
+    }
+    return ranks;
+}
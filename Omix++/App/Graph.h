@@ -0,0 +1,103 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+
+using namespace std;
+
+/**
+ * Reads a graph file of the format below in chunks, so the edges never have
+ * to be held by the App at once. Only the renumbering of the vertices is
+ * kept.
+ */
+class GraphReader {
+private:
+    ifstream in;
+    map<long long, int> ids;
+
+    int vertex(long long name);
+
+public:
+    /**
+     * @return false if the file cannot be opened
+     */
+    bool open(string file);
+    /**
+     * Reads edges until count directed edges are collected or the file ends
+     * @return number of directed edges read, 0 at the end of the file
+     */
+    size_t next(size_t count, vector<int>& sources, vector<int>& destinations, vector<int>& weights);
+    /**
+     * vertices seen so far, all of them once next returned 0
+     */
+    int vertexCount() const;
+};
+
+/**
+ * An undirected graph as described in the README: one "source destination
+ * flag" line per vertex (flag 1) or edge (flag 0), with an optional fourth
+ * column for the weight of an edge (1 if absent). Vertices are renumbered
+ * 1..vertexCount in order of appearance and every edge is kept in both
+ * directions.
+ */
+class Graph {
+public:
+    int vertexCount = 0;
+    vector<int> sources, destinations, weights;
+
+    /**
+     * @return false if the file cannot be opened
+     */
+    bool read(string file);
+    /**
+     * degree edges per vertex on average between uniformly chosen vertices
+     */
+    void random(int vertexCount, int degree, int maxWeight, unsigned long long seed);
+    long long edgeCount() const;
+    /**
+     * Drops self-loops and all but the first of parallel edges, so an edge
+     * is named by its ends as edge updates need
+     */
+    void simplify();
+    /**
+     * Removes both directions of the edge between s and d, and adds them
+     * back with the given weight unless remove is set
+     */
+    void update(int s, int d, int weight, bool remove);
+    /**
+     * Plain Dijkstra to check the enclave results
+     * @return distance of every vertex id 0..vertexCount, -1 if it is unreachable
+     */
+    vector<long long> shortestPaths(int source) const;
+    /**
+     * Plain BFS to check the enclave results
+     * @return hops from source of every vertex id 0..vertexCount, -1 if it is unreachable
+     */
+    vector<long long> hops(int source) const;
+    /**
+     * @return smallest vertex id of the component of every vertex id 1..vertexCount
+     */
+    vector<long long> components() const;
+    /**
+     * Plain Kruskal to check the enclave results
+     * @return weight of a minimum spanning forest
+     */
+    long long spanningForestWeight() const;
+    /**
+     * Checks a spanning forest computed by the enclave
+     * @return edges that close a cycle, plus one each if the edges do not add
+     *         up to totalWeight, it is not minimal or trees are not spanned
+     */
+    int forestErrors(const vector<int>& sources, const vector<int>& destinations, const vector<int>& weights, long long totalWeight) const;
+    /**
+     * Plain PageRank without redistributing the rank of vertices with no
+     * out-edges, as the enclave computes it
+     * @return rank of every vertex id 0..vertexCount
+     */
+    vector<double> pageRank(int iterations, double damping) const;
+};
+
+#endif /* GRAPH_H */
@@ -9,6 +9,11 @@ using namespace std;
 using byte_t = uint8_t;
 using block = std::vector<byte_t>;
 
+/*
+ * The blocks are allocated up front, so reads and writes of different
+ * positions may run in parallel. A simulation store keeps a single block and
+ * is meant for one thread only.
+ */
 class RAMStore {
     std::vector<block> store;
     
@@ -1,136 +1,209 @@
 #ifndef RAMSTOREENCLAVEINTERFACE_H
 #define RAMSTOREENCLAVEINTERFACE_H
+#include <atomic>
+#include <mutex>
 #include "RAMStore.hpp"
 #include "Utilities.h"
 
-static RAMStore* store = NULL;
-RAMStore* heapStore = NULL;
+// Stores that can be set up by one process (ORAMs, heaps and shards)
+#define MAX_STORES 64
+
+/*
+ * Every ORAM gets its own store, addressed by the handle returned from the
+ * setup ocall and given back by the release ocall when the ORAM is deleted.
+ * Setup and release are serialised and take the lowest free slot, a slot is
+ * only written while no handle to it is out so lookups need no lock, and
+ * the stores are preallocated so that threads working on disjoint buckets
+ * can read and write them concurrently.
+ */
+static RAMStore* stores[MAX_STORES];
+static std::mutex storeSetupLock;
+
+/* Traffic seen by the store ocall handlers, to cross-check the enclave's own accounting */
+static std::atomic<long long> storeOcalls(0);
+static std::atomic<long long> storeBytesReceived(0);
+static std::atomic<long long> storeBytesSent(0);
+
+/**
+ * @return handle of the new store, -1 if MAX_STORES are in use
+ */
+static int setupStore(size_t num, size_t size, bool simulation) {
+    std::lock_guard<std::mutex> guard(storeSetupLock);
+    for (int handle = 0; handle < MAX_STORES; handle++) {
+        if (stores[handle] == NULL) {
+            stores[handle] = new RAMStore(num, size, simulation);
+            return handle;
+        }
+    }
+    return -1;
+}
 
-void ocall_setup_heapStore(size_t num, int size) {
-    if (heapStore == NULL) {
-        heapStore = new RAMStore(num, num, false);
+/**
+ * A handle the enclave never got from setup or already released is a bug
+ * on its side, and going on would read or write some other ORAM's buckets
+ */
+static RAMStore* storeAt(int store) {
+    if (store < 0 || store >= MAX_STORES || stores[store] == NULL) {
+        fprintf(stderr, "invalid store handle %d\n", store);
+        abort();
     }
+    return stores[store];
+}
+
+void ocall_release_store(int store) {
+    std::lock_guard<std::mutex> guard(storeSetupLock);
+    delete storeAt(store);
+    stores[store] = NULL;
 }
 
-void ocall_nwrite_heapStore(size_t blockCount, long long* indexes, const char *blk, size_t len) {
+int ocall_setup_heapStore(size_t num, int size) {
+    return setupStore(num, num, false);
+}
+
+void ocall_nwrite_heapStore(int store, size_t blockCount, long long* indexes, const char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += blockCount * sizeof (long long) + len;
     assert(len % blockCount == 0);
     size_t eachSize = len / blockCount;
     for (unsigned int i = 0; i < blockCount; i++) {
         block ciphertext(blk + (i * eachSize), blk + (i + 1) * eachSize);
-        heapStore->Write(indexes[i], ciphertext);
+        storeAt(store)->Write(indexes[i], ciphertext);
     }
 }
 
-size_t ocall_nread_heapStore(size_t blockCount, long long* indexes, char *blk, size_t len) {
+size_t ocall_nread_heapStore(int store, size_t blockCount, long long* indexes, char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += blockCount * sizeof (long long);
+    storeBytesSent += len;
     assert(len % blockCount == 0);
     size_t resLen = -1;
     for (unsigned int i = 0; i < blockCount; i++) {
-        block ciphertext = heapStore->Read(indexes[i]);
+        block ciphertext = storeAt(store)->Read(indexes[i]);
         resLen = ciphertext.size();
         std::memcpy(blk + i * resLen, ciphertext.data(), ciphertext.size());
     }
     return resLen;
 }
 
-void ocall_initialize_heapStore(long long begin, long long end, const char *blk, size_t len) {
+void ocall_initialize_heapStore(int store, long long begin, long long end, const char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += 2 * sizeof (long long) + len;
     block ciphertext(blk, blk + len);
     for (long long i = begin; i < end; i++) {
-        heapStore->Write(i, ciphertext);
+        storeAt(store)->Write(i, ciphertext);
     }
 }
 
-void ocall_write_heapStore(long long index, const char *blk, size_t len) {
+void ocall_write_heapStore(int store, long long index, const char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += sizeof (long long) + len;
     block ciphertext(blk, blk + len);
-    heapStore->Write(index, ciphertext);
+    storeAt(store)->Write(index, ciphertext);
 }
 
-void ocall_setup_ramStore(size_t num, int size) {
-    if (store == NULL) {
-        if (size != -1) {
-            store = new RAMStore(num, size, false);
-        } else {
-            store = new RAMStore(num, size, true);
-        }
+int ocall_setup_ramStore(size_t num, int size) {
+    if (size != -1) {
+        return setupStore(num, size, false);
+    } else {
+        return setupStore(num, size, true);
     }
 }
 
-void ocall_nwrite_ramStore(size_t blockCount, long long* indexes, const char *blk, size_t len) {
+void ocall_nwrite_ramStore(int store, size_t blockCount, long long* indexes, const char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += blockCount * sizeof (long long) + len;
     assert(len % blockCount == 0);
     size_t eachSize = len / blockCount;
     for (unsigned int i = 0; i < blockCount; i++) {
         block ciphertext(blk + (i * eachSize), blk + (i + 1) * eachSize);
-        store->Write(indexes[i], ciphertext);
+        storeAt(store)->Write(indexes[i], ciphertext);
     }
 }
 
-void ocall_write_rawRamStore(long long index, const char *blk, size_t len) {
+void ocall_write_rawRamStore(int store, long long index, const char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += sizeof (long long) + len;
     size_t eachSize = len;
     block ciphertext(blk, blk + eachSize);
-    store->WriteRawStore(index, ciphertext);
+    storeAt(store)->WriteRawStore(index, ciphertext);
 }
 
-void ocall_nwrite_rawRamStore(size_t blockCount, long long* indexes, const char *blk, size_t len) {
+void ocall_nwrite_rawRamStore(int store, size_t blockCount, long long* indexes, const char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += blockCount * sizeof (long long) + len;
     assert(len % blockCount == 0);
     size_t eachSize = len / blockCount;
     for (unsigned int i = 0; i < blockCount; i++) {
         block ciphertext(blk + (i * eachSize), blk + (i + 1) * eachSize);
-        store->WriteRawStore(indexes[i], ciphertext);
+        storeAt(store)->WriteRawStore(indexes[i], ciphertext);
     }
 }
 
-void ocall_nwrite_ramStore_by_client(vector<long long>* indexes, vector<block>* ciphertexts) {
+void ocall_nwrite_ramStore_by_client(int store, vector<long long>* indexes, vector<block>* ciphertexts) {
     for (unsigned int i = 0; i < (*indexes).size(); i++) {
-        store->Write((*indexes)[i], (*ciphertexts)[i]);
+        storeAt(store)->Write((*indexes)[i], (*ciphertexts)[i]);
     }
 }
 
-void ocall_nwrite_raw_ramStore(vector<block>* ciphertexts) {
+void ocall_nwrite_raw_ramStore(int store, vector<block>* ciphertexts) {
     for (unsigned int i = 0; i < (*ciphertexts).size(); i++) {
-        store->WriteRawStore(i, (*ciphertexts)[i]);
+        storeAt(store)->WriteRawStore(i, (*ciphertexts)[i]);
     }
 }
 
-size_t ocall_nread_ramStore(size_t blockCount, long long* indexes, char *blk, size_t len) {
+size_t ocall_nread_ramStore(int store, size_t blockCount, long long* indexes, char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += blockCount * sizeof (long long);
+    storeBytesSent += len;
     assert(len % blockCount == 0);
     size_t resLen = -1;
     for (unsigned int i = 0; i < blockCount; i++) {
-        block ciphertext = store->Read(indexes[i]);
+        block ciphertext = storeAt(store)->Read(indexes[i]);
         resLen = ciphertext.size();
         std::memcpy(blk + i * resLen, ciphertext.data(), ciphertext.size());
     }
     return resLen;
 }
 
-size_t ocall_read_rawRamStore(size_t index, char *blk, size_t len) {
+size_t ocall_read_rawRamStore(int store, size_t index, char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += sizeof (size_t);
+    storeBytesSent += len;
     size_t resLen = -1;
-    block ciphertext = store->ReadRawStore(index);
+    block ciphertext = storeAt(store)->ReadRawStore(index);
     resLen = ciphertext.size();
     std::memcpy(blk, ciphertext.data(), ciphertext.size());
     return resLen;
 }
 
-size_t ocall_nread_rawRamStore(size_t blockCount, size_t begin, char *blk, size_t len) {
+size_t ocall_nread_rawRamStore(int store, size_t blockCount, size_t begin, char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += 2 * sizeof (size_t);
+    storeBytesSent += len;
     assert(len % blockCount == 0);
     size_t resLen = -1;
-    size_t rawSize = store->tmpstore.size();
+    size_t rawSize = storeAt(store)->tmpstore.size();
     for (unsigned int i = 0; i < blockCount && (begin + i) < rawSize; i++) {
-        block ciphertext = store->ReadRawStore(i + begin);
+        block ciphertext = storeAt(store)->ReadRawStore(i + begin);
         resLen = ciphertext.size();
         std::memcpy(blk + i * resLen, ciphertext.data(), ciphertext.size());
     }
     return resLen;
 }
 
-void ocall_initialize_ramStore(long long begin, long long end, const char *blk, size_t len) {
+void ocall_initialize_ramStore(int store, long long begin, long long end, const char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += 2 * sizeof (long long) + len;
     block ciphertext(blk, blk + len);
     for (long long i = begin; i < end; i++) {
-        store->Write(i, ciphertext);
+        storeAt(store)->Write(i, ciphertext);
     }
 }
 
-void ocall_write_ramStore(long long index, const char *blk, size_t len) {
+void ocall_write_ramStore(int store, long long index, const char *blk, size_t len) {
+    storeOcalls++;
+    storeBytesReceived += sizeof (long long) + len;
     block ciphertext(blk, blk + len);
-    store->Write(index, ciphertext);
+    storeAt(store)->Write(index, ciphertext);
 }
 #endif /* RAMSTOREENCLAVEINTERFACE_H */
-
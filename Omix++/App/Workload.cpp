@@ -0,0 +1,274 @@
+#include "Workload.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+static const char* OPERATION_NAMES[WORKLOAD_OPERATIONS] = {"READ", "UPDATE", "INSERT", "DELETE", "READ-MODIFY-WRITE", "SCAN"};
+
+KeyGenerator::KeyGenerator(string distribution, long long items, unsigned long long seed)
+: distribution(distribution), items(max(items, 1LL)), rng(seed), unit(0.0, 1.0) {
+    theta = 0.99;
+    zetan = zeta(this->items, theta);
+    alpha = 1.0 / (1.0 - theta);
+    eta = (1 - pow(2.0 / this->items, 1 - theta)) / (1 - zeta(2, theta) / zetan);
+}
+
+double KeyGenerator::zeta(long long n, double theta) {
+    double sum = 0;
+    for (long long i = 1; i <= n; i++) {
+        sum += 1 / pow((double) i, theta);
+    }
+    return sum;
+}
+
+/**
+ * @return rank in [0, n), 0 being the most popular
+ */
+long long KeyGenerator::nextZipfian(long long n) {
+    double u = unit(rng);
+    double uz = u * zetan;
+    if (uz < 1.0) {
+        return 0;
+    }
+    if (uz < 1.0 + pow(0.5, theta)) {
+        return 1;
+    }
+    long long rank = (long long) (n * pow(eta * u - eta + 1, alpha));
+    return min(rank, n - 1);
+}
+
+long long KeyGenerator::next(long long lastKey) {
+    if (lastKey < 1) {
+        return 1;
+    }
+    if (distribution == "zipfian") {
+        // FNV-1a scatters the popular ranks so that they are not neighbours in the tree
+        unsigned long long hash = 14695981039346656037ULL;
+        unsigned long long rank = nextZipfian(items);
+        for (int i = 0; i < 8; i++) {
+            hash ^= (rank >> (i * 8)) & 0xff;
+            hash *= 1099511628211ULL;
+        }
+        return 1 + (long long) (hash % lastKey);
+    } else if (distribution == "latest") {
+        long long rank = nextZipfian(items);
+        return max(1LL, lastKey - rank);
+    }
+    return 1 + (long long) (rng() % lastKey);
+}
+
+bool WorkloadConfig::preset(string workload) {
+    double mixes[6][WORKLOAD_OPERATIONS] = {
+        {0.5, 0.5, 0, 0, 0, 0}, // A: update heavy
+        {0.95, 0.05, 0, 0, 0, 0}, // B: read mostly
+        {1, 0, 0, 0, 0, 0}, // C: read only
+        {0.95, 0, 0.05, 0, 0, 0}, // D: read latest
+        {0, 0, 0.05, 0, 0, 0.95}, // E: short ranges
+        {0.5, 0, 0, 0, 0.5, 0} // F: read-modify-write
+    };
+    if (workload.size() != 1 || toupper(workload[0]) < 'A' || toupper(workload[0]) > 'F') {
+        return false;
+    }
+    int index = toupper(workload[0]) - 'A';
+    name = string(1, (char) toupper(workload[0]));
+    std::copy(mixes[index], mixes[index] + WORKLOAD_OPERATIONS, proportions);
+    distribution = index == 3 ? "latest" : "zipfian";
+    return true;
+}
+
+bool WorkloadConfig::parse(string option) {
+    size_t eq = option.find('=');
+    if (eq == string::npos) {
+        return false;
+    }
+    string key = option.substr(0, eq);
+    string value = option.substr(eq + 1);
+    if (key == "workload") {
+        return preset(value);
+    } else if (key == "distribution") {
+        distribution = value;
+        return value == "uniform" || value == "zipfian" || value == "latest";
+    } else if (key == "records") {
+        recordCount = atoll(value.c_str());
+    } else if (key == "warmup") {
+        warmupOps = atoll(value.c_str());
+    } else if (key == "duration") {
+        duration = atof(value.c_str());
+    } else if (key == "ops") {
+        maxOps = atoll(value.c_str());
+    } else if (key == "scan") {
+        scanLength = atoi(value.c_str());
+    } else if (key == "format") {
+        format = value;
+        return value == "csv" || value == "json";
+    } else if (key == "output") {
+        output = value;
+    } else if (key == "seed") {
+        seed = strtoull(value.c_str(), NULL, 10);
+    } else {
+        for (int i = 0; i < WORKLOAD_OPERATIONS; i++) {
+            string operation = OPERATION_NAMES[i];
+            std::transform(operation.begin(), operation.end(), operation.begin(), ::tolower);
+            if (key == operation || (i == WORKLOAD_RMW && key == "rmw")) {
+                proportions[i] = atof(value.c_str());
+                name = "custom";
+                return true;
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+Workload::Workload(WorkloadConfig config, WorkloadTarget* target)
+: config(config), target(target), rng(config.seed), lastKey(0), latencies(WORKLOAD_OPERATIONS), elapsed(0) {
+    if (this->config.capacity <= 0) {
+        this->config.capacity = this->config.recordCount;
+    }
+    keys = new KeyGenerator(config.distribution, max(config.recordCount, 1LL), config.seed + 1);
+}
+
+Workload::~Workload() {
+    delete keys;
+}
+
+void Workload::load() {
+    char value[16];
+    for (long long key = 1; key <= config.recordCount; key++) {
+        snprintf(value, sizeof (value), "v%lld", key);
+        target->write(key, value);
+    }
+    lastKey = config.recordCount;
+}
+
+int Workload::nextOperation() {
+    double total = 0;
+    for (int i = 0; i < WORKLOAD_OPERATIONS; i++) {
+        total += config.proportions[i];
+    }
+    double r = uniform_real_distribution<double>(0, total)(rng);
+    for (int i = 0; i < WORKLOAD_OPERATIONS; i++) {
+        if (r < config.proportions[i]) {
+            return i;
+        }
+        r -= config.proportions[i];
+    }
+    return WORKLOAD_READ;
+}
+
+void Workload::execute(int operation) {
+    char value[16] = {0};
+    long long key = keys->next(lastKey);
+    switch (operation) {
+        case WORKLOAD_READ:
+            target->read(key, value);
+            break;
+        case WORKLOAD_INSERT:
+            // the OMAP is sized up front, once it is full an insert overwrites
+            if (lastKey < config.capacity) {
+                lastKey++;
+                key = lastKey;
+            }
+            snprintf(value, sizeof (value), "i%lld", key);
+            target->write(key, value);
+            break;
+        case WORKLOAD_UPDATE:
+            snprintf(value, sizeof (value), "u%lld", key);
+            target->write(key, value);
+            break;
+        case WORKLOAD_DELETE:
+            target->remove(key);
+            break;
+        case WORKLOAD_RMW:
+            target->read(key, value);
+            value[0] = 'm';
+            value[15] = 0;
+            target->write(key, value);
+            break;
+        case WORKLOAD_SCAN:
+            // the OMAP has no range query, a scan reads consecutive keys one by one
+            for (long long i = key; i < key + config.scanLength && i <= lastKey; i++) {
+                target->read(i, value);
+            }
+            break;
+    }
+}
+
+void Workload::run() {
+    for (long long i = 0; i < config.warmupOps; i++) {
+        execute(nextOperation());
+    }
+    auto begin = chrono::steady_clock::now();
+    long long ops = 0;
+    while (true) {
+        auto now = chrono::steady_clock::now();
+        elapsed = chrono::duration<double>(now - begin).count();
+        if ((config.maxOps > 0 && ops >= config.maxOps) || (config.duration > 0 && elapsed >= config.duration)) {
+            break;
+        }
+        if (config.maxOps <= 0 && config.duration <= 0) {
+            break;
+        }
+        int operation = nextOperation();
+        auto start = chrono::steady_clock::now();
+        execute(operation);
+        auto end = chrono::steady_clock::now();
+        latencies[operation].push_back(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+        ops++;
+    }
+}
+
+long long Workload::percentile(vector<long long>& values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t index = min(values.size() - 1, (size_t) ceil(p * values.size()) - (p > 0 ? 1 : 0));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void Workload::report(ostream& out) {
+    vector<vector<long long> > rows = latencies;
+    vector<long long> all;
+    for (int i = 0; i < WORKLOAD_OPERATIONS; i++) {
+        all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+    }
+    rows.push_back(all);
+
+    char line[512];
+    if (config.format == "csv") {
+        out << "workload,distribution,records,operation,count,throughput_ops,avg_us,p50_us,p99_us,p999_us\n";
+    } else {
+        out << "{\"workload\":\"" << config.name << "\",\"distribution\":\"" << config.distribution << "\",\"records\":" << config.recordCount << ",\"duration_s\":" << elapsed << ",\"operations\":[";
+    }
+    bool first = true;
+    for (size_t i = 0; i < rows.size(); i++) {
+        vector<long long>& values = rows[i];
+        if (values.empty()) {
+            continue;
+        }
+        const char* operation = i < WORKLOAD_OPERATIONS ? OPERATION_NAMES[i] : "ALL";
+        double sum = 0;
+        for (long long v : values) {
+            sum += v;
+        }
+        double throughput = elapsed > 0 ? values.size() / elapsed : 0;
+        double avg = sum / values.size() / 1000.0;
+        double p50 = percentile(values, 0.5) / 1000.0;
+        double p99 = percentile(values, 0.99) / 1000.0;
+        double p999 = percentile(values, 0.999) / 1000.0;
+        if (config.format == "csv") {
+            snprintf(line, sizeof (line), "%s,%s,%lld,%s,%zu,%f,%f,%f,%f,%f\n", config.name.c_str(), config.distribution.c_str(), config.recordCount, operation, values.size(), throughput, avg, p50, p99, p999);
+        } else {
+            snprintf(line, sizeof (line), "%s{\"operation\":\"%s\",\"count\":%zu,\"throughput_ops\":%f,\"avg_us\":%f,\"p50_us\":%f,\"p99_us\":%f,\"p999_us\":%f}", first ? "" : ",", operation, values.size(), throughput, avg, p50, p99, p999);
+        }
+        out << line;
+        first = false;
+    }
+    if (config.format == "json") {
+        out << "]}\n";
+    }
+}
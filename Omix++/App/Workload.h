@@ -0,0 +1,111 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <string>
+#include <vector>
+#include <random>
+#include <ostream>
+
+using namespace std;
+
+/**
+ * The map a workload runs against. Keys are positive, values are 16 byte
+ * NUL terminated strings as expected by ecall_write_node.
+ */
+class WorkloadTarget {
+public:
+    virtual void read(long long key, char* value) = 0;
+    virtual void write(long long key, const char* value) = 0;
+    virtual void remove(long long key) = 0;
+
+    virtual ~WorkloadTarget() {
+    }
+};
+
+/**
+ * YCSB key choosers. Zipfian follows Gray et al. "Quickly Generating
+ * Billion-Record Synthetic Databases" with the popular items scattered over
+ * the key space, latest favours the most recently inserted keys.
+ */
+class KeyGenerator {
+private:
+    string distribution;
+    long long items;
+    double theta, zetan, alpha, eta;
+    mt19937_64 rng;
+    uniform_real_distribution<double> unit;
+
+    static double zeta(long long n, double theta);
+    long long nextZipfian(long long n);
+
+public:
+    KeyGenerator(string distribution, long long items, unsigned long long seed);
+    /**
+     * @param lastKey largest key inserted so far
+     * @return key in [1, lastKey]
+     */
+    long long next(long long lastKey);
+};
+
+enum WorkloadOperation {
+    WORKLOAD_READ = 0,
+    WORKLOAD_UPDATE,
+    WORKLOAD_INSERT,
+    WORKLOAD_DELETE,
+    WORKLOAD_RMW,
+    WORKLOAD_SCAN,
+    WORKLOAD_OPERATIONS
+};
+
+class WorkloadConfig {
+public:
+    string name = "A";
+    double proportions[WORKLOAD_OPERATIONS] = {0.5, 0.5, 0, 0, 0, 0};
+    string distribution = "zipfian";
+    long long recordCount = 0;
+    long long capacity = 0;
+    long long warmupOps = 100;
+    long long maxOps = 0;
+    double duration = 10;
+    int scanLength = 10;
+    string format = "csv";
+    string output;
+    unsigned long long seed = 1;
+
+    /**
+     * Selects one of the YCSB core workloads A-F
+     * @return false if the name is unknown
+     */
+    bool preset(string workload);
+    /**
+     * Applies a key=value option, e.g. workload=B, distribution=latest,
+     * records=1000, warmup=100, duration=30, ops=5000, read=0.9, delete=0.1,
+     * format=json, output=result.json
+     * @return false if the option is not recognised
+     */
+    bool parse(string option);
+};
+
+class Workload {
+private:
+    WorkloadConfig config;
+    WorkloadTarget* target;
+    KeyGenerator* keys;
+    mt19937_64 rng;
+    long long lastKey;
+    vector<vector<long long> > latencies;
+    double elapsed;
+
+    int nextOperation();
+    void execute(int operation);
+    static long long percentile(vector<long long>& values, double p);
+
+public:
+    Workload(WorkloadConfig config, WorkloadTarget* target);
+    virtual ~Workload();
+    void load();
+    void run();
+    void report(ostream& out);
+};
+
+#endif /* WORKLOAD_H */
@@ -27,5 +27,41 @@ void ocall_start_timer(int timerID) {
 double ocall_stop_timer(int timerID) {
     return Utilities::stopTimer(timerID);
 }
+
+/* Per-phase log2 histograms of the durations flushed by the enclave tracer */
+static const int TRACE_PHASE_COUNT = 6;
+static const char* TRACE_PHASE_NAMES[TRACE_PHASE_COUNT] = {"Fetch", "Decrypt", "Sort", "Assignment", "Encrypt", "Write-back"};
+static unsigned long long traceHistogram[TRACE_PHASE_COUNT][64];
+static unsigned long long traceCount[TRACE_PHASE_COUNT];
+static unsigned long long traceTotal[TRACE_PHASE_COUNT];
+
+void ocall_flush_trace(const int* phases, const unsigned long long* durations, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (phases[i] < 0 || phases[i] >= TRACE_PHASE_COUNT) {
+            continue;
+        }
+        int bucket = 0;
+        while (bucket < 63 && (durations[i] >> (bucket + 1)) != 0) {
+            bucket++;
+        }
+        traceHistogram[phases[i]][bucket]++;
+        traceCount[phases[i]]++;
+        traceTotal[phases[i]] += durations[i];
+    }
+}
+
+void printTraceHistograms() {
+    for (int p = 0; p < TRACE_PHASE_COUNT; p++) {
+        if (traceCount[p] == 0) {
+            continue;
+        }
+        printf("Trace %s Count: %llu Average: %f\n", TRACE_PHASE_NAMES[p], traceCount[p], (double) traceTotal[p] / traceCount[p]);
+        for (int b = 0; b < 64; b++) {
+            if (traceHistogram[p][b] != 0) {
+                printf("Trace %s [%llu, %llu): %llu\n", TRACE_PHASE_NAMES[p], (b == 0 ? 0ULL : 1ULL << b), (b == 63 ? ~0ULL : 1ULL << (b + 1)), traceHistogram[p][b]);
+            }
+        }
+    }
+}
 #endif // COMMON_H
 
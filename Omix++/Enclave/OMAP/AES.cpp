@@ -1,4 +1,5 @@
 #include "AES.hpp"
+#include "IOStats.hpp"
 #include <openssl/evp.h>
 #include <openssl/err.h>
 #include <openssl/conf.h>
@@ -102,6 +103,7 @@ block AES::DecryptBlock(bytes<Key> key, bytes<IV> iv, block ciphertext, size_t c
 }
 
 block AES::Encrypt(bytes<Key> key, block plaintext, size_t clen_size, size_t plaintext_size) {
+    IOStats::aes();
     block ciphertext;
     bytes<IV> iv = AES::GenerateIV();
 
@@ -113,6 +115,7 @@ block AES::Encrypt(bytes<Key> key, block plaintext, size_t clen_size, size_t pla
 }
 
 block AES::Decrypt(bytes<Key> key, block ciphertext, size_t clen_size) {
+    IOStats::aes();
     // Extract the IV
     bytes<IV> iv;
     std::copy(ciphertext.end() - IV, ciphertext.end(), iv.begin());
@@ -23,8 +23,8 @@ void check_memory2(string text) {
     free(mem);
 }
 
-AVLTree::AVLTree(long long maxSize, bytes<Key> secretkey, bool isEmptyMap) {
-    oram = new ORAM(maxSize, secretkey, false, isEmptyMap);
+AVLTree::AVLTree(long long maxSize, bytes<Key> secretkey, bool isEmptyMap, int store) {
+    oram = new ORAM(maxSize, secretkey, false, isEmptyMap, store);
     int depth = (int) (ceil(log2(maxSize)) - 1) + 1;
     maxOfRandom = (long long) (pow(2, depth));
     times.push_back(vector<double>());
@@ -416,7 +416,9 @@ Bid AVLTree::insert(Bid rootKey, unsigned long long& rootPos, Bid omapKey, strin
 
     balance = Node::conditional_select(balance, leftHeight - rightHeight, remainerIsDummy);
 
-    ocall_start_timer(totheight + 100000);
+    if (logTime) {
+        ocall_start_timer(totheight + 100000);
+    }
     //------------------------------------------------
 
     // if is real AND left subtree too high AND omapKey smaller than its ancestor - Left Left Case
@@ -2057,7 +2059,9 @@ Bid AVLTree::insert2(Bid rootKey, unsigned long long& rootPos, Bid omapKey, stri
         balance = leftHeight - rightHeight;
     }
 
-    ocall_start_timer(totheight + 100000);
+    if (logTime) {
+        ocall_start_timer(totheight + 100000);
+    }
 
     if (remainerIsDummy == false && CTeq(CTcmp(balance, 1), 1) && omapKey < node->leftID) {
         //                printf("log1\n");
@@ -2415,7 +2419,9 @@ Bid AVLTree::insert2(Bid rootKey, unsigned long long& rootPos, Bid omapKey, stri
         retKey = retKey;
         //----------------------------------------------------------------------------------------
     }
-    ocall_stop_timer(&t, totheight + 100000);
+    if (logTime) {
+        ocall_stop_timer(&t, totheight + 100000);
+    }
     //    times[0][times[0].size() - 1] += t;
     delete tmpDummyNode;
     return retKey;
@@ -2436,12 +2442,13 @@ string AVLTree::search(Node* rootNode, Bid omapKey) {
     int upperBound = (int) (1.44 * oram->depth);
     bool found = false;
     unsigned long long dumyPos;
+    bool pipelined = oram->pipelined();
 
     do {
         unsigned long long rnd = RandomPath();
         unsigned long long rnd2 = RandomPath();
         bool isDummyAction = Node::CTeq(Node::CTcmp(dummyState, 1), 0);
-        head = oram->ReadWrite(curKey, lastPos, newPos, isDummyAction, rnd2, omapKey);
+        head = oram->ReadWrite(curKey, lastPos, newPos, isDummyAction, rnd2, omapKey, pipelined);
 
         // dummyState == 1
         bool cond1 = Node::CTeq(Node::CTcmp(dummyState, 1), 0);
@@ -2477,6 +2484,14 @@ string AVLTree::search(Node* rootNode, Bid omapKey) {
         dummyState = Node::conditional_select(1, dummyState, !cond4 && ((!cond1 && cond2 && leftIsZero)|| (!cond1 && !cond2 && cond3 && rightIsZero) ));        
         found = Node::conditional_select(true, found, !cond1 && !cond2 && !cond3 && cond4);
         delete head;
+
+        // the leaf of the next access is known now, its path is read while this one is evicted
+        if (pipelined && oram->readCnt <= upperBound) {
+            bool nextIsDummy = Node::CTeq(Node::CTcmp(dummyState, 1), 0);
+            oram->evictAndPrefetch(Node::conditional_select(oram->ReserveRandomPath(), lastPos, nextIsDummy));
+        } else if (pipelined) {
+            oram->evict(oram->evictBuckets);
+        }
     } while (oram->readCnt <= upperBound);
     delete tmpDummyNode;
     for (int i = 0; i < 16; i++) {
@@ -2701,12 +2716,12 @@ void AVLTree::startOperation(bool batchWrite) {
 /*
  * after executing each operation, this function should be called with proper arguments
  */
-void AVLTree::finishOperation() {
+void AVLTree::finishOperation(bool writeBack) {
     for (auto item : avlCache) {
         delete item;
     }
     avlCache.clear();
-    oram->finilize();
+    oram->finilize(false, writeBack);
 }
 
 unsigned long long AVLTree::RandomPath() {
@@ -2716,6 +2731,36 @@ unsigned long long AVLTree::RandomPath() {
 }
 
 AVLTree::AVLTree(long long maxSize, bytes<Key> secretkey, Bid& rootKey, unsigned long long& rootPos, map<Bid, string>* pairs, map<unsigned long long, unsigned long long>* permutation) {
+    vector<Node*> nodes;
+    for (auto pair : (*pairs)) {
+        Node* node = newNode(pair.first, pair.second);
+        nodes.push_back(node);
+    }
+    vector<unsigned long long> positions;
+    for (auto slot : (*permutation)) {
+        positions.push_back(slot.second);
+    }
+    build(maxSize, secretkey, rootKey, rootPos, nodes, &positions, true);
+}
+
+AVLTree::AVLTree(long long maxSize, bytes<Key> secretkey, Bid& rootKey, unsigned long long& rootPos, vector<pair<Bid, string> >* sortedPairs) {
+    vector<Node*> nodes;
+    for (auto pair : (*sortedPairs)) {
+        Node* node = newNode(pair.first, pair.second);
+        nodes.push_back(node);
+    }
+    int depth = (int) (ceil(log2(maxSize)) - 1) + 1;
+    vector<unsigned long long> positions = ORAM::ShuffledLeaves((long long) pow(2, depth));
+    build(maxSize, secretkey, rootKey, rootPos, nodes, &positions, false);
+}
+
+/**
+ * Lays the nodes out as a balanced BST, pads them to a full tree and writes
+ * everything to a new ORAM. The permutation gives the leaf of every node, in
+ * the order the nodes are placed.
+ * @param sort false if the nodes are already in key order
+ */
+void AVLTree::build(long long maxSize, bytes<Key> secretkey, Bid& rootKey, unsigned long long& rootPos, vector<Node*>& nodes, vector<unsigned long long>* permutation, bool sort) {
     int depth = (int) (ceil(log2(maxSize)) - 1) + 1;
     maxOfRandom = (long long) (pow(2, depth));
     times.push_back(vector<double>());
@@ -2724,25 +2769,28 @@ AVLTree::AVLTree(long long maxSize, bytes<Key> secretkey, Bid& rootKey, unsigned
     times.push_back(vector<double>());
     times.push_back(vector<double>());
 
-    vector<Node*> nodes;
-    for (auto pair : (*pairs)) {
-        Node* node = newNode(pair.first, pair.second);
-        nodes.push_back(node);
-    }
-
-    int nextPower2 = (int) pow(2, ceil(log2(nodes.size())));
+    // the last node is left out of the BST, so there is always a padding node after the real ones
+    int nextPower2 = (int) pow(2, ceil(log2(nodes.size() + 1)));
     for (int i = (int) nodes.size(); i < nextPower2; i++) {
         Bid bid = INF + i;
+        // above the keys of the real nodes even if they use the high bytes, so presorted nodes stay sorted
+        bid.id[ID_SIZE - 2] = 0xFF;
+        bid.id[ID_SIZE - 1] = 0xFF;
         Node* node = newNode(bid, "");
         node->isDummy = false;
         nodes.push_back(node);
     }
 
-    bitonicSort(&nodes);
+    if (sort) {
+        bitonicSort(&nodes);
+    }
     double t;
     printf("Creating BST of %d Nodes\n", nodes.size());
     ocall_start_timer(53);
     sortedArrayToBST(&nodes, 0, nodes.size() - 2, rootPos, rootKey, permutation);
+    // the padding node left out of the BST still takes its slot, so every leaf gets exactly Z nodes
+    nodes.back()->pos = (*permutation)[permutationIterator];
+    permutationIterator++;
     ocall_stop_timer(&t, 53);
     times[0].push_back(t);
     printf("Inserting in ORAM\n");
@@ -2764,7 +2812,7 @@ AVLTree::AVLTree(long long maxSize, bytes<Key> secretkey, Bid& rootKey, unsigned
     times[1].push_back(t);
 }
 
-int AVLTree::sortedArrayToBST(vector<Node*>* nodes, long long start, long long end, unsigned long long& pos, Bid& node, map<unsigned long long, unsigned long long>* permutation) {
+int AVLTree::sortedArrayToBST(vector<Node*>* nodes, long long start, long long end, unsigned long long& pos, Bid& node, vector<unsigned long long>* permutation) {
     if (start > end) {
         pos = -1;
         node = 0;
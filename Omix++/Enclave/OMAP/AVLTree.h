@@ -75,7 +75,8 @@ private:
         return !(a^b);
     }
 
-    int sortedArrayToBST(vector<Node*>* nodes, long long start, long long end, unsigned long long& pos, Bid& node, map<unsigned long long, unsigned long long>* permutation);
+    int sortedArrayToBST(vector<Node*>* nodes, long long start, long long end, unsigned long long& pos, Bid& node, vector<unsigned long long>* permutation);
+    void build(long long maxSize, bytes<Key> secretkey, Bid& rootKey, unsigned long long& rootPos, vector<Node*>& nodes, vector<unsigned long long>* permutation, bool sort);
     unsigned long long permutationIterator = 0;
     unsigned long long INF = 92233720368547758;
 
@@ -90,8 +91,14 @@ private:
     
 public:
     AVLTree(long long maxSize, bytes<Key> secretkey, Bid& rootKey, unsigned long long& rootPos, map<Bid, string>* pairs, map<unsigned long long, unsigned long long>* permutation);
-    AVLTree(long long maxSize, bytes<Key> key,bool isEmptyMap);
+    /**
+     * Bulk construction from pairs already sorted by key, with a random leaf
+     * for every node
+     */
+    AVLTree(long long maxSize, bytes<Key> secretkey, Bid& rootKey, unsigned long long& rootPos, vector<pair<Bid, string> >* sortedPairs);
+    AVLTree(long long maxSize, bytes<Key> key, bool isEmptyMap, int store = -1);
     virtual ~AVLTree();
+    ORAM* getORAM() { return oram; }
     int totheight = 0;
     bool logTime = false;
     vector<vector<double> > times;
@@ -112,7 +119,7 @@ public:
     void printTree(Node* root, int indent);
     void startOperation(bool batchWrite = false);
     void setupInsert(Bid& rootKey, int& rootPos, map<Bid, string>& pairs);
-    void finishOperation();
+    void finishOperation(bool writeBack = true);
     void preOrderKeys(Node *root, vector<long long> &res);
 };
 
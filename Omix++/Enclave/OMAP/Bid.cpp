@@ -84,14 +84,7 @@ void Bid::setValue(long long other) {
 }
 
 bool Bid::isZero() {
-    int res = 0;
-    bool found = false;
-    for (int i = ID_SIZE - 1; i >= 0; i--) {
-        int cmpRes = CTcmp(id[i], 0);
-        res = conditional_select(cmpRes, res, !found);
-        found = conditional_select(true, found, !CTeq(cmpRes, 0) && !found);
-    }
-    return CTeq(res, 0);
+    return CTeq(toWord(*this), (unsigned __int128) 0);
 }
 
 void Bid::setToZero() {
@@ -2,6 +2,7 @@
 #define BID_H
 #include "Types.hpp"
 #include <array>
+#include <cstring>
 #include <string>
 using namespace std;
 
@@ -101,26 +102,46 @@ public:
         return result;
     }
 
+    /**
+     * constant time comparator over two words of at most 127 bits each
+     * @param left
+     * @param right
+     * @return left < right -> -1,  left = right -> 0, left > right -> 1
+     */
+    static int CTcmpWide(unsigned __int128 lhs, unsigned __int128 rhs) {
+        unsigned __int128 overflowing_iff_lt = lhs - rhs;
+        unsigned __int128 overflowing_iff_gt = rhs - lhs;
+        int is_less_than = (int) -(int) (overflowing_iff_lt >> 127); // -1 if self < other, 0 otherwise.
+        int is_greater_than = (int) (overflowing_iff_gt >> 127); // 1 if self > other, 0 otherwise.
+        return is_less_than + is_greater_than;
+    }
+
+    /**
+     * loads the 10-byte id as one 80-bit word; id[0] is the least significant
+     * byte, so on a little-endian host the first 8 bytes are the low word and
+     * the last 2 bytes are the high word
+     */
+    static unsigned __int128 toWord(const Bid& b) {
+        unsigned long long low;
+        unsigned short high;
+        std::memcpy(&low, b.id.data(), sizeof (low));
+        std::memcpy(&high, b.id.data() + sizeof (low), sizeof (high));
+        return ((unsigned __int128) high << 64) | low;
+    }
+
     static int CTcmp(Bid lhs, Bid rhs) {
-        int res = 0;
-        bool found = false;
-        for (int i = ID_SIZE - 1; i >= 0; i--) {
-            int cmpRes = CTcmp(lhs.id[i], rhs.id[i]);
-            res = conditional_select(cmpRes, res, !found);
-            found = conditional_select(true, found, !CTeq(cmpRes, 0) && !found);
-        }
-        return res;
+        return CTcmpWide(toWord(lhs), toWord(rhs));
     }
 
     static int CTcmp(std::array< byte_t, 16> lhs, std::array< byte_t, 16> rhs) {
-        int res = 0;
-        bool found = false;
-        for (int i = 16 - 1; i >= 0; i--) {
-            int cmpRes = CTcmp(lhs[i], rhs[i]);
-            res = conditional_select(cmpRes, res, !found);
-            found = conditional_select(true, found, !CTeq(cmpRes, 0) && !found);
-        }
-        return res;
+        unsigned long long lhsLow, lhsHigh, rhsLow, rhsHigh;
+        std::memcpy(&lhsLow, lhs.data(), 8);
+        std::memcpy(&lhsHigh, lhs.data() + 8, 8);
+        std::memcpy(&rhsLow, rhs.data(), 8);
+        std::memcpy(&rhsHigh, rhs.data() + 8, 8);
+        int highRes = CTcmpWide(lhsHigh, rhsHigh);
+        int lowRes = CTcmpWide(lhsLow, rhsLow);
+        return conditional_select(lowRes, highRes, CTeq(highRes, 0));
     }
 
     /**
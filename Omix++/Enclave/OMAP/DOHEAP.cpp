@@ -12,11 +12,15 @@
 #include "HeapObliviousOperations.h"
 #include "Enclave_t.h"  /* print_string */
 #include "../Enclave.h"
+#include "Trace.hpp"
+#include "IOStats.hpp"
+#include "StoreHandle.h"
+#include "ObliviousArray.hpp"
 #include <algorithm>
 #include <stdlib.h>
 #include <vector>
 
-DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, bool simulation)
+DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, bool simulation, bool decreaseKey)
 : key(oram_key) {
     depth = (int) (ceil(log2(maxSize)) - 1) + 1;
     maxOfRandom = (long long) (pow(2, depth));
@@ -25,24 +29,27 @@ DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, bool simulation)
     AES::Setup();
     bucketCount = (long long) maxOfRandom * 2 - 1;
     INF = 9223372036854775807 - (bucketCount);
-    PERMANENT_STASH_SIZE = 90;
+    PERMANENT_STASH_SIZE = StashConfig::PermanentStashSize(Z, maxSize);
+    stashStats.reset(PERMANENT_STASH_SIZE);
     stash.preAllocate(PERMANENT_STASH_SIZE * 4);
 
     nextDummyCounter = INF;
     blockSize = sizeof (HeapNode); // B    
     printf("block size:%d\n", blockSize);
     size_t blockCount = (size_t) (Z * bucketCount);
-    storeBlockSize = (size_t) (IV + AES::GetCiphertextLength((int) ((Z + 1) * (blockSize))));
-    clen_size = AES::GetCiphertextLength((int) (blockSize) * (Z + 1));
-    plaintext_size = (blockSize) * (Z + 1);
+    storeBlockSize = (size_t) (IV + AES::GetCiphertextLength((int) (Z * (blockSize))));
+    clen_size = AES::GetCiphertextLength((int) (blockSize) * Z);
+    plaintext_size = (blockSize) * Z;
     if (!simulation) {
         if (useLocalRamStore) {
             localStore = new LocalRAMStore(blockCount, storeBlockSize);
         } else {
-            ocall_setup_heapStore(blockCount, storeBlockSize);
+            ocall_setup_heapStore(&storeHandle, blockCount, storeBlockSize);
+            CheckStore(storeHandle);
         }
     } else {
-        ocall_setup_heapStore(depth, -1);
+        ocall_setup_heapStore(&storeHandle, depth, -1);
+        CheckStore(storeHandle);
     }
 
     maxHeightOfAVLTree = (int) floor(log2(blockCount)) + 1;
@@ -58,8 +65,6 @@ DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, bool simulation)
         bucket.blocks[z].id = 0;
         bucket.blocks[z].data.resize(blockSize, 0);
     }
-    bucket.subtree_min.id = 0;
-    bucket.subtree_min.data.resize(blockSize, 0);
     if (!simulation) {
         //        InitializeBuckets(0, bucketCount, bucket);
         long long i;
@@ -72,8 +77,6 @@ DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, bool simulation)
                 bucket.blocks[z].id = 0;
                 bucket.blocks[z].data.resize(blockSize, 0);
             }
-            bucket.subtree_min.id = 0;
-            bucket.subtree_min.data.resize(blockSize, 0);
             WriteBucket((int) i, bucket);
         }
         for (long long j = 0; i < bucketCount; i++, j++) {
@@ -92,8 +95,6 @@ DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, bool simulation)
                 bucket.blocks[z].id = 0;
                 bucket.blocks[z].data.resize(blockSize, 0);
             }
-            bucket.subtree_min.id = 0;
-            bucket.subtree_min.data.resize(blockSize, 0);
             WriteBucket((long long) i, bucket);
         }
     }
@@ -105,10 +106,115 @@ DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, bool simulation)
         stash.insert(dummy);
         nextDummyCounter++;
     }
+    InitializeLeaves(maxSize, decreaseKey);
+    InitializeMetadata(simulation);
     printf("End of Initialization\n");
 }
 
+long long DOHEAP::metadataInEnclaveLimit = 8 * 1024 * 1024;
+
+void DOHEAP::InitializeMetadata(bool simulation) {
+    HeapMin empty = HeapMin();
+    metadataInEnclave = simulation || bucketCount * (long long) sizeof (HeapMin) <= metadataInEnclaveLimit;
+    if (metadataInEnclave) {
+        subtreeMins.assign(bucketCount, empty);
+        return;
+    }
+    metadata_clen_size = AES::GetCiphertextLength((int) sizeof (HeapMin));
+    metadataBlockSize = (int) (IV + metadata_clen_size);
+    ocall_setup_heapStore(&metadataHandle, bucketCount, metadataBlockSize);
+    CheckStore(metadataHandle);
+    std::array<byte_t, sizeof (HeapMin) > data = to_bytes(empty);
+    block b(data.begin(), data.end());
+    block ciphertext = AES::Encrypt(key, b, metadata_clen_size, sizeof (HeapMin));
+    ocall_initialize_heapStore(metadataHandle, 0, bucketCount, (const char*) ciphertext.data(), ciphertext.size());
+    IOStats::ocall(2 * sizeof (long long) + ciphertext.size(), 0);
+}
+
+void DOHEAP::LoadMetadata(vector<long long> indexes) {
+    if (metadataInEnclave) {
+        return;
+    }
+    vector<long long> missing;
+    for (long long index : indexes) {
+        if (metadataCache.count(index) == 0 && std::find(missing.begin(), missing.end(), index) == missing.end()) {
+            missing.push_back(index);
+        }
+    }
+    if (missing.size() == 0) {
+        return;
+    }
+    size_t readSize;
+    char* tmp = new char[missing.size() * metadataBlockSize];
+    unsigned long long traceStart = Trace::now();
+    ocall_nread_heapStore(&readSize, metadataHandle, missing.size(), missing.data(), tmp, missing.size() * metadataBlockSize);
+    IOStats::ocall(missing.size() * sizeof (long long), missing.size() * metadataBlockSize);
+    Trace::record(TRACE_FETCH, traceStart);
+    traceStart = Trace::now();
+    for (unsigned int i = 0; i < missing.size(); i++) {
+        block ciphertext(tmp + i * readSize, tmp + (i + 1) * readSize);
+        block buffer = AES::Decrypt(key, ciphertext, metadata_clen_size);
+        std::array<byte_t, sizeof (HeapMin) > data;
+        std::copy(buffer.begin(), buffer.begin() + sizeof (HeapMin), data.begin());
+        HeapMin entry = HeapMin();
+        metadataCache[missing[i]] = from_bytes(data, entry);
+    }
+    Trace::record(TRACE_DECRYPT, traceStart);
+    delete[] tmp;
+}
+
+void DOHEAP::EvictMetadata() {
+    if (metadataInEnclave || metadataCache.size() == 0) {
+        return;
+    }
+    vector<long long> indexes;
+    char* tmp = new char[metadataCache.size() * metadataBlockSize];
+    size_t cipherSize = 0;
+    unsigned long long traceStart = Trace::now();
+    for (auto& item : metadataCache) {
+        std::array<byte_t, sizeof (HeapMin) > data = to_bytes(item.second);
+        block b(data.begin(), data.end());
+        block ciphertext = AES::Encrypt(key, b, metadata_clen_size, sizeof (HeapMin));
+        std::memcpy(tmp + indexes.size() * ciphertext.size(), ciphertext.data(), ciphertext.size());
+        cipherSize = ciphertext.size();
+        indexes.push_back(item.first);
+    }
+    Trace::record(TRACE_ENCRYPT, traceStart);
+    traceStart = Trace::now();
+    ocall_nwrite_heapStore(metadataHandle, indexes.size(), indexes.data(), (const char*) tmp, cipherSize * indexes.size());
+    IOStats::ocall(indexes.size() * (sizeof (long long) + cipherSize), 0);
+    Trace::record(TRACE_WRITEBACK, traceStart);
+    delete[] tmp;
+    metadataCache.clear();
+}
+
+HeapMin& DOHEAP::SubtreeMin(long long index) {
+    if (metadataInEnclave) {
+        return subtreeMins[index];
+    }
+    return metadataCache[index];
+}
+
+HeapNode* DOHEAP::RootMin() {
+    LoadMetadata(vector<long long>(1, 0));
+    HeapMin& record = SubtreeMin(0);
+    HeapNode* node = new HeapNode();
+    node->index = record.index;
+    node->pos = record.pos;
+    node->value = record.value;
+    node->key = record.key;
+    node->isDummy = HeapNode::CTeq(record.index, (unsigned long long) 0);
+    return node;
+}
+
 DOHEAP::~DOHEAP() {
+    delete leafOf;
+    if (storeHandle >= 0) {
+        ocall_release_store(storeHandle);
+    }
+    if (metadataHandle >= 0) {
+        ocall_release_store(metadataHandle);
+    }
     AES::Cleanup();
 }
 
@@ -117,7 +223,9 @@ DOHEAP::~DOHEAP() {
 void DOHEAP::WriteBucket(long long index, HeapBucket bucket) {
     block b = SerialiseBucket(bucket);
     block ciphertext = AES::Encrypt(key, b, clen_size, plaintext_size);
-    ocall_write_heapStore(index, (const char*) ciphertext.data(), (size_t) ciphertext.size());
+    ocall_write_heapStore(storeHandle, index, (const char*) ciphertext.data(), (size_t) ciphertext.size());
+    IOStats::ocall(sizeof (long long) + ciphertext.size(), 0);
+    IOStats::bucketsWritten(1);
 }
 
 long long DOHEAP::GetNodeOnPath(long long leaf, int curDepth) {
@@ -137,8 +245,6 @@ block DOHEAP::SerialiseBucket(HeapBucket bucket) {
         HeapBlock b = bucket.blocks[z];
         buffer.insert(buffer.end(), b.data.begin(), b.data.end());
     }
-    HeapBlock b = bucket.subtree_min;
-    buffer.insert(buffer.end(), b.data.begin(), b.data.end());
     return buffer;
 }
 
@@ -160,8 +266,6 @@ HeapBucket DOHEAP::DeserialiseBucket(block buffer) {
         stash.insert(node);
         buffer.erase(buffer.begin(), buffer.begin() + blockSize);
     }
-    HeapBlock &curBlock = bucket.subtree_min;
-    curBlock.data.assign(buffer.begin(), buffer.begin() + blockSize);
     return bucket;
 }
 
@@ -180,7 +284,12 @@ vector<HeapBucket> DOHEAP::ReadBuckets(vector<long long> indexes) {
     } else {
         size_t readSize;
         char* tmp = new char[indexes.size() * storeBlockSize];
-        ocall_nread_heapStore(&readSize, indexes.size(), indexes.data(), tmp, indexes.size() * storeBlockSize);
+        unsigned long long traceStart = Trace::now();
+        ocall_nread_heapStore(&readSize, storeHandle, indexes.size(), indexes.data(), tmp, indexes.size() * storeBlockSize);
+        IOStats::ocall(indexes.size() * sizeof (long long), indexes.size() * storeBlockSize);
+        IOStats::bucketsRead(indexes.size());
+        Trace::record(TRACE_FETCH, traceStart);
+        traceStart = Trace::now();
         for (unsigned int i = 0; i < indexes.size(); i++) {
             block ciphertext(tmp + i*readSize, tmp + (i + 1) * readSize);
             block buffer = AES::Decrypt(key, ciphertext, clen_size);
@@ -188,6 +297,7 @@ vector<HeapBucket> DOHEAP::ReadBuckets(vector<long long> indexes) {
             res.push_back(bucket);
             virtualStorage[indexes[i]] = bucket;
         }
+        Trace::record(TRACE_DECRYPT, traceStart);
         delete tmp;
     }
     return res;
@@ -201,7 +311,9 @@ void DOHEAP::InitializeBuckets(long long strtindex, long long endindex, HeapBuck
             localStore->Write(i, ciphertext);
         }
     } else {
-        ocall_initialize_heapStore(strtindex, endindex, (const char*) ciphertext.data(), (size_t) ciphertext.size());
+        ocall_initialize_heapStore(storeHandle, strtindex, endindex, (const char*) ciphertext.data(), (size_t) ciphertext.size());
+        IOStats::ocall(2 * sizeof (long long) + ciphertext.size(), 0);
+        IOStats::bucketsWritten(endindex - strtindex);
     }
 }
 
@@ -227,6 +339,7 @@ void DOHEAP::EvictBuckets() {
             char* tmp = new char[10000 * storeBlockSize];
             vector<long long> indexes;
             size_t cipherSize = 0;
+            unsigned long long traceStart = Trace::now();
             for (int i = 0; i < min((int) (virtualStorage.size() - j * 10000), 10000); i++) {
                 block b = SerialiseBucket(it->second);
                 indexes.push_back(it->first);
@@ -235,14 +348,20 @@ void DOHEAP::EvictBuckets() {
                 cipherSize = ciphertext.size();
                 it++;
             }
+            Trace::record(TRACE_ENCRYPT, traceStart);
             if (min((int) (virtualStorage.size() - j * 10000), 10000) != 0) {
-                ocall_nwrite_heapStore(min((int) (virtualStorage.size() - j * 10000), 10000), indexes.data(), (const char*) tmp, cipherSize * min((int) (virtualStorage.size() - j * 10000), 10000));
+                traceStart = Trace::now();
+                ocall_nwrite_heapStore(storeHandle, min((int) (virtualStorage.size() - j * 10000), 10000), indexes.data(), (const char*) tmp, cipherSize * min((int) (virtualStorage.size() - j * 10000), 10000));
+                IOStats::ocall(min((int) (virtualStorage.size() - j * 10000), 10000) * sizeof (long long) + cipherSize * min((int) (virtualStorage.size() - j * 10000), 10000), 0);
+                IOStats::bucketsWritten(min((int) (virtualStorage.size() - j * 10000), 10000));
+                Trace::record(TRACE_WRITEBACK, traceStart);
             }
             delete tmp;
             indexes.clear();
         }
     }
     virtualStorage.clear();
+    EvictMetadata();
 }
 // Fetches blocks along a path, adding them to the stash
 
@@ -285,33 +404,43 @@ void DOHEAP::FetchPath(long long leaf) {
 }
 
 void DOHEAP::UpdateMin() {
-    vector<long long> nodesIndex;
+    UpdateMin(vector<long long>(1, currentLeaf));
+}
 
-    long long node = currentLeaf;
-    node += bucketCount / 2;
-    for (int d = depth - 1; d >= 0; d--) {
-        long long bucketID = node;
-        if (virtualStorage.count(bucketID) == 0) {
-            nodesIndex.push_back(bucketID);
+void DOHEAP::LoadPaths(const vector<long long>& leaves) {
+    vector<long long> buckets;
+    vector<long long> records;
+    for (long long leaf : leaves) {
+        long long node = leaf + bucketCount / 2;
+        for (int d = depth - 1; d >= 0; d--) {
+            buckets.push_back(node);
+            records.push_back(node);
+            records.push_back(node % 2 == 0 ? node - 1 : node + 1);
+            node = (node + 1) / 2 - 1;
         }
-        if (bucketID % 2 == 0) {
-            bucketID--;
-        } else {
-            bucketID++;
-        }
-        if (virtualStorage.count(bucketID) == 0) {
-            nodesIndex.push_back(bucketID);
-        }
-        node = (node + 1) / 2 - 1;
+        buckets.push_back(0);
+        records.push_back(0);
     }
+    LoadBuckets(buckets);
+    LoadMetadata(records);
+}
 
-    if (virtualStorage.count(0) == 0) {
-        nodesIndex.push_back(0);
+void DOHEAP::LoadBuckets(vector<long long> indexes) {
+    vector<long long> nodesIndex;
+    for (long long index : indexes) {
+        if (virtualStorage.count(index) == 0 && std::find(nodesIndex.begin(), nodesIndex.end(), index) == nodesIndex.end()) {
+            nodesIndex.push_back(index);
+        }
     }
     if (nodesIndex.size() > 0) {
         size_t readSize;
         char* tmp = new char[nodesIndex.size() * storeBlockSize];
-        ocall_nread_heapStore(&readSize, nodesIndex.size(), nodesIndex.data(), tmp, nodesIndex.size() * storeBlockSize);
+        unsigned long long traceStart = Trace::now();
+        ocall_nread_heapStore(&readSize, storeHandle, nodesIndex.size(), nodesIndex.data(), tmp, nodesIndex.size() * storeBlockSize);
+        IOStats::ocall(nodesIndex.size() * sizeof (long long), nodesIndex.size() * storeBlockSize);
+        IOStats::bucketsRead(nodesIndex.size());
+        Trace::record(TRACE_FETCH, traceStart);
+        traceStart = Trace::now();
         for (unsigned int i = 0; i < nodesIndex.size(); i++) {
             block ciphertext(tmp + i*readSize, tmp + (i + 1) * readSize);
             block buffer = AES::Decrypt(key, ciphertext, clen_size);
@@ -321,72 +450,68 @@ void DOHEAP::UpdateMin() {
                 curBlock.data.assign(buffer.begin(), buffer.begin() + blockSize);
                 buffer.erase(buffer.begin(), buffer.begin() + blockSize);
             }
-            HeapBlock &curBlock = bucket.subtree_min;
-            curBlock.data.assign(buffer.begin(), buffer.begin() + blockSize);
             virtualStorage[nodesIndex[i]] = bucket;
         }
+        Trace::record(TRACE_DECRYPT, traceStart);
         delete tmp;
     }
+}
 
-    node = currentLeaf;
-    node += bucketCount / 2;
+void DOHEAP::UpdateMin(const vector<long long>& leaves) {
+    LoadPaths(leaves);
+
+    // every bucket on a path once, children before their parents
+    vector<vector<long long> > levels(depth + 1);
+    for (long long leaf : leaves) {
+        long long node = leaf + bucketCount / 2;
+        for (int d = depth; d >= 0; d--) {
+            if (std::find(levels[d].begin(), levels[d].end(), node) == levels[d].end()) {
+                levels[d].push_back(node);
+            }
+            node = (node + 1) / 2 - 1;
+        }
+    }
     for (int d = depth; d >= 0; d--) {
-        HeapBucket& curBucket = virtualStorage[node];
-        HeapNode localMin;
-        unsigned long long localID = 0;
-        localMin.key.setInfinity();
-        localMin.isDummy = true;
-        for (int i = 0; i < Z; i++) {
-            HeapNode* node = convertBlockToNode(curBucket.blocks[i].data);
-            bool cond = Bid::CTeq(1, Bid::CTcmp(localMin.key, node->key)) && !node->isDummy;
-            HeapNode::conditional_assign(&localMin, node, cond);
-            localID = HeapNode::conditional_select(localID, curBucket.blocks[i].id, cond);
-            delete node;
-        }
-        if (d != depth) {
-            HeapBucket leftBucket = virtualStorage[((node + 1)*2) - 1];
-            HeapNode* leftnode = convertBlockToNode(leftBucket.subtree_min.data);
-            bool cond = Bid::CTeq(1, Bid::CTcmp(localMin.key, leftnode->key)) && !leftnode->isDummy;
-            HeapNode::conditional_assign(&localMin, leftnode, cond);
-            localID = HeapNode::conditional_select(localID, leftBucket.subtree_min.id, cond);
-            delete leftnode;
-
-            HeapBucket rightBucket = virtualStorage[((node + 1)*2)];
-            HeapNode* rightnode = convertBlockToNode(rightBucket.subtree_min.data);
-            cond = Bid::CTeq(1, Bid::CTcmp(localMin.key, rightnode->key)) && !rightnode->isDummy;
-            HeapNode::conditional_assign(&localMin, rightnode, cond);
-            localID = HeapNode::conditional_select(localID, rightBucket.subtree_min.id, cond);
-            delete rightnode;
-        }
-
-        curBucket.subtree_min.id = localID;
-        block tmp = convertNodeToBlock(&localMin);
-        for (int k = 0; k < tmp.size(); k++) {
-            curBucket.subtree_min.data[k] = HeapNode::conditional_select(curBucket.subtree_min.data[k], tmp[k], localMin.isDummy);
+        for (long long node : levels[d]) {
+            RefreshMin(node, d);
         }
+    }
+}
 
-        node = (node + 1) / 2 - 1;
+void DOHEAP::RefreshMin(long long node, int d) {
+    HeapBucket& curBucket = virtualStorage[node];
+    HeapMin localMin = HeapMin();
+    localMin.key.setInfinity();
+    for (int i = 0; i < Z; i++) {
+        HeapNode* node = convertBlockToNode(curBucket.blocks[i].data);
+        bool cond = Bid::CTeq(1, Bid::CTcmp(localMin.key, node->key)) && !node->isDummy;
+        localMin.index = HeapNode::conditional_select(node->index, localMin.index, cond);
+        localMin.pos = HeapNode::conditional_select(node->pos, localMin.pos, cond);
+        localMin.key = Bid::conditional_select(node->key, localMin.key, cond);
+        for (int k = 0; k < localMin.value.size(); k++) {
+            localMin.value[k] = HeapNode::conditional_select(node->value[k], localMin.value[k], cond);
+        }
+        delete node;
+    }
+    if (d != depth) {
+        for (long long child = (node + 1) * 2 - 1; child <= (node + 1) * 2; child++) {
+            HeapMin& childMin = SubtreeMin(child);
+            bool cond = Bid::CTeq(1, Bid::CTcmp(localMin.key, childMin.key)) && !HeapNode::CTeq(childMin.index, (unsigned long long) 0);
+            localMin.index = HeapNode::conditional_select(childMin.index, localMin.index, cond);
+            localMin.pos = HeapNode::conditional_select(childMin.pos, localMin.pos, cond);
+            localMin.key = Bid::conditional_select(childMin.key, localMin.key, cond);
+            for (int k = 0; k < localMin.value.size(); k++) {
+                localMin.value[k] = HeapNode::conditional_select(childMin.value[k], localMin.value[k], cond);
+            }
+        }
     }
+    SubtreeMin(node) = localMin;
 }
 
 pair<Bid,array<byte_t, 16> > DOHEAP::extractMin() {
     pair<Bid,array<byte_t, 16> > res;
     array<byte_t, 16> result;
-    HeapBlock curBlock;
-    if (virtualStorage.count(0) == 0) {
-        vector<long long> nodesIndex;
-        nodesIndex.push_back(0);
-        size_t readSize;
-        char* tmp = new char[nodesIndex.size() * storeBlockSize];
-        ocall_nread_heapStore(&readSize, nodesIndex.size(), nodesIndex.data(), tmp, nodesIndex.size() * storeBlockSize);
-        block ciphertext(tmp, tmp + readSize);
-        block buffer = AES::Decrypt(key, ciphertext, clen_size);
-        curBlock.data.assign(buffer.begin() + blockSize*Z, buffer.begin() + blockSize * (Z + 1));
-        delete tmp;
-    } else {
-        curBlock.data.assign(virtualStorage[0].subtree_min.data.begin(), virtualStorage[0].subtree_min.data.end());
-    }
-    HeapNode* rootnode = convertBlockToNode(curBlock.data);
+    HeapNode* rootnode = RootMin();
     HeapNode* minnode = new HeapNode();
     HeapNode::conditional_assign(minnode,rootnode,true);
     bool isInStash=false;
@@ -419,21 +544,7 @@ pair<Bid,array<byte_t, 16> > DOHEAP::extractMin() {
 
 array<byte_t, 16> DOHEAP::findMin() {
     array<byte_t, 16> result;
-    HeapBlock curBlock;
-    if (virtualStorage.count(0) == 0) {
-        vector<long long> nodesIndex;
-        nodesIndex.push_back(0);
-        size_t readSize;
-        char* tmp = new char[nodesIndex.size() * storeBlockSize];
-        ocall_nread_heapStore(&readSize, nodesIndex.size(), nodesIndex.data(), tmp, nodesIndex.size() * storeBlockSize);
-        block ciphertext(tmp, tmp + readSize);
-        block buffer = AES::Decrypt(key, ciphertext, clen_size);
-        curBlock.data.assign(buffer.begin() + blockSize*Z, buffer.begin() + blockSize * (Z + 1));
-        delete tmp;
-    } else {
-        curBlock.data.assign(virtualStorage[0].subtree_min.data.begin(), virtualStorage[0].subtree_min.data.end());
-    }
-    HeapNode* minnode = convertBlockToNode(curBlock.data);
+    HeapNode* minnode = RootMin();
     for (int k = 0; k < minnode->value.size(); k++) {
         result[k] = minnode->value[k];
     }
@@ -453,6 +564,7 @@ void DOHEAP::insert(Bid k, array<byte_t, 16> v) {
     node->value = v;
     node->index = 1;
     node->isDummy = false;
+    UpdateLeaf(ElementID(v), node->pos, true);
     stash.insert(node);
     currentLeaf = RandomPath() / 2;
     FetchPath(currentLeaf);
@@ -463,6 +575,100 @@ void DOHEAP::insert(Bid k, array<byte_t, 16> v) {
     EvictBuckets();
 }
 
+/**
+ * Inserts the elements with the same two evictions per element as insert,
+ * but the paths of all evictions are read in one round trip, the subtree
+ * minimums are refreshed once per touched bucket and written back once
+ */
+void DOHEAP::batchInsert(const vector<pair<Bid, array<byte_t, 16> > >& elements) {
+    vector<long long> leaves;
+    for (unsigned int i = 0; i < elements.size(); i++) {
+        leaves.push_back(RandomPath() / 2);
+        leaves.push_back(RandomPath() / 2 + (maxOfRandom / 2));
+    }
+    LoadPaths(leaves);
+    if (leafOf != NULL) {
+        leafOf->beginBatch();
+    }
+
+    deferUpdateMin = true;
+    for (unsigned int i = 0; i < elements.size(); i++) {
+        HeapNode* node = new HeapNode();
+        node->pos = RandomPath();
+        node->key = elements[i].first;
+        node->value = elements[i].second;
+        node->index = 1;
+        node->isDummy = false;
+        UpdateLeaf(ElementID(node->value), node->pos, true);
+        stash.insert(node);
+        // one element enters the stash per two evictions, as in insert
+        for (int j = 0; j < 2; j++) {
+            currentLeaf = leaves[2 * i + j];
+            FetchPath(currentLeaf);
+            evict(true);
+        }
+    }
+    deferUpdateMin = false;
+    UpdateMin(pendingLeaves);
+    pendingLeaves.clear();
+    if (leafOf != NULL) {
+        leafOf->endBatch();
+    }
+    EvictBuckets();
+}
+
+/**
+ * Extracts count minimums in order. Every extraction still evicts the path
+ * of the minimum and a random path, but the random paths are read up front
+ * in one round trip, the path of the minimum is read together with the
+ * records its refresh needs, and the buckets are written back once
+ */
+vector<pair<Bid, array<byte_t, 16> > > DOHEAP::batchExtractMin(int count) {
+    vector<pair<Bid, array<byte_t, 16> > > res;
+    vector<long long> leaves;
+    for (int i = 0; i < count; i++) {
+        leaves.push_back(RandomPath() / 2 + (maxOfRandom / 2));
+    }
+    LoadPaths(leaves);
+    if (leafOf != NULL) {
+        leafOf->beginBatch();
+    }
+
+    deferUpdateMin = true;
+    for (int i = 0; i < count; i++) {
+        HeapNode* minnode = RootMin();
+        for (HeapNode* node : stash.nodes) {
+            bool isInStash = HeapNode::CTeq(-1, Bid::CTcmp(node->key, minnode->key)) && !node->isDummy;
+            HeapNode::conditional_assign(minnode, node, isInStash);
+        }
+        res.push_back(make_pair(minnode->key, minnode->value));
+        UpdateLeaf(ElementID(minnode->value), RandomPath(), true);
+
+        LoadPaths(vector<long long>(1, minnode->pos));
+        currentLeaf = minnode->pos;
+        FetchPath(currentLeaf);
+        for (HeapNode* node : stash.nodes) {
+            bool choice = HeapNode::CTeq(0, Bid::CTcmp(node->key, minnode->key)) && HeapNode::CTeq(0, Bid::CTcmp(node->value, minnode->value));
+            node->isDummy = HeapNode::conditional_select(true, node->isDummy, choice);
+            node->index = HeapNode::conditional_select((unsigned long long) 0, node->index, choice);
+        }
+        evict(true);
+        currentLeaf = leaves[i];
+        FetchPath(currentLeaf);
+        evict(true);
+        // both paths in one refresh, the next minimum depends on it
+        UpdateMin(pendingLeaves);
+        pendingLeaves.clear();
+        delete minnode;
+    }
+    deferUpdateMin = false;
+    if (leafOf != NULL) {
+        leafOf->endBatch();
+    }
+    EvictBuckets();
+    return res;
+}
+
 void DOHEAP::dummy() {
     currentLeaf = RandomPath() / 2;
     FetchPath(currentLeaf);
@@ -474,8 +680,15 @@ void DOHEAP::dummy() {
 }
 
 /**
- * @param OP:1 extract-min  2:insert    3: dummy
- * @return 
+ * Every operation type fetches a random path of the whole tree, the path of
+ * the minimum for an extraction and of the element for a decrease, then a
+ * random path of the right half, and makes one access to the leaf map, so
+ * the type is not revealed. The id of an element is the integer in the
+ * first 8 bytes of its value. Only ids 0..maxSize of a heap set up with
+ * decreaseKey are tracked, decrease-key finds no element with another id.
+ * @param OP:1 extract-min  2:insert    3: dummy    4: decrease-key of the element with id v to k
+ * @return extract-min: the minimum, decrease-key: the key of the element
+ * before the call (infinity if no element has that id)
  */
 pair<Bid,array<byte_t, 16> > DOHEAP::execute(Bid k, array<byte_t, 16> v, int op) {
     pair<Bid,array<byte_t, 16> > res;
@@ -485,6 +698,9 @@ pair<Bid,array<byte_t, 16> > DOHEAP::execute(Bid k, array<byte_t, 16> v, int op)
     dummyKey.setInfinity();
     bool isInsert = HeapNode::CTeq(op, 2);
     bool isExtract = HeapNode::CTeq(op, 1);
+    bool isDecrease = HeapNode::CTeq(op, 4);
+    unsigned long long id = ElementID(v);
+    bool tracked = Tracked(id);
     node->key = Bid::conditional_select(k, dummyKey, isInsert);
     node->value = v;
     node->index = HeapNode::conditional_select(1, 0, isInsert);
@@ -492,21 +708,7 @@ pair<Bid,array<byte_t, 16> > DOHEAP::execute(Bid k, array<byte_t, 16> v, int op)
     stash.insert(node);
 
     array<byte_t, 16> result;
-    HeapBlock curBlock;
-    if (virtualStorage.count(0) == 0) {
-        vector<long long> nodesIndex;
-        nodesIndex.push_back(0);
-        size_t readSize;
-        char* tmp = new char[nodesIndex.size() * storeBlockSize];
-        ocall_nread_heapStore(&readSize, nodesIndex.size(), nodesIndex.data(), tmp, nodesIndex.size() * storeBlockSize);
-        block ciphertext(tmp, tmp + readSize);
-        block buffer = AES::Decrypt(key, ciphertext, clen_size);
-        curBlock.data.assign(buffer.begin() + blockSize*Z, buffer.begin() + blockSize * (Z + 1));
-        delete tmp;
-    } else {
-        curBlock.data.assign(virtualStorage[0].subtree_min.data.begin(), virtualStorage[0].subtree_min.data.end());
-    }
-    HeapNode* rootnode = convertBlockToNode(curBlock.data);
+    HeapNode* rootnode = RootMin();
     HeapNode* minnode = new HeapNode();
     HeapNode::conditional_assign(minnode,rootnode,true);
     bool isInStash=false;
@@ -522,14 +724,32 @@ pair<Bid,array<byte_t, 16> > DOHEAP::execute(Bid k, array<byte_t, 16> v, int op)
     res.second = result;
     res.first = minnode->key;
 
-    currentLeaf = RandomPath() / 2;
+    // an inserted or decreased element moves to node->pos, an extracted one leaves a fresh leaf behind
+    unsigned long long targetID = HeapNode::conditional_select(ElementID(minnode->value), id, isExtract);
+    unsigned long long targetLeaf = HeapNode::conditional_select(RandomPath(), node->pos, isExtract);
+    unsigned long long lastLeaf = UpdateLeaf(targetID, targetLeaf, isInsert || isExtract || isDecrease);
+
+    currentLeaf = RandomPath();
     currentLeaf = HeapNode::conditional_select(minnode->pos, (unsigned long long) currentLeaf, isExtract);
+    currentLeaf = HeapNode::conditional_select(lastLeaf, (unsigned long long) currentLeaf, isDecrease);
 
     FetchPath(currentLeaf);
+    Bid lastKey = dummyKey;
     for (HeapNode* node : stash.nodes) {
         bool choice = HeapNode::CTeq(0, Bid::CTcmp(node->key, minnode->key)) && isExtract && HeapNode::CTeq(0, Bid::CTcmp(node->value, minnode->value));
         node->isDummy = HeapNode::conditional_select(true, node->isDummy, choice);
         node->index = HeapNode::conditional_select((unsigned long long) 0, node->index, choice);
+
+        // the subtree minimums on the path are refreshed by the eviction
+        bool target = isDecrease && tracked && !node->isDummy && HeapNode::CTeq(ElementID(node->value), id);
+        bool lower = HeapNode::CTeq(-1, Bid::CTcmp(k, node->key));
+        lastKey = Bid::conditional_select(node->key, lastKey, target);
+        node->key = Bid::conditional_select(k, node->key, target && lower);
+        node->pos = HeapNode::conditional_select(targetLeaf, node->pos, target);
+    }
+    res.first = Bid::conditional_select(lastKey, res.first, isDecrease);
+    for (int i = 0; i < res.second.size(); i++) {
+        res.second[i] = HeapNode::conditional_select(v[i], res.second[i], isDecrease);
     }
     evict(true);
     currentLeaf = RandomPath() / 2 + (maxOfRandom / 2);
@@ -559,9 +779,10 @@ block DOHEAP::convertNodeToBlock(HeapNode* node) {
 void DOHEAP::evict(bool evictBuckets) {
     double time;
 
-    ocall_start_timer(15);
-    if (profile) {
+    if (profile || beginProfile) {
         ocall_start_timer(15);
+    }
+    if (profile) {
         ocall_start_timer(10);
     }
 
@@ -576,6 +797,7 @@ void DOHEAP::evict(bool evictBuckets) {
     }
 
 
+    unsigned long long traceStart = Trace::now();
     for (HeapNode* node : stash.nodes) {
         long long xorVal = 0;
         xorVal = HeapNode::conditional_select((unsigned long long) 0, node->pos ^ currentLeaf, node->isDummy);
@@ -593,6 +815,8 @@ void DOHEAP::evict(bool evictBuckets) {
 
     }
 
+    Trace::record(TRACE_ASSIGN, traceStart);
+
     if (profile) {
         ocall_stop_timer(&time, 10);
         printf("Assigning stash blocks to lowest possible level:%f\n", time);
@@ -622,7 +846,9 @@ void DOHEAP::evict(bool evictBuckets) {
         ocall_start_timer(10);
     }
 
+    traceStart = Trace::now();
     HeapObliviousOperations::oblixmergesort(&stash.nodes);
+    Trace::record(TRACE_SORT, traceStart);
 
     if (beginProfile) {
         ocall_stop_timer(&time, 10);
@@ -640,6 +866,7 @@ void DOHEAP::evict(bool evictBuckets) {
     int level = depth;
     int counter = 0;
 
+    traceStart = Trace::now();
     for (unsigned long long i = 0; i < stash.nodes.size(); i++) {
         HeapNode* curNode = stash.nodes[i];
         bool firstCond = (!HeapNode::CTeq(HeapNode::CTcmp(counter - (depth - level) * Z, Z), -1));
@@ -700,6 +927,8 @@ void DOHEAP::evict(bool evictBuckets) {
         times[2].push_back(time);
     }
 
+    Trace::record(TRACE_ASSIGN, traceStart);
+
     if (profile) {
         ocall_stop_timer(&time, 10);
         printf("Sequential Scan on Stash Blocks to assign blocks to blocks:%f\n", time);
@@ -707,7 +936,9 @@ void DOHEAP::evict(bool evictBuckets) {
     }
 
     //    HeapObliviousOperations::compaction(&stash.nodes);
+    traceStart = Trace::now();
     HeapObliviousOperations::oblixmergesort(&stash.nodes);
+    Trace::record(TRACE_SORT, traceStart);
 
     if (profile) {
         ocall_stop_timer(&time, 10);
@@ -717,8 +948,6 @@ void DOHEAP::evict(bool evictBuckets) {
 
     unsigned int j = 0;
     HeapBucket* bucket = new HeapBucket();
-    bucket->subtree_min.id = 0;
-    bucket->subtree_min.data.resize(blockSize, 0);
     for (int i = 0; i < (depth + 1) * Z; i++) {
         HeapNode* cureNode = stash.nodes[i];
         long long curBucketID = cureNode->evictionNode;
@@ -737,8 +966,6 @@ void DOHEAP::evict(bool evictBuckets) {
             virtualStorage[curBucketID] = (*bucket);
             delete bucket;
             bucket = new HeapBucket();
-            bucket->subtree_min.id = 0;
-            bucket->subtree_min.data.resize(blockSize, 0);
             j = 0;
         }
     }
@@ -752,6 +979,16 @@ void DOHEAP::evict(bool evictBuckets) {
 
     stash.nodes.erase(stash.nodes.begin(), stash.nodes.begin()+((depth + 1) * Z));
 
+    int occupancy = 0;
+    for (unsigned int i = 0; i < stash.nodes.size(); i++) {
+        occupancy = HeapNode::conditional_select(occupancy, occupancy + 1, stash.nodes[i]->isDummy);
+    }
+    stashStats.record(occupancy);
+    IOStats::stash(occupancy);
+    if (occupancy > (int) PERMANENT_STASH_SIZE) {
+        printf("Stash overflow: %d real blocks, permanent stash size %d\n", occupancy, PERMANENT_STASH_SIZE);
+    }
+
     for (unsigned int i = PERMANENT_STASH_SIZE; i < stash.nodes.size(); i++) {
         delete stash.nodes[i];
     }
@@ -769,7 +1006,11 @@ void DOHEAP::evict(bool evictBuckets) {
         ocall_start_timer(10);
     }
 
-    UpdateMin();
+    if (deferUpdateMin) {
+        pendingLeaves.push_back(currentLeaf);
+    } else {
+        UpdateMin();
+    }
 
     if (beginProfile) {
         ocall_stop_timer(&time, 10);
@@ -795,6 +1036,60 @@ void DOHEAP::evict(bool evictBuckets) {
     }
 }
 
+void DOHEAP::InitializeLeaves(long long maxSize, bool decreaseKey) {
+    if (!decreaseKey) {
+        return;
+    }
+    // one more entry than ids takes the updates of the ids that are not tracked
+    trackedIds = (unsigned long long) maxSize + 1;
+    vector<array<byte_t, 16> > packed((trackedIds + LEAVES_PER_BLOCK) / LEAVES_PER_BLOCK);
+    for (array<byte_t, 16>& entries : packed) {
+        for (int s = 0; s < LEAVES_PER_BLOCK; s++) {
+            unsigned int leaf = (unsigned int) RandomPath();
+            std::memcpy(entries.data() + s * sizeof (unsigned int), &leaf, sizeof (unsigned int));
+        }
+    }
+    leafOf = new ObliviousArray((long long) packed.size(), key, &packed);
+}
+
+bool DOHEAP::Tracked(unsigned long long id) {
+    unsigned __int128 difference = (unsigned __int128) id - (unsigned __int128) trackedIds;
+    return (bool) (difference >> 127);
+}
+
+unsigned long long DOHEAP::UpdateLeaf(unsigned long long id, unsigned long long leaf, bool write) {
+    unsigned long long fresh = RandomPath();
+    if (leafOf == NULL) {
+        return fresh;
+    }
+    bool tracked = Tracked(id);
+    unsigned long long entry = HeapNode::conditional_select(id, trackedIds, tracked);
+    int slot = (int) (entry % LEAVES_PER_BLOCK);
+    unsigned int stored = (unsigned int) leaf;
+    array<byte_t, 16> value, mask;
+    for (int s = 0; s < LEAVES_PER_BLOCK; s++) {
+        std::memcpy(value.data() + s * sizeof (unsigned int), &stored, sizeof (unsigned int));
+        byte_t selected = HeapNode::conditional_select((byte_t) 0xFF, (byte_t) 0, HeapNode::CTeq(s, slot) && write);
+        std::fill(mask.begin() + s * sizeof (unsigned int), mask.begin() + (s + 1) * sizeof (unsigned int), selected);
+    }
+    array<byte_t, 16> old = leafOf->access((long long) (entry / LEAVES_PER_BLOCK), value, mask);
+    unsigned int last = 0;
+    for (int s = 0; s < LEAVES_PER_BLOCK; s++) {
+        unsigned int candidate;
+        std::memcpy(&candidate, old.data() + s * sizeof (unsigned int), sizeof (unsigned int));
+        last = HeapNode::conditional_select(candidate, last, HeapNode::CTeq(s, slot));
+    }
+    return HeapNode::conditional_select((unsigned long long) last, fresh, tracked);
+}
+
+unsigned long long DOHEAP::ElementID(const array<byte_t, 16>& v) {
+    unsigned long long id = 0;
+    for (int i = 0; i < 8; i++) {
+        id |= (unsigned long long) v[i] << (i * 8);
+    }
+    return id;
+}
+
 void DOHEAP::start(bool isBatchWrite) {
     this->batchWrite = isBatchWrite;
     readCnt = 0;
@@ -806,14 +1101,15 @@ unsigned long long DOHEAP::RandomPath() {
     return val % (maxOfRandom);
 }
 
-DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, vector<HeapNode*>* nodes, map<unsigned long long, unsigned long long> permutation)
+DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, vector<HeapNode*>* nodes, map<unsigned long long, unsigned long long> permutation, bool decreaseKey)
 : key(oram_key) {
     depth = (int) (ceil(log2(maxSize)) - 1) + 1;
     maxOfRandom = (long long) (pow(2, depth));
     AES::Setup();
     bucketCount = maxOfRandom * 2 - 1;
     INF = 9223372036854775807 - (bucketCount);
-    PERMANENT_STASH_SIZE = 90;
+    PERMANENT_STASH_SIZE = StashConfig::PermanentStashSize(Z, maxSize);
+    stashStats.reset(PERMANENT_STASH_SIZE);
     stash.preAllocate(PERMANENT_STASH_SIZE * 4);
     printf("Number of leaves:%lld\n", maxOfRandom);
     printf("depth:%lld\n", depth);
@@ -825,7 +1121,8 @@ DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, vector<HeapNode*>* nodes,
     storeBlockSize = (size_t) (IV + AES::GetCiphertextLength((int) (Z * (blockSize))));
     clen_size = AES::GetCiphertextLength((int) (blockSize) * Z);
     plaintext_size = (blockSize) * Z;
-    ocall_setup_heapStore(blockCount, storeBlockSize);
+    ocall_setup_heapStore(&storeHandle, blockCount, storeBlockSize);
+    CheckStore(storeHandle);
     maxHeightOfAVLTree = (int) floor(log2(blockCount)) + 1;
 
     unsigned long long first_leaf = bucketCount / 2;
@@ -842,10 +1139,13 @@ DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, vector<HeapNode*>* nodes,
 
 
 
+    InitializeLeaves(maxSize, decreaseKey);
+    InitializeMetadata(false);
     int i;
     for (i = 0; i < nodes->size(); i++) {
         (*nodes)[i]->pos = permutation[i];
         (*nodes)[i]->evictionNode = first_leaf + (*nodes)[i]->pos;
+        UpdateLeaf(ElementID((*nodes)[i]->value), (*nodes)[i]->pos, true);
     }
 
     if (beginProfile) {
@@ -928,7 +1228,9 @@ DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, vector<HeapNode*>* nodes,
             cipherSize = ciphertext.size();
         }
         if (min((int) (indexes.size() - j * 10000), 10000) != 0) {
-            ocall_nwrite_heapStore(min((int) (indexes.size() - j * 10000), 10000), indexes.data() + j * 10000, (const char*) tmp, cipherSize * min((int) (indexes.size() - j * 10000), 10000));
+            ocall_nwrite_heapStore(storeHandle, min((int) (indexes.size() - j * 10000), 10000), indexes.data() + j * 10000, (const char*) tmp, cipherSize * min((int) (indexes.size() - j * 10000), 10000));
+            IOStats::ocall(min((int) (indexes.size() - j * 10000), 10000) * sizeof (long long) + cipherSize * min((int) (indexes.size() - j * 10000), 10000), 0);
+            IOStats::bucketsWritten(min((int) (indexes.size() - j * 10000), 10000));
         }
         delete tmp;
     }
@@ -975,7 +1277,9 @@ DOHEAP::DOHEAP(long long maxSize, bytes<Key> oram_key, vector<HeapNode*>* nodes,
             cipherSize = ciphertext.size();
         }
         if (min((int) (indexes.size() - j * 10000), 10000) != 0) {
-            ocall_nwrite_heapStore(min((int) (indexes.size() - j * 10000), 10000), indexes.data() + j * 10000, (const char*) tmp, cipherSize * min((int) (indexes.size() - j * 10000), 10000));
+            ocall_nwrite_heapStore(storeHandle, min((int) (indexes.size() - j * 10000), 10000), indexes.data() + j * 10000, (const char*) tmp, cipherSize * min((int) (indexes.size() - j * 10000), 10000));
+            IOStats::ocall(min((int) (indexes.size() - j * 10000), 10000) * sizeof (long long) + cipherSize * min((int) (indexes.size() - j * 10000), 10000), 0);
+            IOStats::bucketsWritten(min((int) (indexes.size() - j * 10000), 10000));
         }
         delete tmp;
     }
@@ -9,11 +9,24 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <cstring>
 #include "Bid.h"
 #include "LocalRAMStore.hpp"
+#include "StashConfig.hpp"
 
 using namespace std;
 
+// Bytes of padding after the fields of a HeapNode. Every block of a bucket has
+// the same size whatever it holds, so none is needed to hide the contents, it
+// can be set at build time to measure other block sizes
+#ifndef HEAP_NODE_PADDING
+#define HEAP_NODE_PADDING 0
+#endif
+
+/**
+ * Fields are ordered by size so the node has no holes besides the tail, the
+ * conditional swaps then work on whole words
+ */
 class HeapNode {
 public:
 
@@ -23,24 +36,15 @@ public:
     ~HeapNode() {
     }
     unsigned long long index;
-    std::array< byte_t, 16> value;
-    Bid key;
     unsigned long long pos;
     long long evictionNode;
+    std::array< byte_t, 16> value;
+    Bid key;
     bool isDummy;
-    //    int compactionLeft;
-    std::array< byte_t, 64> dum;
+    std::array< byte_t, HEAP_NODE_PADDING> dum;
 
     static HeapNode* clone(HeapNode* oldNode) {
-        HeapNode* newNode = new HeapNode();
-        newNode->evictionNode = oldNode->evictionNode;
-        newNode->index = oldNode->index;
-        newNode->pos = oldNode->pos;
-        newNode->value = oldNode->value;
-        newNode->key = oldNode->key;
-        newNode->isDummy = oldNode->isDummy;
-        newNode->dum = oldNode->dum;
-        return newNode;
+        return new HeapNode(*oldNode);
     }
 
     /**
@@ -100,62 +104,46 @@ public:
     }
 
     /**
-     * constant time selector
+     * constant time swap of the whole node, word by word, each word read
+     * and written with memcpy since a HeapNode is not an array of words
      * @param a
      * @param b
      * @param choice 0 or 1
-     * @return choice = 1 -> a , choice = 0 -> return b
+     * @return choice = 1 -> a and b swapped , choice = 0 -> unchanged
      */
     static void conditional_swap(HeapNode* a, HeapNode* b, int choice) {
-        HeapNode tmp = *b;
-        for (int k = 0; k < b->value.size(); k++) {
-            b->value[k] = HeapNode::conditional_select(a->value[k], b->value[k], choice);
+        unsigned long long mask = ~((unsigned long long) choice - 1);
+        byte_t* pa = reinterpret_cast<byte_t*> (a);
+        byte_t* pb = reinterpret_cast<byte_t*> (b);
+        for (size_t i = 0; i < sizeof (HeapNode); i += sizeof (unsigned long long)) {
+            unsigned long long wa, wb;
+            std::memcpy(&wa, pa + i, sizeof (wa));
+            std::memcpy(&wb, pb + i, sizeof (wb));
+            unsigned long long t = (wa ^ wb) & mask;
+            wa ^= t;
+            wb ^= t;
+            std::memcpy(pa + i, &wa, sizeof (wa));
+            std::memcpy(pb + i, &wb, sizeof (wb));
         }
-        for (int k = 0; k < b->key.id.size(); k++) {
-            b->key.id[k] = HeapNode::conditional_select(a->key.id[k], b->key.id[k], choice);
-        }
-        b->index = HeapNode::conditional_select((long long) a->index, (long long) b->index, choice);
-        b->isDummy = HeapNode::conditional_select(a->isDummy, b->isDummy, choice);
-        b->pos = HeapNode::conditional_select((long long) a->pos, (long long) b->pos, choice);
-        for (int k = 0; k < b->dum.size(); k++) {
-            b->dum[k] = HeapNode::conditional_select(a->dum[k], b->dum[k], choice);
-        }
-        b->evictionNode = HeapNode::conditional_select(a->evictionNode, b->evictionNode, choice);
-        a->index = HeapNode::conditional_select((long long) tmp.index, (long long) a->index, choice);
-        for (int k = 0; k < b->value.size(); k++) {
-            a->value[k] = HeapNode::conditional_select(tmp.value[k], a->value[k], choice);
-        }
-        for (int k = 0; k < a->key.id.size(); k++) {
-            a->key.id[k] = HeapNode::conditional_select(tmp.key.id[k], a->key.id[k], choice);
-        }
-        a->isDummy = HeapNode::conditional_select(tmp.isDummy, a->isDummy, choice);
-        a->pos = HeapNode::conditional_select((long long) tmp.pos, (long long) a->pos, choice);
-        for (int k = 0; k < b->dum.size(); k++) {
-            a->dum[k] = HeapNode::conditional_select(tmp.dum[k], a->dum[k], choice);
-        }
-        a->evictionNode = HeapNode::conditional_select(tmp.evictionNode, a->evictionNode, choice);
     }
 
     /**
-     * constant time selector
+     * constant time copy of the whole node, word by word
      * @param a
      * @param b
      * @param choice 0 or 1
      * @return choice = 1 -> b->a , choice = 0 -> return a->a
      */
     static void conditional_assign(HeapNode* a, HeapNode* b, int choice) {
-        a->index = HeapNode::conditional_select((long long) b->index, (long long) a->index, choice);
-        a->isDummy = HeapNode::conditional_select(b->isDummy, a->isDummy, choice);
-        a->pos = HeapNode::conditional_select((long long) b->pos, (long long) a->pos, choice);
-        for (int k = 0; k < b->value.size(); k++) {
-            a->value[k] = HeapNode::conditional_select(b->value[k], a->value[k], choice);
-        }
-        for (int k = 0; k < b->dum.size(); k++) {
-            a->dum[k] = HeapNode::conditional_select(b->dum[k], a->dum[k], choice);
-        }
-        a->evictionNode = HeapNode::conditional_select(b->evictionNode, a->evictionNode, choice);
-        for (int k = 0; k < a->key.id.size(); k++) {
-            a->key.id[k] = HeapNode::conditional_select(b->key.id[k], a->key.id[k], choice);
+        unsigned long long mask = ~((unsigned long long) choice - 1);
+        byte_t* pa = reinterpret_cast<byte_t*> (a);
+        const byte_t* pb = reinterpret_cast<const byte_t*> (b);
+        for (size_t i = 0; i < sizeof (HeapNode); i += sizeof (unsigned long long)) {
+            unsigned long long wa, wb;
+            std::memcpy(&wa, pa + i, sizeof (wa));
+            std::memcpy(&wb, pb + i, sizeof (wb));
+            wa ^= (wa ^ wb) & mask;
+            std::memcpy(pa + i, &wa, sizeof (wa));
         }
     }
 
@@ -200,6 +188,8 @@ public:
     }
 };
 
+static_assert(sizeof (HeapNode) % sizeof (unsigned long long) == 0, "HeapNode is swapped word-wise");
+
 struct HeapBlock {
     unsigned long long id;
     block data;
@@ -208,7 +198,18 @@ struct HeapBlock {
 class HeapBucket {
 public:
     std::array<HeapBlock, Z> blocks;
-    HeapBlock subtree_min;
+};
+
+/**
+ * Minimum of the subtree below a bucket. The records are kept apart from the
+ * buckets, so a refresh reads the records of the siblings instead of the
+ * siblings' buckets.
+ */
+struct HeapMin {
+    unsigned long long index; // 0 if the subtree is empty
+    unsigned long long pos;
+    std::array<byte_t, 16> value;
+    Bid key;
 };
 
 class HeapCache {
@@ -224,8 +225,12 @@ public:
     };
 };
 
+class ObliviousArray;
+
 class DOHEAP {
 private:
+    friend class Microbenchmark;
+    friend class HeapTest;
 
     unsigned int PERMANENT_STASH_SIZE;
 
@@ -244,6 +249,11 @@ private:
     LocalRAMStore* localStore;
     bool useLocalRamStore = false;
     int storeBlockSize;
+    int storeHandle = -1; // untrusted store holding the buckets
+    static const int LEAVES_PER_BLOCK = 4;
+    // leaf of the element with each id 0..maxSize, four to a block, only kept for decrease-key
+    ObliviousArray* leafOf = NULL;
+    unsigned long long trackedIds = 0; // ids below it are in leafOf
 
 
     long long GetNodeOnPath(long long leaf, int depth);
@@ -258,6 +268,41 @@ private:
     void WriteBuckets(vector<long long> indexes, vector<HeapBucket> buckets);
     void EvictBuckets();
     void UpdateMin();
+    // refreshes the subtree minimums on all paths, each bucket once
+    void UpdateMin(const vector<long long>& leaves);
+    void RefreshMin(long long node, int level);
+    // reads the buckets not held in the enclave in one round trip, without adding their blocks to the stash
+    void LoadBuckets(vector<long long> indexes);
+    // the buckets an eviction of leaf touches and the records its UpdateMin needs
+    void LoadPaths(const vector<long long>& leaves);
+    bool deferUpdateMin = false; // evict leaves the refresh to the batch that called it
+    vector<long long> pendingLeaves;
+
+    // subtree minimums, in the enclave for small heaps, otherwise encrypted in their own store
+    bool metadataInEnclave;
+    vector<HeapMin> subtreeMins;
+    unordered_map<long long, HeapMin> metadataCache;
+    int metadataHandle = -1;
+    int metadataBlockSize;
+    size_t metadata_clen_size;
+
+    void InitializeMetadata(bool simulation);
+    // reads the records not held in the enclave in one round trip
+    void LoadMetadata(vector<long long> indexes);
+    void EvictMetadata();
+    // the record of a bucket, it has to be loaded first
+    HeapMin& SubtreeMin(long long index);
+    HeapNode* RootMin();
+    void InitializeLeaves(long long maxSize, bool decreaseKey);
+    /**
+     * Reads the leaf of id and, if write is set, replaces it with leaf, with
+     * one access to leafOf whatever the id. An id that is not tracked goes
+     * to the spare entry past the last one.
+     * @return the previous leaf of id, a random leaf if id is not tracked
+     */
+    unsigned long long UpdateLeaf(unsigned long long id, unsigned long long leaf, bool write);
+    bool Tracked(unsigned long long id);
+    static unsigned long long ElementID(const array<byte_t, 16>& v);
 
 
 
@@ -267,8 +312,13 @@ private:
     void WriteBucket(long long index, HeapBucket bucket);
 
 public:
-    DOHEAP(long long maxSize, bytes<Key> key, bool simulation);
-    DOHEAP(long long maxSize, bytes<Key> oram_key, vector<HeapNode*>* nodes, map<unsigned long long, unsigned long long> permutation);
+    /**
+     * @param decreaseKey keeps the leaf of every id 0..maxSize in an
+     * ObliviousArray, which every operation then updates. Without it
+     * decrease-key finds no element and the other operations skip the map.
+     */
+    DOHEAP(long long maxSize, bytes<Key> key, bool simulation, bool decreaseKey = false);
+    DOHEAP(long long maxSize, bytes<Key> oram_key, vector<HeapNode*>* nodes, map<unsigned long long, unsigned long long> permutation, bool decreaseKey = false);
     ~DOHEAP();
     double evicttime = 0;
     int evictcount = 0;
@@ -278,6 +328,12 @@ public:
     vector<vector<double> > times;
     bool beginProfile = false;
 
+    /**
+     * Heaps whose subtree minimum records take at most this many bytes keep
+     * them in the enclave, applies to heaps set up afterwards
+     */
+    static long long metadataInEnclaveLimit;
+
     unsigned long long RandomPath();
     void start(bool batchWrite);
     void insert(Bid k, array< byte_t, 16> v);
@@ -285,8 +341,11 @@ public:
     array< byte_t, 16> findMin();
     void dummy();
     pair<Bid,array<byte_t, 16> > execute(Bid k, array<byte_t, 16> v, int op);
+    void batchInsert(const vector<pair<Bid, array<byte_t, 16> > >& elements);
+    vector<pair<Bid, array<byte_t, 16> > > batchExtractMin(int count);
     void evict(bool evictBuckets = false);
     bool profile = false;
+    StashStats stashStats;
 };
 
 #endif
@@ -0,0 +1,248 @@
+#include "EdgeListGraph.hpp"
+#include "ObliviousOperations.h"
+
+const long long EdgeListGraph::INF_HOPS = 1LL << 62;
+
+EdgeListGraph::EdgeListGraph(int vertexCount, const vector<GraphEntry>& edges)
+: vertexCount(vertexCount), entries(edges) {
+    for (int v = 1; v <= vertexCount; v++) {
+        GraphEntry record = {0, v, 0, 0, 0, 0};
+        entries.push_back(record);
+    }
+}
+
+void EdgeListGraph::propagate(long long step, int rounds) {
+    rounds = Bid::conditional_select(rounds, vertexCount - 1, Bid::CTeq(Bid::CTcmp((long long) rounds, 0LL), 1));
+    for (int round = 0; round < rounds; round++) {
+        // scatter: every vertex record is followed by its out-edges, which take its label
+        for (GraphEntry& entry : entries) {
+            entry.sortKey = ((unsigned long long) entry.source << 32) | (unsigned long long) entry.destination;
+        }
+        ObliviousOperations::bitonicSort(&entries);
+        long long carried = INF_HOPS;
+        for (GraphEntry& entry : entries) {
+            bool isRecord = Bid::CTeq(entry.destination, 0LL);
+            carried = Bid::conditional_select(entry.value, carried, isRecord);
+            long long message = carried + step;
+            message = Bid::conditional_select(INF_HOPS, message, Bid::CTeq(Bid::CTcmp(message, INF_HOPS), 1));
+            entry.value = Bid::conditional_select(entry.value, message, isRecord);
+        }
+
+        // gather: the edges into a vertex come right before its record, which keeps the smallest label
+        for (GraphEntry& entry : entries) {
+            bool isRecord = Bid::CTeq(entry.destination, 0LL);
+            long long target = Bid::conditional_select(entry.source, entry.destination, isRecord);
+            entry.sortKey = ((unsigned long long) target << 1) | (unsigned long long) isRecord;
+        }
+        ObliviousOperations::bitonicSort(&entries);
+        long long smallest = INF_HOPS;
+        unsigned long long previous = 0;
+        for (GraphEntry& entry : entries) {
+            bool isRecord = Bid::CTeq(entry.destination, 0LL);
+            unsigned long long target = entry.sortKey >> 1;
+            bool smaller = Bid::CTeq(Bid::CTcmp(entry.value, smallest), -1);
+            smallest = Bid::conditional_select(entry.value, smallest, smaller || !Bid::CTeq((long long) target, (long long) previous));
+            entry.value = Bid::conditional_select(smallest, entry.value, isRecord);
+            previous = target;
+        }
+    }
+}
+
+void EdgeListGraph::collect(long long* labels, size_t len) {
+    for (GraphEntry& entry : entries) {
+        bool isRecord = Bid::CTeq(entry.destination, 0LL);
+        entry.sortKey = Bid::conditional_select((unsigned long long) entry.source, 1ULL << 63, isRecord);
+    }
+    ObliviousOperations::bitonicSort(&entries);
+    for (size_t v = 0; v < len; v++) {
+        labels[v] = v >= 1 && v <= (size_t) vertexCount ? entries[v - 1].value : INF_HOPS;
+    }
+}
+
+void EdgeListGraph::bfs(int source, int rounds, long long* hops, size_t len) {
+    for (GraphEntry& entry : entries) {
+        entry.value = Bid::conditional_select(0LL, INF_HOPS, Bid::CTeq(entry.source, (long long) source));
+    }
+    propagate(1, rounds);
+    collect(hops, len);
+}
+
+void EdgeListGraph::components(int rounds, long long* labels, size_t len) {
+    for (GraphEntry& entry : entries) {
+        entry.value = entry.source;
+    }
+    propagate(0, rounds);
+    collect(labels, len);
+}
+
+void EdgeListGraph::follow(vector<long long>& pointer) {
+    vector<GraphEntry> join(2 * vertexCount);
+    for (int v = 1; v <= vertexCount; v++) {
+        GraphEntry owner = {(unsigned long long) v << 1, v, 0, 0, pointer[v], 0};
+        GraphEntry request = {((unsigned long long) pointer[v] << 1) | 1, v, pointer[v], 0, 0, 0};
+        join[v - 1] = owner;
+        join[vertexCount + v - 1] = request;
+    }
+    // every owner comes right before the requests for it
+    ObliviousOperations::bitonicSort(&join);
+    long long carried = 0;
+    for (GraphEntry& entry : join) {
+        bool isOwner = Bid::CTeq(entry.destination, 0LL);
+        carried = Bid::conditional_select(entry.value, carried, isOwner);
+        entry.value = Bid::conditional_select(entry.value, carried, isOwner);
+    }
+    for (GraphEntry& entry : join) {
+        bool isOwner = Bid::CTeq(entry.destination, 0LL);
+        entry.sortKey = Bid::conditional_select(1ULL << 63, (unsigned long long) entry.source, isOwner);
+    }
+    ObliviousOperations::bitonicSort(&join);
+    for (int v = 1; v <= vertexCount; v++) {
+        pointer[v] = join[v - 1].value;
+    }
+}
+
+static bool lighter(long long weight, long long low, long long high, long long otherWeight, long long otherLow, long long otherHigh) {
+    int byWeight = Bid::CTcmp(weight, otherWeight);
+    int byLow = Bid::CTcmp(low, otherLow);
+    int byHigh = Bid::CTcmp(high, otherHigh);
+    return Bid::CTeq(byWeight, -1) || (Bid::CTeq(byWeight, 0) && (Bid::CTeq(byLow, -1) || (Bid::CTeq(byLow, 0) && Bid::CTeq(byHigh, -1))));
+}
+
+void EdgeListGraph::spanningForest(long long& totalWeight, vector<GraphEntry>& forest) {
+    // a record holds the component label of its vertex, an edge the label of its source in value and
+    // the label of its destination shifted by one in extra, whose low bit tells if the edge was picked
+    for (GraphEntry& entry : entries) {
+        entry.value = entry.source;
+        entry.extra = 0;
+    }
+    int levels = 1;
+    while ((1LL << levels) < vertexCount) {
+        levels++;
+    }
+    long long count = (long long) entries.size();
+    vector<long long> bestWeight(count), bestLow(count), bestHigh(count);
+    vector<long long> pointer(vertexCount + 1), jumped;
+    for (int round = 0; round < levels; round++) {
+        // the label of the source: every vertex record is followed by its out-edges
+        for (GraphEntry& entry : entries) {
+            entry.sortKey = ((unsigned long long) entry.source << 32) | (unsigned long long) entry.destination;
+        }
+        ObliviousOperations::bitonicSort(&entries);
+        long long carried = 0;
+        for (GraphEntry& entry : entries) {
+            bool isRecord = Bid::CTeq(entry.destination, 0LL);
+            carried = Bid::conditional_select(entry.value, carried, isRecord);
+            entry.value = carried;
+        }
+
+        // the label of the destination: every vertex record is followed by its in-edges
+        for (GraphEntry& entry : entries) {
+            bool isRecord = Bid::CTeq(entry.destination, 0LL);
+            long long target = Bid::conditional_select(entry.source, entry.destination, isRecord);
+            entry.sortKey = ((unsigned long long) target << 1) | (unsigned long long) !isRecord;
+        }
+        ObliviousOperations::bitonicSort(&entries);
+        for (GraphEntry& entry : entries) {
+            bool isRecord = Bid::CTeq(entry.destination, 0LL);
+            carried = Bid::conditional_select(entry.value, carried, isRecord);
+            entry.extra = Bid::conditional_select(entry.extra, (carried << 1) | (entry.extra & 1), isRecord);
+        }
+
+        // the edges of a component come right before the record of the vertex that labels it, a forward
+        // scan leaves the lightest crossing edge in that record and a backward scan marks it
+        for (GraphEntry& entry : entries) {
+            bool isRecord = Bid::CTeq(entry.destination, 0LL);
+            long long group = Bid::conditional_select(entry.source, entry.value, isRecord);
+            entry.sortKey = ((unsigned long long) group << 1) | (unsigned long long) isRecord;
+        }
+        ObliviousOperations::bitonicSort(&entries);
+        long long weight = 0, low = 0, high = 0, label = 0;
+        bool valid = false;
+        unsigned long long previous = 0;
+        for (long long i = 0; i < count; i++) {
+            GraphEntry& entry = entries[i];
+            bool isRecord = Bid::CTeq(entry.destination, 0LL);
+            bool fresh = !Bid::CTeq((long long) (entry.sortKey >> 1), (long long) previous);
+            valid = valid && !fresh;
+            long long destinationLabel = entry.extra >> 1;
+            long long first = Bid::conditional_select(entry.source, entry.destination, Bid::CTeq(Bid::CTcmp(entry.source, entry.destination), -1));
+            long long second = entry.source + entry.destination - first;
+            bool crossing = !isRecord && !Bid::CTeq(entry.value, destinationLabel);
+            bool better = crossing && (!valid || lighter(entry.weight, first, second, weight, low, high));
+            weight = Bid::conditional_select(entry.weight, weight, better);
+            low = Bid::conditional_select(first, low, better);
+            high = Bid::conditional_select(second, high, better);
+            label = Bid::conditional_select(destinationLabel, label, better);
+            valid = valid || better;
+            bestWeight[i] = Bid::conditional_select(weight, -1LL, valid);
+            bestLow[i] = low;
+            bestHigh[i] = high;
+            // the record keeps the component its component is merged into, itself if there is none
+            entry.extra = Bid::conditional_select(Bid::conditional_select(label, entry.source, valid), entry.extra, isRecord);
+            previous = entry.sortKey >> 1;
+        }
+        previous = 0;
+        for (long long i = count - 1; i >= 0; i--) {
+            GraphEntry& entry = entries[i];
+            bool last = !Bid::CTeq((long long) (entry.sortKey >> 1), (long long) previous);
+            weight = Bid::conditional_select(bestWeight[i], weight, last);
+            low = Bid::conditional_select(bestLow[i], low, last);
+            high = Bid::conditional_select(bestHigh[i], high, last);
+            long long first = Bid::conditional_select(entry.source, entry.destination, Bid::CTeq(Bid::CTcmp(entry.source, entry.destination), -1));
+            long long second = entry.source + entry.destination - first;
+            bool picked = !Bid::CTeq(entry.destination, 0LL) && !Bid::CTeq(entry.value, entry.extra >> 1)
+                    && Bid::CTeq(entry.weight, weight) && Bid::CTeq(first, low) && Bid::CTeq(second, high);
+            entry.extra |= Bid::conditional_select(1LL, 0LL, picked);
+            previous = entry.sortKey >> 1;
+        }
+
+        // a component points to the one it is merged into, of two that point at each other the smaller
+        // one stays the root, and the other vertices point to their component
+        for (GraphEntry& entry : entries) {
+            bool isRecord = Bid::CTeq(entry.destination, 0LL);
+            entry.sortKey = Bid::conditional_select((unsigned long long) entry.source, 1ULL << 63, isRecord);
+        }
+        ObliviousOperations::bitonicSort(&entries);
+        for (int v = 1; v <= vertexCount; v++) {
+            const GraphEntry& record = entries[v - 1];
+            pointer[v] = Bid::conditional_select(record.extra, record.value, Bid::CTeq(record.value, (long long) v));
+        }
+        jumped = pointer;
+        follow(jumped);
+        for (int v = 1; v <= vertexCount; v++) {
+            bool mutual = Bid::CTeq(jumped[v], (long long) v) && Bid::CTeq(Bid::CTcmp((long long) v, pointer[v]), -1);
+            pointer[v] = Bid::conditional_select((long long) v, pointer[v], mutual);
+        }
+        for (int level = 0; level < levels; level++) {
+            follow(pointer);
+        }
+        for (int v = 1; v <= vertexCount; v++) {
+            entries[v - 1].value = pointer[v];
+        }
+    }
+
+    // both directions of an edge may be picked, the second one in (low, high) order is dropped
+    for (GraphEntry& entry : entries) {
+        long long first = Bid::conditional_select(entry.source, entry.destination, Bid::CTeq(Bid::CTcmp(entry.source, entry.destination), -1));
+        long long second = entry.source + entry.destination - first;
+        bool picked = !Bid::CTeq(entry.destination, 0LL) && Bid::CTeq(entry.extra & 1, 1LL);
+        entry.sortKey = Bid::conditional_select(((unsigned long long) first << 32) | (unsigned long long) second, ~0ULL, picked);
+    }
+    ObliviousOperations::bitonicSort(&entries);
+    totalWeight = 0;
+    long long kept = 0;
+    unsigned long long previous = ~0ULL;
+    for (GraphEntry& entry : entries) {
+        bool keep = !Bid::CTeq((long long) entry.sortKey, -1LL) && !Bid::CTeq((long long) entry.sortKey, (long long) previous);
+        previous = entry.sortKey;
+        entry.sortKey = Bid::conditional_select(0ULL, 1ULL, keep);
+        totalWeight += Bid::conditional_select(entry.weight, 0LL, keep);
+        kept += Bid::conditional_select(1LL, 0LL, keep);
+    }
+    ObliviousOperations::bitonicSort(&entries);
+    forest.assign(entries.begin(), entries.begin() + kept);
+}
+
+int EdgeListGraph::vertices() {
+    return vertexCount;
+}
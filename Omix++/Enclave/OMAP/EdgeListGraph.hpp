@@ -0,0 +1,69 @@
+#ifndef EDGELISTGRAPH_H
+#define EDGELISTGRAPH_H
+
+#include "GraphEntry.h"
+#include <vector>
+
+using namespace std;
+
+/**
+ * A graph kept as its edge list plus one record per vertex inside the
+ * enclave, for algorithms that propagate labels by oblivious sorts and
+ * scans instead of per-vertex OMAP lookups. Every round is two sorts of all
+ * V + E entries and two scans, and the number of rounds is a public bound,
+ * so the accesses depend only on V, E and the bound.
+ */
+class EdgeListGraph {
+private:
+    int vertexCount;
+    vector<GraphEntry> entries;
+
+    /**
+     * Runs the rounds on the labels of the vertex records. An edge carries
+     * the label of its source plus step, and a vertex keeps the smallest of
+     * its label and the labels carried to it.
+     */
+    void propagate(long long step, int rounds);
+    /**
+     * Sorts the vertex records to the front in vertex order
+     * @param labels label of every vertex id 0..vertexCount
+     */
+    void collect(long long* labels, size_t len);
+    /**
+     * Sets pointer[v] to pointer[pointer[v]] for every vertex with two sorts
+     * of one owner and one request entry per vertex
+     */
+    void follow(vector<long long>& pointer);
+
+public:
+    static const long long INF_HOPS;
+
+    /**
+     * @param edges directed edges, an undirected graph holds both directions
+     */
+    EdgeListGraph(int vertexCount, const vector<GraphEntry>& edges);
+
+    /**
+     * @param rounds public bound on the depth, vertexCount - 1 if not positive
+     * @param hops hops from source of every vertex id, INF_HOPS if it was not reached
+     */
+    void bfs(int source, int rounds, long long* hops, size_t len);
+    /**
+     * @param rounds public bound on the diameter, vertexCount - 1 if not positive
+     * @param labels smallest vertex id of the component of every vertex id
+     */
+    void components(int rounds, long long* labels, size_t len);
+    /**
+     * Borůvka in ceil(log2 V) rounds. A round gives every edge the component
+     * labels of its ends by two sorts, sorts the edges by the component of
+     * their source so one scan finds the lightest crossing edge of every
+     * component, and merges the components along those edges by pointer
+     * jumping. Ties are broken by the ends of an edge, so the picked edges
+     * never close a cycle.
+     * @param forest the edges of the forest as (source, destination, weight)
+     */
+    void spanningForest(long long& totalWeight, vector<GraphEntry>& forest);
+    int vertices();
+};
+
+#endif /* EDGELISTGRAPH_H */
@@ -0,0 +1,20 @@
+#ifndef GRAPHENTRY_H
+#define GRAPHENTRY_H
+
+/**
+ * One edge of an ingested graph, or the record of a vertex while a graph is
+ * built or a sort-and-scan algorithm runs. The struct is a multiple of 8
+ * bytes so it can be swapped word-wise.
+ */
+struct GraphEntry {
+    unsigned long long sortKey;
+    long long source;
+    long long destination; // 0 for a vertex record
+    long long weight;
+    long long value; // label or message of a sort-and-scan round
+    long long extra; // second word of state for rounds that need more than one
+};
+
+static_assert(sizeof (GraphEntry) % sizeof (unsigned long long) == 0, "GraphEntry is swapped word-wise");
+
+#endif /* GRAPHENTRY_H */
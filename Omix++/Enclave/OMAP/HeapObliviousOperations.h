@@ -1,5 +1,5 @@
-#ifndef OBLIVIOUSOPERATIONS_H
-#define OBLIVIOUSOPERATIONS_H
+#ifndef HEAPOBLIVIOUSOPERATIONS_H
+#define HEAPOBLIVIOUSOPERATIONS_H
 
 #include <vector>
 #include <cassert>
@@ -26,5 +26,5 @@ public:
 
 };
 
-#endif /* OBLIVIOUSOPERATIONS_H */
+#endif /* HEAPOBLIVIOUSOPERATIONS_H */
 
@@ -0,0 +1,69 @@
+#include "IOStats.hpp"
+#include "Bid.h"
+#include <cstring>
+
+long long IOStats::counters[IO_OPERATIONS][IO_COUNTERS];
+thread_local int IOStats::current = IO_OTHER;
+
+void IOStats::add(int counter, long long amount) {
+    __atomic_fetch_add(&counters[current][counter], amount, __ATOMIC_RELAXED);
+}
+
+void IOStats::beginEcall(int operation) {
+    current = operation;
+    add(IO_ECALLS, 1);
+}
+
+void IOStats::endEcall() {
+    current = IO_OTHER;
+}
+
+void IOStats::beginBatch() {
+    beginEcall(IO_OTHER);
+}
+
+void IOStats::setOperation(int operation) {
+    current = operation;
+}
+
+int IOStats::operation() {
+    return current;
+}
+
+void IOStats::ocall(size_t bytesOut, size_t bytesIn) {
+    add(IO_OCALLS, 1);
+    add(IO_BYTES_OUT, bytesOut);
+    add(IO_BYTES_IN, bytesIn);
+}
+
+void IOStats::bucketsRead(size_t count) {
+    add(IO_BUCKETS_READ, count);
+}
+
+void IOStats::bucketsWritten(size_t count) {
+    add(IO_BUCKETS_WRITTEN, count);
+}
+
+void IOStats::aes() {
+    add(IO_AES_CALLS, 1);
+}
+
+void IOStats::stash(int occupancy) {
+    add(IO_STASH_TOTAL, occupancy);
+    long long* max = &counters[current][IO_STASH_MAX];
+    long long seen = __atomic_load_n(max, __ATOMIC_RELAXED);
+    // retried only when another thread changed the maximum in between
+    while (!__atomic_compare_exchange_n(max, &seen, Bid::conditional_select((long long) occupancy, seen, Bid::CTeq(Bid::CTcmp((long long) occupancy, seen), 1)), false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void IOStats::get(int operation, long long* out, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        out[i] = (operation >= 0 && operation < IO_OPERATIONS && i < IO_COUNTERS) ? counters[operation][i] : 0;
+    }
+}
+
+void IOStats::reset() {
+    memset(counters, 0, sizeof (counters));
+    current = IO_OTHER;
+}
@@ -0,0 +1,66 @@
+#ifndef IOSTATS_H
+#define IOSTATS_H
+
+#include <cstddef>
+
+// Operation an ecall is accounted to
+enum IOOperation {
+    IO_OMAP_READ = 0,
+    IO_OMAP_WRITE,
+    IO_OMAP_DELETE,
+    IO_HEAP,
+    IO_OTHER,
+    IO_ARRAY,
+    IO_MULTIMAP,
+    IO_BLOB,
+    IO_OPERATIONS
+};
+
+enum IOCounter {
+    IO_ECALLS = 0,
+    IO_OCALLS,
+    IO_BYTES_IN, // untrusted -> enclave
+    IO_BYTES_OUT, // enclave -> untrusted
+    IO_BUCKETS_READ,
+    IO_BUCKETS_WRITTEN,
+    IO_AES_CALLS,
+    IO_STASH_TOTAL, // sum of the stash occupancy after every eviction
+    IO_STASH_MAX,
+    IO_COUNTERS
+};
+
+/**
+ * Boundary and crypto cost of every operation type. Each public ecall sets
+ * the operation it belongs to, and everything done until the next ecall is
+ * charged to that operation. The operation is tracked per enclave thread and
+ * the counters are updated atomically, so shards running in parallel can
+ * share them.
+ */
+class IOStats {
+private:
+    static long long counters[IO_OPERATIONS][IO_COUNTERS];
+    static thread_local int current;
+
+    static void add(int counter, long long amount);
+
+public:
+    static void beginEcall(int operation);
+    static void endEcall();
+    /**
+     * A batch ecall is counted once under IO_OTHER, the work of each request
+     * is charged to the operation set here
+     */
+    static void beginBatch();
+    static void setOperation(int operation);
+    static int operation();
+    static void ocall(size_t bytesOut, size_t bytesIn);
+    static void bucketsRead(size_t count);
+    static void bucketsWritten(size_t count);
+    static void aes();
+    static void stash(int occupancy);
+
+    static void get(int operation, long long* out, size_t len);
+    static void reset();
+};
+
+#endif /* IOSTATS_H */
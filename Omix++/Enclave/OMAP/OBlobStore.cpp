@@ -0,0 +1,109 @@
+#include "OBlobStore.hpp"
+#include "OMapEntry.hpp"
+#include <cstring>
+#include <algorithm>
+
+OBlobStore::OBlobStore(long long records, long long chunkCount, int chunkSize, int maxChunks, bytes<Key> key)
+: records(records), capacity(chunkCount), chunkSize(chunkSize), maxChunks(maxChunks) {
+    // one more entry for the padding key
+    omap = new OMAP((int) records + 1, key);
+    chunks = new ObliviousArray(chunkCount + 1, key, NULL, (size_t) chunkSize);
+    freeChunks = new OStack(chunkCount, key);
+}
+
+OBlobStore::~OBlobStore() {
+    delete omap;
+    delete chunks;
+    delete freeChunks;
+}
+
+static bool Less(long long a, long long b) {
+    return Node::CTeq(Node::CTcmp(a, b), -1);
+}
+
+long long OBlobStore::exchange(bool take, bool give, long long chunk) {
+    bool reuse = Node::CTeq(Node::CTcmp(freeChunks->size(), 0LL), 1);
+    array<byte_t, 16> block;
+    std::fill(block.begin(), block.end(), 0);
+    std::memcpy(block.data(), &chunk, sizeof (chunk));
+    freeChunks->execute(block, Node::conditional_select(1, Node::conditional_select(2, 3, give), take && reuse));
+    long long popped;
+    std::memcpy(&popped, block.data(), sizeof (popped));
+    long long taken = Node::conditional_select(popped, allocated + 1, reuse);
+    allocated = Node::conditional_select(allocated + 1, allocated, take && !reuse);
+    return taken;
+}
+
+bool OBlobStore::write(Bid key, const string& value) {
+    // the length of a value is public, the one it replaces is not
+    if (value.size() > (size_t) maxChunks * chunkSize || key == OMapEntry::PaddingKey()) {
+        return false;
+    }
+    long long first, length;
+    bool exists = OMapEntry::Find(omap, key, first, length);
+    long long oldCount = (length + chunkSize - 1) / chunkSize;
+    long long newCount = ((long long) value.size() + chunkSize - 1) / chunkSize;
+    bool done = !Less(oldCount + freeChunks->size() + capacity - allocated, newCount) && (exists || Less(keys, records));
+    newCount = Node::conditional_select(newCount, oldCount, done);
+
+    // chunk i of the old value becomes chunk i of the new one, so a next link only changes where the new
+    // value grows past the old one or ends before it, and the old chunks past its end are freed
+    long long current = exchange(Node::CTeq(oldCount, 0LL) && Less(0, newCount), false, 0);
+    current = Node::conditional_select(first, current, Less(0, oldCount));
+    long long newFirst = Node::conditional_select(current, 0LL, Less(0, newCount));
+    chunks->beginBatch();
+    for (int i = 0; i < maxChunks; i++) {
+        bool had = Less(i, oldCount);
+        bool need = Less(i, newCount);
+        bool grow = Less(i + 1, newCount) && !Less(i + 1, oldCount);
+        bool last = need && !Less(i + 1, newCount);
+        long long next = exchange(grow, had && !need, current);
+
+        array<byte_t, 16> link, mask;
+        std::fill(link.begin(), link.end(), 0);
+        long long written = Node::conditional_select(next, 0LL, grow);
+        std::memcpy(link.data(), &written, sizeof (written));
+        std::fill(mask.begin(), mask.end(), 0);
+        std::fill(mask.begin(), mask.begin() + 8, Node::conditional_select((byte_t) 0xFF, (byte_t) 0, grow || last));
+        block payload(chunkSize, 0);
+        size_t offset = std::min((size_t) i * chunkSize, value.size());
+        std::copy(value.begin() + offset, value.begin() + std::min(offset + chunkSize, value.size()), payload.begin());
+        array<byte_t, 16> old = chunks->access(Node::conditional_select(current, 0LL, had || need), link, mask, payload, need && done);
+        long long stored;
+        std::memcpy(&stored, old.data(), sizeof (stored));
+        current = Node::conditional_select(next, stored, grow);
+    }
+    chunks->endBatch();
+    keys = Node::conditional_select(keys + 1, keys, done && !exists);
+    // a failed write leaves the key as it is, or absent, and writes the padding key instead
+    omap->insert(Bid::conditional_select(key, OMapEntry::PaddingKey(), done), OMapEntry::Pack(newFirst, Node::conditional_select((long long) value.size(), length, done)));
+    return done;
+}
+
+string OBlobStore::read(Bid key) {
+    if (key == OMapEntry::PaddingKey()) {
+        return "";
+    }
+    long long first, length;
+    OMapEntry::Find(omap, key, first, length);
+    long long count = (length + chunkSize - 1) / chunkSize;
+    string value((size_t) maxChunks * chunkSize, '\0');
+    long long current = first;
+    array<byte_t, 16> none;
+    std::fill(none.begin(), none.end(), 0);
+    chunks->beginBatch();
+    for (int i = 0; i < maxChunks; i++) {
+        bool valid = Less(i, count);
+        block payload(chunkSize, 0);
+        array<byte_t, 16> link = chunks->access(Node::conditional_select(current, 0LL, valid), none, none, payload, false);
+        for (int k = 0; k < chunkSize; k++) {
+            value[(size_t) i * chunkSize + k] = (char) Node::conditional_select(payload[k], (byte_t) 0, valid);
+        }
+        long long next;
+        std::memcpy(&next, link.data(), sizeof (next));
+        current = Node::conditional_select(next, current, valid);
+    }
+    chunks->endBatch();
+    value.resize((size_t) length);
+    return value;
+}
@@ -0,0 +1,66 @@
+#ifndef OBLOBSTORE_H
+#define OBLOBSTORE_H
+
+#include "OMAP.h"
+#include "ObliviousArray.hpp"
+#include "OStack.hpp"
+
+/**
+ * Values longer than the 16 bytes of an OMAP node. The OMAP entry of a key
+ * holds a handle, the first chunk of the value and its length, and the bytes
+ * are split into chunks of chunkSize held as payloads of a second
+ * ObliviousArray, each chunk also holding the next one. Only the chunk
+ * array has the larger blocks, so the OMAP nodes keep their size. Chunks
+ * freed by shorter values are kept on an OStack for reuse. Values are
+ * bounded by a public maxChunks, so a read is one find and maxChunks chunk
+ * accesses and a write one find, maxChunks chunk accesses, maxChunks + 1
+ * stack accesses and one insert, whatever the length. A write that fails
+ * writes a reserved padding key instead of the key, so no entry is added
+ * for it, and at most records keys are held.
+ */
+class OBlobStore {
+private:
+    OMAP* omap;
+    ObliviousArray* chunks; // chunk 0 is never used and stands in for padding accesses
+    OStack* freeChunks;
+    long long records;
+    long long keys = 0;
+    long long capacity;
+    int chunkSize;
+    int maxChunks;
+    long long allocated = 0;
+
+    /**
+     * One stack access: pops a chunk if take is set, or takes the next one
+     * never used when the stack is empty, pushes chunk if give is set and
+     * peeks otherwise
+     * @return the chunk taken
+     */
+    long long exchange(bool take, bool give, long long chunk);
+
+public:
+    /**
+     * @param records keys held at once
+     * @param chunkCount chunks held at once over all values
+     * @param chunkSize bytes of a chunk
+     * @param maxChunks chunks of the longest value
+     */
+    OBlobStore(long long records, long long chunkCount, int chunkSize, int maxChunks, bytes<Key> key);
+    virtual ~OBlobStore();
+
+    /**
+     * Replaces the value of key, reusing the chunks of the old value in
+     * place and with the chunk buckets written back once for the write
+     * @return false if the value is longer than maxChunks chunks, which is
+     * known from its length and makes no access, or if there are not enough
+     * free chunks or the key is new and records keys are held, then the
+     * accesses are made and the old value is kept
+     */
+    bool write(Bid key, const string& value);
+    /**
+     * @return the value of key, empty if there is none
+     */
+    string read(Bid key);
+};
+
+#endif /* OBLOBSTORE_H */
@@ -12,14 +12,21 @@ OMAP::OMAP(int maxSize, bytes<Key> secretKey, map<Bid, string>* pairs, map<unsig
     treeHandler = new AVLTree(maxSize, secretKey, rootKey, rootPos, pairs, permutation);
 }
 
-OMAP::OMAP(int maxSize, Bid rootBid,long long rootPos,bytes<Key> secretKey){
-    treeHandler = new AVLTree(maxSize, secretKey,false);
+/**
+ * Bulk construction from pairs sorted by key, without an insert per pair
+ */
+OMAP::OMAP(int maxSize, bytes<Key> secretKey, vector<pair<Bid, string> >* sortedPairs) {
+    treeHandler = new AVLTree(maxSize, secretKey, rootKey, rootPos, sortedPairs);
+}
+
+OMAP::OMAP(int maxSize, Bid rootBid, long long rootPos, bytes<Key> secretKey, int store) {
+    treeHandler = new AVLTree(maxSize, secretKey, false, store);
     this->rootKey = rootBid;
     this->rootPos = rootPos;
 }
 
 OMAP::~OMAP() {
-
+    delete treeHandler;
 }
 
 string OMAP::find(Bid omapKey) {
@@ -42,7 +49,7 @@ string OMAP::find(Bid omapKey) {
         treeHandler->times[2].push_back(y);
         ocall_start_timer(950);
     }
-    treeHandler->finishOperation();
+    treeHandler->finishOperation(!batched);
     if (treeHandler->logTime) {
         ocall_stop_timer(&y, 950);
         treeHandler->times[3].push_back(y);
@@ -73,7 +80,7 @@ void OMAP::deleteNode(Bid omapKey) {
 //        treeHandler->times[4].push_back(y);
 //        ocall_start_timer(944);
 //    }
-    treeHandler->finishOperation();
+    treeHandler->finishOperation(!batched);
     if (treeHandler->logTime) {
         ocall_stop_timer(&y, 944);
         treeHandler->times[3].push_back(y);
@@ -96,7 +103,7 @@ void OMAP::insert(Bid omapKey, string value) {
     if (treeHandler->logTime) {
         ocall_start_timer(898);
     }
-    treeHandler->finishOperation();
+    treeHandler->finishOperation(!batched);
     if (treeHandler->logTime) {
         ocall_stop_timer(&y, 898);
         treeHandler->times[1].push_back(y);
@@ -160,3 +167,13 @@ vector<string> OMAP::batchSearch(vector<Bid> keys) {
     treeHandler->finishOperation();
     return result;
 }
+
+void OMAP::beginBatch() {
+    batched = true;
+}
+
+void OMAP::endBatch() {
+    batched = false;
+    treeHandler->startOperation(false);
+    treeHandler->finishOperation();
+}
@@ -14,13 +14,15 @@ class OMAP {
 private:
     Bid rootKey;
     unsigned long long rootPos;
+    bool batched = false;
 
 
 public:
     AVLTree* treeHandler;    
     OMAP(int maxSize, bytes<Key> key);
     OMAP(int maxSize, bytes<Key> secretKey, map<Bid, string>* pairs, map<unsigned long long, unsigned long long>* permutation);
-    OMAP(int maxSize, Bid rootBid, long long rootPos,bytes<Key> secretKey);
+    OMAP(int maxSize, bytes<Key> secretKey, vector<pair<Bid, string> >* sortedPairs);
+    OMAP(int maxSize, Bid rootBid, long long rootPos, bytes<Key> secretKey, int store);
     virtual ~OMAP();
     void insert(Bid key, string value);
     string find(Bid key);
@@ -29,6 +31,12 @@ public:
     vector<long long> treePreOrderKeys();
     void batchInsert(map<Bid, string> pairs);
     vector<string> batchSearch(vector<Bid> keys);
+    /**
+     * Until endBatch, finds, inserts and deletes keep the buckets they touch
+     * in the enclave and endBatch writes them back at once
+     */
+    void beginBatch();
+    void endBatch();
 };
 
 #endif /* OMAP_H */
@@ -0,0 +1,38 @@
+#include "OMapEntry.hpp"
+#include <algorithm>
+#include <cstring>
+
+// set in the second word of every entry, a missing key reads as 16 zero bytes
+static const long long PRESENT = 1LL << 62;
+
+string OMapEntry::Pack(long long first, long long second) {
+    string value(16, '\0');
+    second |= PRESENT;
+    std::memcpy(&value[0], &first, sizeof (first));
+    std::memcpy(&value[8], &second, sizeof (second));
+    return value;
+}
+
+void OMapEntry::Unpack(const string& value, long long& first, long long& second) {
+    char entry[16] = {0};
+    std::memcpy(entry, value.data(), std::min(value.size(), sizeof (entry)));
+    std::memcpy(&first, entry, sizeof (first));
+    std::memcpy(&second, entry + 8, sizeof (second));
+    second &= ~PRESENT;
+}
+
+bool OMapEntry::Find(OMAP* omap, Bid key, long long& first, long long& second) {
+    string value = omap->find(key);
+    char entry[16] = {0};
+    std::memcpy(entry, value.data(), std::min(value.size(), sizeof (entry)));
+    long long raw;
+    std::memcpy(&raw, entry + 8, sizeof (raw));
+    Unpack(value, first, second);
+    return Node::CTeq(raw & PRESENT, PRESENT);
+}
+
+Bid OMapEntry::PaddingKey() {
+    Bid key;
+    key.setInfinity();
+    return key;
+}
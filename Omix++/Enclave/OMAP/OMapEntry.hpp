@@ -0,0 +1,37 @@
+#ifndef OMAPENTRY_H
+#define OMAPENTRY_H
+
+#include "OMAP.h"
+#include <string>
+
+/**
+ * OMAP values of the structures built on an OMAP (the graph, the multimap
+ * and the blob store), which hold two 8 byte words
+ */
+class OMapEntry {
+public:
+    /**
+     * @param second at least 0 and below 2^62, the bit above it marks the
+     * entry as present
+     */
+    static string Pack(long long first, long long second);
+    /**
+     * A value shorter than 16 bytes, such as the empty one of a missing key,
+     * reads as zero words past its end
+     */
+    static void Unpack(const string& value, long long& first, long long& second);
+    /**
+     * Finds key, a key that is not there reads as two zero words. The OMAP
+     * returns 16 zero bytes for it once it holds any key, so presence is
+     * the bit Pack sets.
+     * @return whether key has an entry
+     */
+    static bool Find(OMAP* omap, Bid key, long long& first, long long& second);
+    /**
+     * All ones. Writes that must not add a key go to this one instead, and
+     * the structures refuse it as a key.
+     */
+    static Bid PaddingKey();
+};
+
+#endif /* OMAPENTRY_H */
@@ -0,0 +1,115 @@
+#include "OMultimap.hpp"
+#include "OMapEntry.hpp"
+#include <cstring>
+#include <algorithm>
+
+OMultimap::OMultimap(long long capacity, int maxChain, bytes<Key> key)
+: capacity(capacity), maxChain(maxChain) {
+    // every key holds a value when it is added, and the padding key takes one more entry
+    omap = new OMAP((int) capacity + 1, key);
+    slots = new ObliviousArray(capacity + 1, key);
+    freeSlots = new OStack(capacity, key);
+}
+
+OMultimap::~OMultimap() {
+    delete omap;
+    delete slots;
+    delete freeSlots;
+}
+
+bool OMultimap::append(Bid key, long long value) {
+    if (key == OMapEntry::PaddingKey()) {
+        return false;
+    }
+    long long first, count;
+    bool exists = OMapEntry::Find(omap, key, first, count);
+
+    // a freed slot is popped if there is one, otherwise the next one never used is taken and the stack only peeked
+    bool hasRoom = Node::CTeq(Node::CTcmp(count, (long long) maxChain), -1) && (exists || Node::CTeq(Node::CTcmp(keys, capacity), -1));
+    bool reuse = Node::CTeq(Node::CTcmp(freeSlots->size(), 0LL), 1);
+    bool fresh = !reuse && Node::CTeq(Node::CTcmp(allocated, capacity), -1);
+    bool done = hasRoom && (reuse || fresh);
+    array<byte_t, 16> block;
+    freeSlots->execute(block, Node::conditional_select(1, 3, reuse && hasRoom));
+    long long popped;
+    std::memcpy(&popped, block.data(), sizeof (popped));
+    long long slot = Node::conditional_select(popped, allocated + 1, reuse);
+    allocated = Node::conditional_select(allocated + 1, allocated, done && !reuse);
+
+    std::memcpy(block.data(), &value, sizeof (value));
+    std::memcpy(block.data() + 8, &first, sizeof (first));
+    array<byte_t, 16> mask;
+    std::fill(mask.begin(), mask.end(), Node::conditional_select((byte_t) 0xFF, (byte_t) 0, done));
+    slots->access(Node::conditional_select(slot, 0LL, done), block, mask);
+    keys = Node::conditional_select(keys + 1, keys, done && !exists);
+    // a failed append writes the padding key instead, so it adds no key
+    omap->insert(Bid::conditional_select(key, OMapEntry::PaddingKey(), done), OMapEntry::Pack(Node::conditional_select(slot, first, done), Node::conditional_select(count + 1, count, done)));
+    return done;
+}
+
+int OMultimap::get(Bid key, long long* values, int maxCount) {
+    if (key == OMapEntry::PaddingKey()) {
+        std::fill(values, values + maxCount, 0);
+        return 0;
+    }
+    long long first, count;
+    OMapEntry::Find(omap, key, first, count);
+    long long current = first;
+    slots->beginBatch();
+    for (int i = 0; i < maxCount; i++) {
+        bool valid = Node::CTeq(Node::CTcmp((long long) i, count), -1);
+        array<byte_t, 16> block = slots->read(Node::conditional_select(current, 0LL, valid));
+        long long value, next;
+        std::memcpy(&value, block.data(), sizeof (value));
+        std::memcpy(&next, block.data() + 8, sizeof (next));
+        values[i] = Node::conditional_select(value, 0LL, valid);
+        current = Node::conditional_select(next, current, valid);
+    }
+    slots->endBatch();
+    return (int) Node::conditional_select(count, (long long) maxCount, Node::CTeq(Node::CTcmp(count, (long long) maxCount), -1));
+}
+
+bool OMultimap::remove(Bid key, long long value) {
+    if (key == OMapEntry::PaddingKey()) {
+        return false;
+    }
+    long long first, count;
+    OMapEntry::Find(omap, key, first, count);
+
+    // the whole chain bound is walked, the first match is remembered with the slots before and after it
+    long long previous = 0, current = first;
+    long long foundSlot = 0, foundPrevious = 0, foundNext = 0;
+    bool found = false;
+    slots->beginBatch();
+    for (int i = 0; i < maxChain; i++) {
+        bool valid = Node::CTeq(Node::CTcmp((long long) i, count), -1);
+        array<byte_t, 16> block = slots->read(Node::conditional_select(current, 0LL, valid));
+        long long stored, next;
+        std::memcpy(&stored, block.data(), sizeof (stored));
+        std::memcpy(&next, block.data() + 8, sizeof (next));
+        bool match = valid && !found && Node::CTeq(stored, value);
+        foundSlot = Node::conditional_select(current, foundSlot, match);
+        foundPrevious = Node::conditional_select(previous, foundPrevious, match);
+        foundNext = Node::conditional_select(next, foundNext, match);
+        found = found || match;
+        previous = Node::conditional_select(current, previous, valid);
+        current = Node::conditional_select(next, current, valid);
+    }
+
+    // the slot before the removed one skips it, a removed head moves the head in the OMAP entry instead
+    bool relink = found && !Node::CTeq(foundPrevious, 0LL);
+    array<byte_t, 16> block, mask;
+    std::fill(block.begin(), block.end(), 0);
+    std::memcpy(block.data() + 8, &foundNext, sizeof (foundNext));
+    std::fill(mask.begin(), mask.end(), 0);
+    std::fill(mask.begin() + 8, mask.end(), Node::conditional_select((byte_t) 0xFF, (byte_t) 0, relink));
+    slots->access(Node::conditional_select(foundPrevious, 0LL, relink), block, mask);
+    slots->endBatch();
+    // a key with no such value, or none at all, is left as it is and the padding key written instead
+    omap->insert(Bid::conditional_select(key, OMapEntry::PaddingKey(), found), OMapEntry::Pack(Node::conditional_select(foundNext, first, found && !relink), Node::conditional_select(count - 1, count, found)));
+
+    std::fill(block.begin(), block.end(), 0);
+    std::memcpy(block.data(), &foundSlot, sizeof (foundSlot));
+    freeSlots->execute(block, Node::conditional_select(2, 3, found));
+    return found;
+}
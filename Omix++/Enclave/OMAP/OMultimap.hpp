@@ -0,0 +1,57 @@
+#ifndef OMULTIMAP_H
+#define OMULTIMAP_H
+
+#include "OMAP.h"
+#include "ObliviousArray.hpp"
+#include "OStack.hpp"
+
+/**
+ * A multimap from OMAP keys to 8 byte values. The OMAP entry of a key holds
+ * the first slot of its chain and the number of values, and every value is a
+ * slot of an ObliviousArray holding the value and the next slot. Slots freed
+ * by removals are kept on an OStack for reuse. Chains are bounded by a
+ * public maxChain, so every operation is a fixed number of accesses: append
+ * is one find, one stack access, one array access and one insert, get walks
+ * maxCount slots and remove walks maxChain slots. An append that fails or a
+ * remove that finds nothing writes a reserved padding key instead of the
+ * key, so no entry is added for it. A key keeps its entry once it held a
+ * value, and at most capacity keys are held.
+ */
+class OMultimap {
+private:
+    OMAP* omap;
+    ObliviousArray* slots; // slot 0 is never used and stands in for padding accesses
+    OStack* freeSlots;
+    long long capacity;
+    int maxChain;
+    long long allocated = 0;
+    long long keys = 0;
+
+public:
+    /**
+     * @param capacity values held at once over all keys
+     * @param maxChain values held at once for one key
+     */
+    OMultimap(long long capacity, int maxChain, bytes<Key> key);
+    virtual ~OMultimap();
+
+    /**
+     * @return false if the chain of key or the multimap is full, or key is
+     * new and capacity keys are held, the accesses are made either way
+     */
+    bool append(Bid key, long long value);
+    /**
+     * Walks maxCount slots from the head of the chain, newest value first,
+     * with the array buckets written back once for the walk
+     * @param values maxCount entries, zero past the values of key
+     * @return number of values found
+     */
+    int get(Bid key, long long* values, int maxCount);
+    /**
+     * Removes one occurrence of value from the chain of key
+     * @return false if there was none
+     */
+    bool remove(Bid key, long long value);
+};
+
+#endif /* OMULTIMAP_H */
@@ -0,0 +1,38 @@
+#include "OQueue.hpp"
+
+OQueue::OQueue(long long capacity, bytes<Key> key)
+: capacity(capacity) {
+    blocks = new ObliviousArray(capacity, key);
+}
+
+OQueue::~OQueue() {
+    delete blocks;
+}
+
+bool OQueue::execute(array<byte_t, 16>& value, int op) {
+    bool isPush = Node::CTeq(op, 2);
+    bool isPop = Node::CTeq(op, 1);
+    long long count = tail - head;
+    bool hasRoom = Node::CTeq(Node::CTcmp(count, capacity), -1);
+    bool hasBlock = Node::CTeq(Node::CTcmp(count, 0LL), 1);
+    bool done = Node::conditional_select((int) hasRoom, (int) hasBlock, isPush);
+
+    // a push writes at the tail, a pop or peek reads the head
+    // the array holds at least one block, also for a queue of capacity 0
+    long long index = Node::conditional_select(tail, head, isPush) % blocks->length();
+    array<byte_t, 16> mask;
+    byte_t write = Node::conditional_select((byte_t) 0xFF, (byte_t) 0, isPush && done);
+    std::fill(mask.begin(), mask.end(), write);
+    array<byte_t, 16> old = blocks->access(index, value, mask);
+
+    tail = Node::conditional_select(tail + 1, tail, isPush && done);
+    head = Node::conditional_select(head + 1, head, isPop && done);
+    for (int k = 0; k < value.size(); k++) {
+        value[k] = Node::conditional_select(old[k], (byte_t) 0, !isPush && done);
+    }
+    return done;
+}
+
+long long OQueue::size() {
+    return tail - head;
+}
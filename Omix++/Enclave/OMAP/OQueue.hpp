@@ -0,0 +1,32 @@
+#ifndef OQUEUE_H
+#define OQUEUE_H
+
+#include "ObliviousArray.hpp"
+
+/**
+ * A bounded FIFO queue of 16 byte blocks kept as a ring in an
+ * ObliviousArray. The head and tail counters stay in the enclave and address
+ * the blocks, so push, pop and peek are each one access to the array and
+ * cannot be told apart from outside.
+ */
+class OQueue {
+private:
+    ObliviousArray* blocks;
+    long long capacity;
+    long long head = 0, tail = 0;
+
+public:
+    OQueue(long long capacity, bytes<Key> key);
+    virtual ~OQueue();
+
+    /**
+     * @param value pushed for op 2, the popped or peeked block on return
+     * @param op 1: pop  2: push  3: peek
+     * @return false if a pop or peek found the queue empty or a push found
+     * it full, the access is made either way
+     */
+    bool execute(array<byte_t, 16>& value, int op);
+    long long size();
+};
+
+#endif /* OQUEUE_H */
@@ -15,21 +15,27 @@
 #include <algorithm>
 #include <stdlib.h>
 #include "../Enclave.h"
+#include "Trace.hpp"
+#include "IOStats.hpp"
+#include "StoreHandle.h"
 
-ORAM::ORAM(long long maxSize, bytes<Key> oram_key, bool simulation, bool isEmptyMap)
-: key(oram_key) {
+bool ORAM::pipelining = false;
+
+ORAM::ORAM(long long maxSize, bytes<Key> oram_key, bool simulation, bool isEmptyMap, int store)
+: key(oram_key), storeHandle(store) {
     depth = (int) (ceil(log2(maxSize)) - 1) + 1;
     maxOfRandom = (long long) (pow(2, depth));
     AES::Setup();
     bucketCount = maxOfRandom * 2 - 1;
     INF = 9223372036854775807 - (bucketCount);
-    PERMANENT_STASH_SIZE = 90;
+    PERMANENT_STASH_SIZE = StashConfig::PermanentStashSize(Z, maxSize);
+    stashStats.reset(PERMANENT_STASH_SIZE);
     stash.preAllocate(PERMANENT_STASH_SIZE * 4);
     printf("Number of leaves:%lld\n", maxOfRandom);
     printf("depth:%lld\n", depth);
 
     nextDummyCounter = INF;
-    blockSize = sizeof (Node); // B    
+    blockSize = NODE_SIZE + payloadSize; // B    
     printf("block size is:%d\n", blockSize);
     size_t blockCount = (size_t) (Z * bucketCount);
     storeBlockSize = (size_t) (IV + AES::GetCiphertextLength((int) (Z * (blockSize))));
@@ -38,11 +44,17 @@ ORAM::ORAM(long long maxSize, bytes<Key> oram_key, bool simulation, bool isEmpty
     if (!simulation) {
         if (useLocalRamStore) {
             localStore = new LocalRAMStore(blockCount, storeBlockSize);
-        } else {
-            ocall_setup_ramStore(blockCount, storeBlockSize);
+        } else if (storeHandle < 0) {
+            ocall_setup_ramStore(&storeHandle, blockCount, storeBlockSize);
         }
     } else {
-        ocall_setup_ramStore(depth, -1);
+        ocall_setup_ramStore(&storeHandle, depth, -1);
+    }
+    if (!useLocalRamStore || simulation) {
+        CheckStore(storeHandle);
+    }
+    if (pipelining && !simulation && !useLocalRamStore) {
+        prefetcher = new PathPrefetcher(storeHandle, key, storeBlockSize, clen_size);
     }
 
     maxHeightOfAVLTree = (int) floor(log2(blockCount)) + 1;
@@ -74,6 +86,10 @@ ORAM::ORAM(long long maxSize, bytes<Key> oram_key, bool simulation, bool isEmpty
 }
 
 ORAM::~ORAM() {
+    delete prefetcher;
+    if (storeHandle >= 0) {
+        ocall_release_store(storeHandle);
+    }
     AES::Cleanup();
 }
 
@@ -114,7 +130,9 @@ void ORAM::InitializeBucketsInBatch() {
             cipherSize = ciphertext.size();
         }
         if (min((int) (bucketCount - j * batchSize), batchSize) != 0) {
-            ocall_nwrite_ramStore(min((int) (bucketCount - j * batchSize), batchSize), indexes.data(), (const char*) tmp, cipherSize * min((int) (bucketCount - j * batchSize), batchSize));
+            ocall_nwrite_ramStore(storeHandle, min((int) (bucketCount - j * batchSize), batchSize), indexes.data(), (const char*) tmp, cipherSize * min((int) (bucketCount - j * batchSize), batchSize));
+            IOStats::ocall(min((int) (bucketCount - j * batchSize), batchSize) * sizeof (long long) + cipherSize * min((int) (bucketCount - j * batchSize), batchSize), 0);
+            IOStats::bucketsWritten(min((int) (bucketCount - j * batchSize), batchSize));
         }
         delete tmp;
         indexes.clear();
@@ -137,7 +155,9 @@ void ORAM::InitializeORAMBuckets() {
 void ORAM::WriteBucket(long long index, Bucket bucket) {
     block b = SerialiseBucket(bucket);
     block ciphertext = AES::Encrypt(key, b, clen_size, plaintext_size);
-    ocall_write_ramStore(index, (const char*) ciphertext.data(), (size_t) ciphertext.size());
+    ocall_write_ramStore(storeHandle, index, (const char*) ciphertext.data(), (size_t) ciphertext.size());
+    IOStats::ocall(sizeof (long long) + ciphertext.size(), 0);
+    IOStats::bucketsWritten(1);
 }
 // Fetches the array index a bucket that lise on a specific path
 
@@ -195,13 +215,19 @@ void ORAM::ReadBuckets(vector<long long> indexes) {
     } else {
         size_t readSize;
         char* tmp = new char[indexes.size() * storeBlockSize];
-        ocall_nread_ramStore(&readSize, indexes.size(), indexes.data(), tmp, indexes.size() * storeBlockSize);
+        unsigned long long traceStart = Trace::now();
+        ocall_nread_ramStore(&readSize, storeHandle, indexes.size(), indexes.data(), tmp, indexes.size() * storeBlockSize);
+        IOStats::ocall(indexes.size() * sizeof (long long), indexes.size() * storeBlockSize);
+        IOStats::bucketsRead(indexes.size());
+        Trace::record(TRACE_FETCH, traceStart);
+        traceStart = Trace::now();
         for (unsigned int i = 0; i < indexes.size(); i++) {
             block ciphertext(tmp + i*readSize, tmp + (i + 1) * readSize);
             block buffer = AES::Decrypt(key, ciphertext, clen_size);
             Bucket bucket = DeserialiseBucket(buffer);
             virtualStorage[indexes[i]] = bucket;
         }
+        Trace::record(TRACE_DECRYPT, traceStart);
         delete[] tmp;
     }
 }
@@ -214,7 +240,9 @@ void ORAM::InitializeBuckets(long long strtindex, long long endindex, Bucket buc
             localStore->Write(i, ciphertext);
         }
     } else {
-        ocall_initialize_ramStore(strtindex, endindex, (const char*) ciphertext.data(), (size_t) ciphertext.size());
+        ocall_initialize_ramStore(storeHandle, strtindex, endindex, (const char*) ciphertext.data(), (size_t) ciphertext.size());
+        IOStats::ocall(2 * sizeof (long long) + ciphertext.size(), 0);
+        IOStats::bucketsWritten(endindex - strtindex);
     }
 }
 
@@ -240,6 +268,7 @@ void ORAM::EvictBuckets() {
             char* tmp = new char[10000 * storeBlockSize];
             vector<long long> indexes;
             size_t cipherSize = 0;
+            unsigned long long traceStart = Trace::now();
             for (int i = 0; i < min((int) (virtualStorage.size() - j * 10000), 10000); i++) {
                 block b = SerialiseBucket(it->second);
                 indexes.push_back(it->first);
@@ -248,8 +277,13 @@ void ORAM::EvictBuckets() {
                 cipherSize = ciphertext.size();
                 it++;
             }
+            Trace::record(TRACE_ENCRYPT, traceStart);
             if (min((int) (virtualStorage.size() - j * 10000), 10000) != 0) {
-                ocall_nwrite_ramStore(min((int) (virtualStorage.size() - j * 10000), 10000), indexes.data(), (const char*) tmp, cipherSize * min((int) (virtualStorage.size() - j * 10000), 10000));
+                traceStart = Trace::now();
+                ocall_nwrite_ramStore(storeHandle, min((int) (virtualStorage.size() - j * 10000), 10000), indexes.data(), (const char*) tmp, cipherSize * min((int) (virtualStorage.size() - j * 10000), 10000));
+                IOStats::ocall(min((int) (virtualStorage.size() - j * 10000), 10000) * sizeof (long long) + cipherSize * min((int) (virtualStorage.size() - j * 10000), 10000), 0);
+                IOStats::bucketsWritten(min((int) (virtualStorage.size() - j * 10000), 10000));
+                Trace::record(TRACE_WRITEBACK, traceStart);
             }
             delete tmp;
             indexes.clear();
@@ -263,6 +297,15 @@ void ORAM::FetchPath(long long leaf) {
     readCnt++;
     vector<long long> nodesIndex;
     vector<long long> existingIndexes;
+    vector<long long> prefetchedIndexes;
+    vector<block> prefetched;
+
+    if (prefetcher != NULL && prefetcher->pending()) {
+        // only the part of the read that did not overlap the eviction is on the critical path
+        unsigned long long traceStart = Trace::now();
+        prefetcher->wait(leaf, prefetchedIndexes, prefetched);
+        Trace::record(TRACE_FETCH, traceStart);
+    }
 
     long long node = leaf;
 
@@ -284,6 +327,15 @@ void ORAM::FetchPath(long long leaf) {
         }
     }
 
+    // prefetched buckets only fill in what the enclave does not hold, its own copy is never older
+    for (unsigned int i = 0; i < prefetchedIndexes.size(); i++) {
+        vector<long long>::iterator it = std::find(nodesIndex.begin(), nodesIndex.end(), prefetchedIndexes[i]);
+        if (it != nodesIndex.end()) {
+            nodesIndex.erase(it);
+            virtualStorage[prefetchedIndexes[i]] = DeserialiseBucket(prefetched[i]);
+        }
+    }
+
     ReadBuckets(nodesIndex);
 
     for (unsigned int i = 0; i < existingIndexes.size(); i++) {
@@ -499,7 +551,7 @@ Node* ORAM::ReadWriteTest(Bid bid, Node* inputnode, unsigned long long lastLeaf,
     return res;
 }
 
-Node* ORAM::ReadWrite(Bid bid, unsigned long long lastLeaf, unsigned long long newLeaf, bool isDummy, unsigned long long newChildPos, Bid targetNode) {
+Node* ORAM::ReadWrite(Bid bid, unsigned long long lastLeaf, unsigned long long newLeaf, bool isDummy, unsigned long long newChildPos, Bid targetNode, bool deferEviction) {
 #ifdef SGX_DEBUG
     printf("ORAM WRITE 2: bid: %d, isDummy: %d, targetNode: %d\n",
            bid.getValue(), isDummy, targetNode.getValue());
@@ -511,7 +563,8 @@ Node* ORAM::ReadWrite(Bid bid, unsigned long long lastLeaf, unsigned long long n
     accessCounter++;
 
 
-    unsigned long long newPos = RandomPath();
+    unsigned long long newPos = leafReserved ? reservedLeaf : RandomPath();
+    leafReserved = false;
     unsigned long long fetchPos = Node::conditional_select(newPos, lastLeaf, isDummy);
 
     FetchPath(fetchPos);
@@ -567,7 +620,9 @@ Node* ORAM::ReadWrite(Bid bid, unsigned long long lastLeaf, unsigned long long n
         }
     }
 
-    evict(evictBuckets);
+    if (!deferEviction) {
+        evict(evictBuckets);
+    }
     return res;
 }
 
@@ -663,28 +718,68 @@ Node* ORAM::ReadWrite(Bid bid, Node* inputnode, unsigned long long lastLeaf, uns
     return res;
 }
 
+Node* ORAM::Access(Bid bid, unsigned long long lastLeaf, unsigned long long newLeaf, const std::array<byte_t, 16>& value, const std::array<byte_t, 16>& mask, const block* payload, bool writePayload) {
+    if (bid == 0) {
+        throw runtime_error("Node id is not set");
+    }
+    accessCounter++;
+
+    FetchPath(lastLeaf);
+    currentLeaf = lastLeaf;
+
+    Node* res = new Node();
+    res->isDummy = true;
+    res->index = nextDummyCounter++;
+    res->key = nextDummyCounter++;
+    res->payload.resize(payloadSize, 0);
+
+    for (Node* node : stash.nodes) {
+        bool match = Node::CTeq(Bid::CTcmp(node->key, bid), 0) && !node->isDummy;
+        Node::conditional_assign(res, node, match);
+        node->pos = Node::conditional_select(newLeaf, node->pos, match);
+        byte_t selected = Node::conditional_select((byte_t) 0xFF, (byte_t) 0, match);
+        for (int k = 0; k < node->value.size(); k++) {
+            byte_t m = mask[k] & selected;
+            node->value[k] = (value[k] & m) | (node->value[k] & ~m);
+        }
+        if (payload != NULL) {
+            byte_t m = Node::conditional_select(selected, (byte_t) 0, writePayload);
+            for (size_t k = 0; k < payloadSize; k++) {
+                node->payload[k] = ((*payload)[k] & m) | (node->payload[k] & ~m);
+            }
+        }
+    }
+
+    evict(evictBuckets);
+    return res;
+}
+
 Node* ORAM::convertBlockToNode(block b) {
     Node* node = new Node();
-    std::array<byte_t, sizeof (Node) > arr;
-    std::copy(b.begin(), b.begin() + sizeof (Node), arr.begin());
-    from_bytes(arr, *node);
+    std::memcpy((void*) node, b.data(), NODE_SIZE);
+    node->payload.assign(b.begin() + NODE_SIZE, b.begin() + NODE_SIZE + payloadSize);
     return node;
 }
 
 block ORAM::convertNodeToBlock(Node* node) {
-    std::array<byte_t, sizeof (Node) > data = to_bytes(*node);
-    block b(data.begin(), data.end());
+    block b((const byte_t*) node, (const byte_t*) node + NODE_SIZE);
+    b.insert(b.end(), node->payload.begin(), node->payload.end());
     return b;
 }
 
-void ORAM::finilize(bool noDummyOp) {
+void ORAM::finilize(bool noDummyOp, bool writeBack) {
     if (!noDummyOp && stashCounter == 100) {
         stashCounter = 0;
 //        EvictBuckets();
     } else {
         stashCounter++;
     }
-    EvictBuckets();
+    if (prefetcher != NULL) {
+        prefetcher->cancel();
+    }
+    if (writeBack) {
+        EvictBuckets();
+    }
 }
 
 void ORAM::evict(bool evictBucketsForORAM) {
@@ -706,6 +801,7 @@ void ORAM::evict(bool evictBucketsForORAM) {
     }
 
     // compute the intersection of each node's position (assigned leaf) with currentLeaf using XOR
+    unsigned long long traceStart = Trace::now();
     for (Node* node : stash.nodes) {
         long long xorVal = 0;
         xorVal = Node::conditional_select((unsigned long long) 0, node->pos ^ currentLeaf, node->isDummy);
@@ -723,6 +819,8 @@ void ORAM::evict(bool evictBucketsForORAM) {
         }
     }
 
+    Trace::record(TRACE_ASSIGN, traceStart);
+
     if (profile) {
         ocall_stop_timer(&time, 10);
         printf("Assigning stash blocks to lowest possible level:%f\n", time);
@@ -737,6 +835,7 @@ void ORAM::evict(bool evictBucketsForORAM) {
             nextDummyCounter++;
             dummy->evictionNode = node;
             dummy->isDummy = true;
+            dummy->payload.resize(payloadSize, 0);
             stash.nodes.push_back(dummy);
         }
         node = (node + 1) / 2 - 1;
@@ -748,7 +847,9 @@ void ORAM::evict(bool evictBucketsForORAM) {
         ocall_start_timer(10);
     }
 
+    traceStart = Trace::now();
     ObliviousOperations::oblixmergesort(&stash.nodes);
+    Trace::record(TRACE_SORT, traceStart);
 
     if (profile) {
         ocall_stop_timer(&time, 10);
@@ -760,6 +861,7 @@ void ORAM::evict(bool evictBucketsForORAM) {
     int level = depth;
     int counter = 0;
 
+    traceStart = Trace::now();
     for (unsigned long long i = 0; i < stash.nodes.size(); i++) {
         Node* curNode = stash.nodes[i];
         bool firstCond = (!Node::CTeq(Node::CTcmp(counter - (depth - level) * Z, Z), -1));
@@ -815,13 +917,17 @@ void ORAM::evict(bool evictBucketsForORAM) {
         //        }
     }
 
+    Trace::record(TRACE_ASSIGN, traceStart);
+
     if (profile) {
         ocall_stop_timer(&time, 10);
         printf("Sequential Scan on Stash Blocks to assign blocks to blocks:%f\n", time);
         ocall_start_timer(10);
     }
 
+    traceStart = Trace::now();
     ObliviousOperations::oblixmergesort(&stash.nodes);
+    Trace::record(TRACE_SORT, traceStart);
 
     if (profile) {
         ocall_stop_timer(&time, 10);
@@ -864,6 +970,16 @@ void ORAM::evict(bool evictBucketsForORAM) {
 
     stash.nodes.erase(stash.nodes.begin(), stash.nodes.begin()+((depth + 1) * Z));
 
+    int occupancy = 0;
+    for (unsigned int i = 0; i < stash.nodes.size(); i++) {
+        occupancy = Node::conditional_select(occupancy, occupancy + 1, stash.nodes[i]->isDummy);
+    }
+    stashStats.record(occupancy);
+    IOStats::stash(occupancy);
+    if (occupancy > (int) PERMANENT_STASH_SIZE) {
+        printf("Stash overflow: %d real blocks, permanent stash size %d\n", occupancy, PERMANENT_STASH_SIZE);
+    }
+
     for (unsigned int i = PERMANENT_STASH_SIZE; i < stash.nodes.size(); i++) {
         delete stash.nodes[i];
     }
@@ -895,6 +1011,32 @@ void ORAM::evict(bool evictBucketsForORAM) {
     }
 }
 
+bool ORAM::pipelined() {
+    return prefetcher != NULL;
+}
+
+unsigned long long ORAM::ReserveRandomPath() {
+    reservedLeaf = RandomPath();
+    leafReserved = true;
+    return reservedLeaf;
+}
+
+void ORAM::evictAndPrefetch(unsigned long long nextLeaf) {
+    vector<long long> indexes;
+    long long node = nextLeaf + bucketCount / 2;
+    long long current = currentLeaf + bucketCount / 2;
+    for (int d = depth; d >= 0; d--) {
+        // the buckets on the current path are rewritten by the eviction
+        if (node != current && virtualStorage.count(node) == 0) {
+            indexes.push_back(node);
+        }
+        node = (node + 1) / 2 - 1;
+        current = (current + 1) / 2 - 1;
+    }
+    prefetcher->start(nextLeaf, indexes);
+    evict(evictBuckets);
+}
+
 void ORAM::start(bool isBatchWrite) {
     this->batchWrite = isBatchWrite;
     readCnt = 0;
@@ -925,6 +1067,20 @@ void ORAM::prepareForEvictionTest() {
     }
 }
 
+vector<unsigned long long> ORAM::ShuffledLeaves(long long leaves) {
+    long long slots = leaves * Z;
+    vector<unsigned long long> shuffled(slots);
+    for (long long i = 0; i < slots; i++) {
+        shuffled[i] = i / Z;
+    }
+    for (long long i = slots - 1; i > 0; i--) {
+        unsigned long long r;
+        sgx_read_rand((unsigned char*) &r, sizeof (r));
+        std::swap(shuffled[i], shuffled[r % (i + 1)]);
+    }
+    return shuffled;
+}
+
 unsigned long long ORAM::RandomPath() {
     uint32_t val;
     sgx_read_rand((unsigned char *) &val, 4);
@@ -938,19 +1094,21 @@ ORAM::ORAM(long long maxSize, bytes<Key> oram_key, vector<Node*>* nodes, map<uns
     AES::Setup();
     bucketCount = maxOfRandom * 2 - 1;
     INF = 9223372036854775807 - (bucketCount);
-    PERMANENT_STASH_SIZE = 90;
+    PERMANENT_STASH_SIZE = StashConfig::PermanentStashSize(Z, maxSize);
+    stashStats.reset(PERMANENT_STASH_SIZE);
     stash.preAllocate(PERMANENT_STASH_SIZE * 4);
     printf("Number of leaves:%lld\n", maxOfRandom);
     printf("depth:%lld\n", depth);
 
     nextDummyCounter = INF;
-    blockSize = sizeof (Node); // B  
+    blockSize = NODE_SIZE + payloadSize; // B  
     printf("block size is:%d\n", blockSize);
     size_t blockCount = (size_t) (Z * bucketCount);
     storeBlockSize = (size_t) (IV + AES::GetCiphertextLength((int) (Z * (blockSize))));
     clen_size = AES::GetCiphertextLength((int) (blockSize) * Z);
     plaintext_size = (blockSize) * Z;
-    ocall_setup_ramStore(blockCount, storeBlockSize);
+    ocall_setup_ramStore(&storeHandle, blockCount, storeBlockSize);
+    CheckStore(storeHandle);
     maxHeightOfAVLTree = (int) floor(log2(blockCount)) + 1;
 
     unsigned long long first_leaf = bucketCount / 2;
@@ -1042,7 +1200,9 @@ ORAM::ORAM(long long maxSize, bytes<Key> oram_key, vector<Node*>* nodes, map<uns
             cipherSize = ciphertext.size();
         }
         if (min((int) (indexes.size() - j * 10000), 10000) != 0) {
-            ocall_nwrite_ramStore(min((int) (indexes.size() - j * 10000), 10000), indexes.data() + j * 10000, (const char*) tmp, cipherSize * min((int) (indexes.size() - j * 10000), 10000));
+            ocall_nwrite_ramStore(storeHandle, min((int) (indexes.size() - j * 10000), 10000), indexes.data() + j * 10000, (const char*) tmp, cipherSize * min((int) (indexes.size() - j * 10000), 10000));
+            IOStats::ocall(min((int) (indexes.size() - j * 10000), 10000) * sizeof (long long) + cipherSize * min((int) (indexes.size() - j * 10000), 10000), 0);
+            IOStats::bucketsWritten(min((int) (indexes.size() - j * 10000), 10000));
         }
         delete tmp;
     }
@@ -1052,32 +1212,42 @@ ORAM::ORAM(long long maxSize, bytes<Key> oram_key, vector<Node*>* nodes, map<uns
     for (int i = 0; i < PERMANENT_STASH_SIZE; i++) {
         Node* tmp = new Node();
         tmp->index = nextDummyCounter;
+        tmp->evictionNode = -1;
         tmp->isDummy = true;
+        tmp->leftID = 0;
+        tmp->leftPos = 0;
+        tmp->rightPos = 0;
+        tmp->rightID = 0;
+        tmp->pos = 0;
+        tmp->height = 1;
         stash.insert(tmp);
+        nextDummyCounter++;
     }
 
 }
 
-ORAM::ORAM(long long maxSize, bytes<Key> oram_key, vector<Node*>* nodes)
-: key(oram_key) {
+ORAM::ORAM(long long maxSize, bytes<Key> oram_key, vector<Node*>* nodes, size_t payload)
+: payloadSize(payload), key(oram_key) {
     depth = (int) (ceil(log2(maxSize)) - 1) + 1;
     maxOfRandom = (long long) (pow(2, depth));
     AES::Setup();
     bucketCount = maxOfRandom * 2 - 1;
     INF = 9223372036854775807 - (bucketCount);
-    PERMANENT_STASH_SIZE = 90;
+    PERMANENT_STASH_SIZE = StashConfig::PermanentStashSize(Z, maxSize);
+    stashStats.reset(PERMANENT_STASH_SIZE);
     stash.preAllocate(PERMANENT_STASH_SIZE * 4);
     printf("Number of leaves:%lld\n", maxOfRandom);
     printf("depth:%lld\n", depth);
 
     nextDummyCounter = INF;
-    blockSize = sizeof (Node); // B  
+    blockSize = NODE_SIZE + payloadSize; // B  
     printf("block size is:%d\n", blockSize);
     size_t blockCount = (size_t) (Z * bucketCount);
     storeBlockSize = (size_t) (IV + AES::GetCiphertextLength((int) (Z * (blockSize))));
     clen_size = AES::GetCiphertextLength((int) (blockSize) * Z);
     plaintext_size = (blockSize) * Z;
-    ocall_setup_ramStore(blockCount, storeBlockSize);
+    ocall_setup_ramStore(&storeHandle, blockCount, storeBlockSize);
+    CheckStore(storeHandle);
     maxHeightOfAVLTree = (int) floor(log2(blockCount)) + 1;
 
     unsigned long long first_leaf = bucketCount / 2;
@@ -1141,7 +1311,9 @@ ORAM::ORAM(long long maxSize, bytes<Key> oram_key, vector<Node*>* nodes)
             cipherSize = ciphertext.size();
         }
         if (min((int) (indexes.size() - j * 10000), 10000) != 0) {
-            ocall_nwrite_ramStore(min((int) (indexes.size() - j * 10000), 10000), indexes.data() + j * 10000, (const char*) tmp, cipherSize * min((int) (indexes.size() - j * 10000), 10000));
+            ocall_nwrite_ramStore(storeHandle, min((int) (indexes.size() - j * 10000), 10000), indexes.data() + j * 10000, (const char*) tmp, cipherSize * min((int) (indexes.size() - j * 10000), 10000));
+            IOStats::ocall(min((int) (indexes.size() - j * 10000), 10000) * sizeof (long long) + cipherSize * min((int) (indexes.size() - j * 10000), 10000), 0);
+            IOStats::bucketsWritten(min((int) (indexes.size() - j * 10000), 10000));
         }
         delete tmp;
     }
@@ -1174,7 +1346,9 @@ ORAM::ORAM(long long maxSize, bytes<Key> oram_key, vector<Node*>* nodes)
             cipherSize = ciphertext.size();
         }
         if (min((int) (indexes.size() - j * 10000), 10000) != 0) {
-            ocall_nwrite_ramStore(min((int) (indexes.size() - j * 10000), 10000), indexes.data() + j * 10000, (const char*) tmp, cipherSize * min((int) (indexes.size() - j * 10000), 10000));
+            ocall_nwrite_ramStore(storeHandle, min((int) (indexes.size() - j * 10000), 10000), indexes.data() + j * 10000, (const char*) tmp, cipherSize * min((int) (indexes.size() - j * 10000), 10000));
+            IOStats::ocall(min((int) (indexes.size() - j * 10000), 10000) * sizeof (long long) + cipherSize * min((int) (indexes.size() - j * 10000), 10000), 0);
+            IOStats::bucketsWritten(min((int) (indexes.size() - j * 10000), 10000));
         }
         delete tmp;
     }
@@ -1185,8 +1359,17 @@ ORAM::ORAM(long long maxSize, bytes<Key> oram_key, vector<Node*>* nodes)
     for (int i = 0; i < PERMANENT_STASH_SIZE; i++) {
         Node* tmp = new Node();
         tmp->index = nextDummyCounter;
+        tmp->evictionNode = -1;
         tmp->isDummy = true;
+        tmp->leftID = 0;
+        tmp->leftPos = 0;
+        tmp->rightPos = 0;
+        tmp->rightID = 0;
+        tmp->pos = 0;
+        tmp->height = 1;
+        tmp->payload.resize(payloadSize, 0);
         stash.insert(tmp);
+        nextDummyCounter++;
     }
 
 }
@@ -9,8 +9,12 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <cstddef>
+#include <cstring>
 #include "Bid.h"
 #include "LocalRAMStore.hpp"
+#include "StashConfig.hpp"
+#include "PathPrefetcher.hpp"
 
 using namespace std;
 
@@ -38,6 +42,8 @@ public:
     unsigned long long leftPos;
     unsigned long long rightPos;
     std::array< byte_t, 24> dum;
+    // bytes an ORAM created with a payload size stores after the fields above, empty in the others
+    block payload;
 
     void setValue(std::array<byte_t, 16> val){
         std::fill(value.begin(), value.end(), 0);
@@ -61,6 +67,7 @@ public:
         newNode->height = oldNode->height;
         newNode->rightPos = oldNode->rightPos;
         newNode->dum = oldNode->dum;
+        newNode->payload = oldNode->payload;
         return newNode;
     }
 
@@ -126,93 +133,73 @@ public:
     }
 
     /**
-     * constant time selector
+     * constant time copy of size bytes, a word at a time through memcpy
+     * so it does not alias, and the bytes past the last word one by one
+     */
+    static void conditional_assign(byte_t* a, const byte_t* b, size_t size, int choice) {
+        unsigned long long mask = ~((unsigned long long) choice - 1);
+        size_t k = 0;
+        for (; k + sizeof (mask) <= size; k += sizeof (mask)) {
+            unsigned long long wa, wb;
+            std::memcpy(&wa, a + k, sizeof (wa));
+            std::memcpy(&wb, b + k, sizeof (wb));
+            wa ^= (wa ^ wb) & mask;
+            std::memcpy(a + k, &wa, sizeof (wa));
+        }
+        for (; k < size; k++) {
+            a[k] ^= (a[k] ^ b[k]) & (byte_t) mask;
+        }
+    }
+
+    /**
+     * constant time swap of size bytes, word by word as conditional_assign
+     */
+    static void conditional_swap(byte_t* a, byte_t* b, size_t size, int choice) {
+        unsigned long long mask = ~((unsigned long long) choice - 1);
+        size_t k = 0;
+        for (; k + sizeof (mask) <= size; k += sizeof (mask)) {
+            unsigned long long wa, wb;
+            std::memcpy(&wa, a + k, sizeof (wa));
+            std::memcpy(&wb, b + k, sizeof (wb));
+            unsigned long long t = (wa ^ wb) & mask;
+            wa ^= t;
+            wb ^= t;
+            std::memcpy(a + k, &wa, sizeof (wa));
+            std::memcpy(b + k, &wb, sizeof (wb));
+        }
+        for (; k < size; k++) {
+            byte_t t = (a[k] ^ b[k]) & (byte_t) mask;
+            a[k] ^= t;
+            b[k] ^= t;
+        }
+    }
+
+    /**
+     * constant time selector over the fields before the payload, as one
+     * run of words, and then the payload
      * @param a
      * @param b
      * @param choice 0 or 1
      * @return choice = 1 -> b->a , choice = 0 -> return a->a
      */
     static void conditional_assign(Node* a, Node* b, int choice) {
-        a->index = Node::conditional_select((long long) b->index, (long long) a->index, choice);
-        a->isDummy = Node::conditional_select(b->isDummy, a->isDummy, choice);
-        a->pos = Node::conditional_select((long long) b->pos, (long long) a->pos, choice);
-        for (int k = 0; k < b->value.size(); k++) {
-            a->value[k] = Node::conditional_select(b->value[k], a->value[k], choice);
-        }
-        for (int k = 0; k < b->dum.size(); k++) {
-            a->dum[k] = Node::conditional_select(b->dum[k], a->dum[k], choice);
-        }
-        a->evictionNode = Node::conditional_select(b->evictionNode, a->evictionNode, choice);
-        a->modified = Node::conditional_select(b->modified, a->modified, choice);
-        a->height = Node::conditional_select(b->height, a->height, choice);
-        a->leftPos = Node::conditional_select(b->leftPos, a->leftPos, choice);
-        a->rightPos = Node::conditional_select(b->rightPos, a->rightPos, choice);
-        for (int k = 0; k < a->key.id.size(); k++) {
-            a->key.id[k] = Node::conditional_select(b->key.id[k], a->key.id[k], choice);
-        }
-        for (int k = 0; k < a->leftID.id.size(); k++) {
-            a->leftID.id[k] = Node::conditional_select(b->leftID.id[k], a->leftID.id[k], choice);
-        }
-        for (int k = 0; k < a->rightID.id.size(); k++) {
-            a->rightID.id[k] = Node::conditional_select(b->rightID.id[k], a->rightID.id[k], choice);
+        conditional_assign((byte_t*) a, (const byte_t*) b, offsetof(Node, payload), choice);
+        if (!a->payload.empty()) {
+            conditional_assign(a->payload.data(), b->payload.data(), a->payload.size(), choice);
         }
     }
 
     /**
-     * constant time selector
+     * constant time swap, the fields before the payload as one run of
+     * words and the payloads in place, so no copy is allocated
      * @param a
      * @param b
      * @param choice 0 or 1
-     * @return choice = 1 -> a , choice = 0 -> return b
      */
     static void conditional_swap(Node* a, Node* b, int choice) {
-        Node tmp = *b;
-        b->index = Node::conditional_select((long long) a->index, (long long) b->index, choice);
-        b->isDummy = Node::conditional_select(a->isDummy, b->isDummy, choice);
-        b->pos = Node::conditional_select((long long) a->pos, (long long) b->pos, choice);
-        for (int k = 0; k < b->value.size(); k++) {
-            b->value[k] = Node::conditional_select(a->value[k], b->value[k], choice);
-        }
-        for (int k = 0; k < b->dum.size(); k++) {
-            b->dum[k] = Node::conditional_select(a->dum[k], b->dum[k], choice);
-        }
-        b->evictionNode = Node::conditional_select(a->evictionNode, b->evictionNode, choice);
-        b->modified = Node::conditional_select(a->modified, b->modified, choice);
-        b->height = Node::conditional_select(a->height, b->height, choice);
-        b->leftPos = Node::conditional_select(a->leftPos, b->leftPos, choice);
-        b->rightPos = Node::conditional_select(a->rightPos, b->rightPos, choice);
-        for (int k = 0; k < b->key.id.size(); k++) {
-            b->key.id[k] = Node::conditional_select(a->key.id[k], b->key.id[k], choice);
-        }
-        for (int k = 0; k < b->leftID.id.size(); k++) {
-            b->leftID.id[k] = Node::conditional_select(a->leftID.id[k], b->leftID.id[k], choice);
-        }
-        for (int k = 0; k < b->rightID.id.size(); k++) {
-            b->rightID.id[k] = Node::conditional_select(a->rightID.id[k], b->rightID.id[k], choice);
-        }
-
-        a->index = Node::conditional_select((long long) tmp.index, (long long) a->index, choice);
-        a->isDummy = Node::conditional_select(tmp.isDummy, a->isDummy, choice);
-        a->pos = Node::conditional_select((long long) tmp.pos, (long long) a->pos, choice);
-        for (int k = 0; k < b->value.size(); k++) {
-            a->value[k] = Node::conditional_select(tmp.value[k], a->value[k], choice);
-        }
-        for (int k = 0; k < b->dum.size(); k++) {
-            a->dum[k] = Node::conditional_select(tmp.dum[k], a->dum[k], choice);
-        }
-        a->evictionNode = Node::conditional_select(tmp.evictionNode, a->evictionNode, choice);
-        a->modified = Node::conditional_select(tmp.modified, a->modified, choice);
-        a->height = Node::conditional_select(tmp.height, a->height, choice);
-        a->leftPos = Node::conditional_select(tmp.leftPos, a->leftPos, choice);
-        a->rightPos = Node::conditional_select(tmp.rightPos, a->rightPos, choice);
-        for (int k = 0; k < a->key.id.size(); k++) {
-            a->key.id[k] = Node::conditional_select(tmp.key.id[k], a->key.id[k], choice);
-        }
-        for (int k = 0; k < a->leftID.id.size(); k++) {
-            a->leftID.id[k] = Node::conditional_select(tmp.leftID.id[k], a->leftID.id[k], choice);
-        }
-        for (int k = 0; k < a->rightID.id.size(); k++) {
-            a->rightID.id[k] = Node::conditional_select(tmp.rightID.id[k], a->rightID.id[k], choice);
+        conditional_swap((byte_t*) a, (byte_t*) b, offsetof(Node, payload), choice);
+        if (!a->payload.empty()) {
+            conditional_swap(a->payload.data(), b->payload.data(), a->payload.size(), choice);
         }
     }
 
@@ -251,6 +238,9 @@ public:
     }
 };
 
+// bytes of a node in a block of storage, its payload if any follows them
+const size_t NODE_SIZE = offsetof(Node, payload);
+
 struct Block {
     unsigned long long id;
     block data;
@@ -274,11 +264,13 @@ public:
 
 class ORAM {
 private:
+    friend class Microbenchmark;
 
     unsigned long long INF;
     unsigned int PERMANENT_STASH_SIZE;
 
     size_t blockSize;
+    size_t payloadSize = 0;
     unordered_map<long long, Bucket> virtualStorage;
     Cache stash, incStash;
     unsigned long long currentLeaf;
@@ -293,8 +285,12 @@ private:
     bool useLocalRamStore = false;
     LocalRAMStore* localStore;
     int storeBlockSize;
+    int storeHandle = -1; // untrusted store holding the buckets
     int stashCounter = 0;
     bool isIncomepleteRead = false;
+    PathPrefetcher* prefetcher = NULL; // set when the ORAM was created with pipelining on
+    bool leafReserved = false;
+    unsigned long long reservedLeaf;
 
     unsigned long long RandomPath();
     long long GetNodeOnPath(long long leaf, int depth);
@@ -320,15 +316,30 @@ private:
     void beginOperation();
 
 public:
-    ORAM(long long maxSize, bytes<Key> key, bool simulation,bool isEmptyMap);
+    /**
+     * @param store handle of a store the client already filled, -1 sets up
+     * a new store for this ORAM
+     */
+    ORAM(long long maxSize, bytes<Key> key, bool simulation, bool isEmptyMap, int store = -1);
     void InitializeORAMBuckets();
     void InitializeBucketsOneByOne();
     void InitializeBucketsInBatch();
 
 
-    ORAM(long long maxSize, bytes<Key> oram_key, vector<Node*>* nodes);
+    /**
+     * @param payload bytes of payload carried by every block, the nodes
+     * must hold that many
+     */
+    ORAM(long long maxSize, bytes<Key> oram_key, vector<Node*>* nodes, size_t payload = 0);
     ORAM(long long maxSize, bytes<Key> oram_key, vector<Node*>* nodes, map<unsigned long long, unsigned long long> permutation);
 
+    /**
+     * Leaves for the nodes of a bulk build: Z slots per leaf, shuffled, so
+     * every node gets a uniformly random leaf and no leaf bucket overflows
+     * @return leaves * Z leaf numbers
+     */
+    static vector<unsigned long long> ShuffledLeaves(long long leaves);
+
     ~ORAM();
     double evicttime = 0;
     int evictcount = 0;
@@ -346,13 +357,47 @@ public:
     // node - node to write, value - new value to be set for bid,
     Node* ReadWrite(Bid bid, Node* node, unsigned long long lastLeaf, unsigned long long newLeaf, bool isRead, bool isDummy, std::array< byte_t, 16> value, bool overwrite, bool isIncompleteRead);
     // targetNode - used in the search of avl tree - used for early eviction, targetNode is the targer child
-    Node* ReadWrite(Bid bid, unsigned long long lastLeaf, unsigned long long newLeaf, bool isDummy, unsigned long long newChildPos, Bid targetNode);
+    // deferEviction - the caller evicts through evictAndPrefetch once it knows the next leaf
+    Node* ReadWrite(Bid bid, unsigned long long lastLeaf, unsigned long long newLeaf, bool isDummy, unsigned long long newChildPos, Bid targetNode, bool deferEviction = false);
+    /**
+     * Access of ObliviousArray: reads block bid from the path of lastLeaf,
+     * moves it to newLeaf and replaces the bytes of its value selected by
+     * mask (0xFF) with those of value, in one path read and one eviction
+     * @param payload replaces the payload of the block when writePayload is set
+     * @return copy of the block before the update, with its payload
+     */
+    Node* Access(Bid bid, unsigned long long lastLeaf, unsigned long long newLeaf, const std::array<byte_t, 16>& value, const std::array<byte_t, 16>& mask, const block* payload = NULL, bool writePayload = false);
+
+    /**
+     * ORAMs created while this is set read the path of the next access on a
+     * helper thread while the current access is evicted (see evictAndPrefetch)
+     */
+    static bool pipelining;
+    bool pipelined();
+    /**
+     * Draws the leaf the next dummy access will fetch, so that it can be
+     * prefetched before that access starts
+     */
+    unsigned long long ReserveRandomPath();
+    /**
+     * Starts reading the buckets of the path to nextLeaf that are neither
+     * cached in the enclave nor on the current path, then evicts the current
+     * path. The next FetchPath waits for the read. Buckets on both paths are
+     * taken from the enclave copy the eviction left behind, or read again
+     * after the eviction when it writes them back.
+     */
+    void evictAndPrefetch(unsigned long long nextLeaf);
 
     void start(bool batchWrite);
     void prepareForEvictionTest();
     void evict(bool evictBuckets);
-    void finilize(bool noDummyOp = false);
+    /**
+     * @param writeBack false keeps the buckets of the operation in the enclave
+     *        for the next one, as in a batch that is written back once at its end
+     */
+    void finilize(bool noDummyOp = false, bool writeBack = true);
     bool profile = false;
+    StashStats stashStats;
 };
 
 #endif
@@ -6,13 +6,39 @@
 #include "OMAP.h"
 #include <string>
 #include "DOHEAP.hpp"
+#include "Trace.hpp"
+#include "IOStats.hpp"
+#include "ShardedOMAP.hpp"
+#include "ObliviousGraph.hpp"
+#include "ObliviousArray.hpp"
+#include "OQueue.hpp"
+#include "OStack.hpp"
+#include "OMultimap.hpp"
+#include "OBlobStore.hpp"
+#include "EdgeListGraph.hpp"
+#include "PageRankGraph.hpp"
+#include <algorithm>
 
 static OMAP* omap = NULL;
+static ShardedOMAP* shardedOmap = NULL;
 static DOHEAP* oheap = NULL;
+static ObliviousGraph* graph = NULL;
+static vector<GraphEntry> streamedEdges;
+static EdgeListGraph* edgeList = NULL;
+static PageRankGraph* rankGraph = NULL;
+static ObliviousArray* oarray = NULL;
+static OQueue* oqueue = NULL;
+static OStack* ostack = NULL;
+static OMultimap* omultimap = NULL;
+static OBlobStore* blobStore = NULL;
 
-void ecall_setup_oheap(int maxSize) {
+/**
+ * @param decreaseKey 1 tracks the leaves of ids 0..maxSize so that operation 4 decreases keys
+ */
+void ecall_setup_oheap(int maxSize, int decreaseKey) {
     bytes<Key> tmpkey{0};
-    oheap = new DOHEAP(maxSize, tmpkey, false);
+    delete oheap;
+    oheap = new DOHEAP(maxSize, tmpkey, false, decreaseKey != 0);
     //        oheap = new OHeap(omap, maxSize);
 }
 
@@ -24,7 +50,9 @@ void ecall_set_new_minheap_node(int newMinHeapNodeV, int newMinHeapNodeDist) {
     for (int i = 0; i < 4; i++) {
         value[i] = (byte_t) (newMinHeapNodeV >> (i * 8));
     }
+    IOStats::beginEcall(IO_HEAP);
     oheap->execute(id, value, 2);
+    IOStats::endEcall();
 }
 
 void ecall_execute_heap_operation(int* v, int* dist, int op) {
@@ -37,12 +65,485 @@ void ecall_execute_heap_operation(int* v, int* dist, int op) {
     for (int i = 0; i < 4; i++) {
         value[i] = (byte_t) (val >> (i * 8));
     }
+    IOStats::beginEcall(IO_HEAP);
     pair<Bid, array<byte_t, 16> > res = oheap->execute(id, value, op);
+    IOStats::endEcall();
     int rr = res.first.getValue();
     *dist = rr;
     std::memcpy(v, res.second.data(), sizeof (int));
 }
 
+/**
+ * @param op 1: extract count minimums into v and dist  2: insert the count pairs
+ */
+void ecall_execute_heap_batch(int* v, int* dist, size_t count, int op) {
+    IOStats::beginEcall(IO_HEAP);
+    if (op == 2) {
+        vector<pair<Bid, array<byte_t, 16> > > elements(count);
+        for (size_t i = 0; i < count; i++) {
+            elements[i].first = dist[i];
+            std::fill(elements[i].second.begin(), elements[i].second.end(), 0);
+            for (int j = 0; j < 4; j++) {
+                elements[i].second[j] = (byte_t) (v[i] >> (j * 8));
+            }
+        }
+        oheap->batchInsert(elements);
+    } else if (op == 1) {
+        vector<pair<Bid, array<byte_t, 16> > > res = oheap->batchExtractMin((int) count);
+        for (size_t i = 0; i < count; i++) {
+            dist[i] = (int) res[i].first.getValue();
+            std::memcpy(&v[i], res[i].second.data(), sizeof (int));
+        }
+    }
+    IOStats::endEcall();
+}
+
+/**
+ * Appends a chunk of directed edges to the graph being ingested, edges with
+ * an end below 1 are dropped
+ */
+void ecall_stream_graph_edges(const int* sources, const int* destinations, const int* weights, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (sources[i] < 1 || destinations[i] < 1) {
+            continue;
+        }
+        GraphEntry edge = {0, sources[i], destinations[i], weights[i], 0, 0};
+        streamedEdges.push_back(edge);
+    }
+}
+
+/**
+ * Drops the streamed edges with an end past vertexCount, which would index
+ * past the vertices of the graph built from them
+ * @return false if vertexCount is not positive, the edges are then dropped
+ */
+static bool checkStreamedEdges(int vertexCount) {
+    if (vertexCount < 1) {
+        printf("Invalid vertex count %d\n", vertexCount);
+        vector<GraphEntry>().swap(streamedEdges);
+        return false;
+    }
+    streamedEdges.erase(std::remove_if(streamedEdges.begin(), streamedEdges.end(), [vertexCount](const GraphEntry & edge) {
+        return edge.source > vertexCount || edge.destination > vertexCount;
+    }), streamedEdges.end());
+    return true;
+}
+
+static bool isVertex(int v) {
+    return graph != NULL && v >= 1 && v <= graph->vertices();
+}
+
+/**
+ * Replaces the graph with the edges streamed so far
+ * @param bulk 1: oblivious sort and bulk construction of the OMAP  0: one OMAP insert per vertex and edge
+ * @param spareEdges directed edges that can be added later on top of the streamed ones
+ */
+void ecall_build_graph(int vertexCount, int bulk, long long spareEdges, double* buildTime) {
+    bytes<Key> tmpkey{0};
+    delete graph;
+    graph = NULL;
+    *buildTime = 0;
+    if (!checkStreamedEdges(vertexCount) || spareEdges < 0) {
+        return;
+    }
+    IOStats::beginBatch();
+    ocall_start_timer(961);
+    if (bulk) {
+        graph = new ObliviousGraph(vertexCount, &streamedEdges, tmpkey, spareEdges);
+    } else {
+        graph = new ObliviousGraph(vertexCount, (long long) streamedEdges.size(), tmpkey, spareEdges);
+        graph->load(streamedEdges);
+    }
+    ocall_stop_timer(buildTime, 961);
+    IOStats::endEcall();
+    vector<GraphEntry>().swap(streamedEdges);
+}
+
+/**
+ * Adds a directed edge to the graph built last, or sets its weight if it
+ * exists. Nothing happens if an end is not a vertex.
+ */
+void ecall_add_graph_edge(int source, int destination, int weight) {
+    if (!isVertex(source) || !isVertex(destination)) {
+        return;
+    }
+    IOStats::beginBatch();
+    graph->addEdge(source, destination, weight);
+    IOStats::endEcall();
+}
+
+/**
+ * Removes a directed edge from the graph built last, with the same accesses as an addition
+ */
+void ecall_remove_graph_edge(int source, int destination) {
+    if (!isVertex(source) || !isVertex(destination)) {
+        return;
+    }
+    IOStats::beginBatch();
+    graph->removeEdge(source, destination);
+    IOStats::endEcall();
+}
+
+/**
+ * Applies count edge updates in order, writing the OMAP buckets back once.
+ * Updates with an end that is not a vertex are skipped.
+ * @param removes 1 removes the edge, 0 adds it or sets its weight
+ * @return number of directed edges after the updates, 0 if no graph is built
+ */
+long long ecall_update_graph_edges(const int* sources, const int* destinations, const int* weights, const int* removes, size_t count) {
+    if (graph == NULL) {
+        return 0;
+    }
+    vector<GraphEntry> updates;
+    for (size_t i = 0; i < count; i++) {
+        if (!isVertex(sources[i]) || !isVertex(destinations[i])) {
+            continue;
+        }
+        GraphEntry update = {0, sources[i], destinations[i], weights[i], removes[i], 0};
+        updates.push_back(update);
+    }
+    IOStats::beginBatch();
+    graph->updateEdges(updates);
+    IOStats::endEcall();
+    return graph->edges();
+}
+
+/**
+ * Dijkstra from source on the graph built last
+ * @param distances distance of every vertex, -1 if it is unreachable, all
+ * -1 if no graph is built or source is not a vertex of it
+ * @param phaseTimes heap setup, search and collect times
+ */
+void ecall_run_sssp(int source, long long* distances, size_t len, double* phaseTimes) {
+    if (!isVertex(source)) {
+        std::fill(distances, distances + len, -1);
+        std::fill(phaseTimes, phaseTimes + 3, 0);
+        return;
+    }
+    IOStats::beginBatch();
+    graph->sssp(source, &phaseTimes[0]);
+    ocall_start_timer(961);
+    for (size_t v = 0; v < len; v++) {
+        long long dist = v >= 1 && v <= (size_t) graph->vertices() ? graph->distance((int) v) : ObliviousGraph::INF_DISTANCE;
+        distances[v] = dist == ObliviousGraph::INF_DISTANCE ? -1 : dist;
+    }
+    ocall_stop_timer(&phaseTimes[2], 961);
+    IOStats::endEcall();
+}
+
+/**
+ * Replaces the edge list graph with the edges streamed so far, no OMAP is built
+ */
+void ecall_build_edge_list(int vertexCount) {
+    delete edgeList;
+    edgeList = NULL;
+    if (!checkStreamedEdges(vertexCount)) {
+        return;
+    }
+    edgeList = new EdgeListGraph(vertexCount, streamedEdges);
+    vector<GraphEntry>().swap(streamedEdges);
+}
+
+/**
+ * Sort-and-scan BFS on the edge list graph
+ * @param rounds public bound on the depth, vertex count - 1 if not positive
+ * @param hops hops from source of every vertex, -1 if it is unreachable, all
+ * -1 if no edge list is built or source is not a vertex of it
+ */
+void ecall_run_bfs(int source, int rounds, long long* hops, size_t len, double* time) {
+    if (edgeList == NULL || source < 1 || source > edgeList->vertices()) {
+        std::fill(hops, hops + len, -1);
+        *time = 0;
+        return;
+    }
+    IOStats::beginBatch();
+    ocall_start_timer(961);
+    edgeList->bfs(source, rounds, hops, len);
+    ocall_stop_timer(time, 961);
+    IOStats::endEcall();
+    for (size_t v = 0; v < len; v++) {
+        hops[v] = hops[v] == EdgeListGraph::INF_HOPS ? -1 : hops[v];
+    }
+}
+
+/**
+ * Sort-and-scan connected components on the edge list graph
+ * @param rounds public bound on the diameter, vertex count - 1 if not positive
+ * @param labels smallest vertex id of the component of every vertex
+ */
+void ecall_run_components(int rounds, long long* labels, size_t len, double* time) {
+    if (edgeList == NULL) {
+        std::fill(labels, labels + len, 0);
+        *time = 0;
+        return;
+    }
+    IOStats::beginBatch();
+    ocall_start_timer(961);
+    edgeList->components(rounds, labels, len);
+    ocall_stop_timer(time, 961);
+    IOStats::endEcall();
+}
+
+/**
+ * Minimum spanning forest of the graph built last
+ * @param strategy 0: Prim over DOHEAP on the OMAP graph  1: sort-and-scan Borůvka on the edge list graph
+ * @param sources first len edges of the forest, edgeCount is the number of edges,
+ * 0 if the graph of the strategy is not built
+ */
+void ecall_run_mst(int strategy, long long* totalWeight, int* sources, int* destinations, int* weights, size_t len, int* edgeCount, double* time) {
+    *totalWeight = 0;
+    *edgeCount = 0;
+    *time = 0;
+    if ((strategy == 0 && graph == NULL) || (strategy != 0 && edgeList == NULL)) {
+        return;
+    }
+    vector<GraphEntry> forest;
+    double phaseTimes[2];
+    IOStats::beginBatch();
+    ocall_start_timer(961);
+    if (strategy == 0) {
+        graph->mst(*totalWeight, forest, phaseTimes);
+    } else {
+        edgeList->spanningForest(*totalWeight, forest);
+    }
+    ocall_stop_timer(time, 961);
+    IOStats::endEcall();
+    *edgeCount = (int) forest.size();
+    for (size_t i = 0; i < len && i < forest.size(); i++) {
+        sources[i] = (int) forest[i].source;
+        destinations[i] = (int) forest[i].destination;
+        weights[i] = (int) forest[i].weight;
+    }
+}
+
+/**
+ * Writes the edges streamed so far to an encrypted untrusted store for PageRank
+ */
+void ecall_build_pagerank_graph(int vertexCount, double* buildTime) {
+    bytes<Key> tmpkey{0};
+    delete rankGraph;
+    rankGraph = NULL;
+    *buildTime = 0;
+    if (!checkStreamedEdges(vertexCount)) {
+        return;
+    }
+    IOStats::beginBatch();
+    ocall_start_timer(961);
+    rankGraph = new PageRankGraph(vertexCount, streamedEdges, tmpkey);
+    ocall_stop_timer(buildTime, 961);
+    IOStats::endEcall();
+    vector<GraphEntry>().swap(streamedEdges);
+}
+
+/**
+ * @param ranks rank of every vertex, all 0 if no PageRank graph is built
+ * @param iterationTime average time of an iteration
+ */
+void ecall_run_pagerank(int iterations, double damping, double* ranks, size_t len, double* iterationTime) {
+    if (rankGraph == NULL) {
+        std::fill(ranks, ranks + len, 0);
+        *iterationTime = 0;
+        return;
+    }
+    IOStats::beginBatch();
+    rankGraph->run(iterations, damping, ranks, len, iterationTime);
+    IOStats::endEcall();
+}
+
+/**
+ * Replaces the array, a size below 1 leaves none and the accesses do nothing
+ */
+void ecall_setup_oarray(long long size) {
+    bytes<Key> tmpkey{0};
+    delete oarray;
+    oarray = NULL;
+    if (size < 1) {
+        printf("Invalid array size %lld\n", size);
+        return;
+    }
+    oarray = new ObliviousArray(size, tmpkey);
+}
+
+static bool isArrayIndex(long long index) {
+    return oarray != NULL && index >= 0 && index < oarray->length();
+}
+
+/**
+ * Reads zeros if index is not in the array
+ */
+void ecall_read_oarray(long long index, char* value) {
+    if (!isArrayIndex(index)) {
+        std::memset(value, 0, 16);
+        return;
+    }
+    IOStats::beginEcall(IO_ARRAY);
+    std::array<byte_t, 16> res = oarray->read(index);
+    IOStats::endEcall();
+    std::memcpy(value, res.data(), 16);
+}
+
+/**
+ * Nothing happens if index is not in the array
+ */
+void ecall_write_oarray(long long index, const char* value) {
+    if (!isArrayIndex(index)) {
+        return;
+    }
+    std::array<byte_t, 16> val;
+    std::memcpy(val.data(), value, 16);
+    IOStats::beginEcall(IO_ARRAY);
+    oarray->write(index, val);
+    IOStats::endEcall();
+}
+
+/**
+ * Replaces the queue, a capacity below 1 leaves none and the operations fail
+ */
+void ecall_setup_oqueue(int capacity) {
+    bytes<Key> tmpkey{0};
+    delete oqueue;
+    oqueue = NULL;
+    if (capacity < 1) {
+        printf("Invalid queue capacity %d\n", capacity);
+        return;
+    }
+    oqueue = new OQueue(capacity, tmpkey);
+}
+
+/**
+ * As ecall_setup_oqueue, for the stack
+ */
+void ecall_setup_ostack(int capacity) {
+    bytes<Key> tmpkey{0};
+    delete ostack;
+    ostack = NULL;
+    if (capacity < 1) {
+        printf("Invalid stack capacity %d\n", capacity);
+        return;
+    }
+    ostack = new OStack(capacity, tmpkey);
+}
+
+/**
+ * @param op 1: pop  2: push *value  3: peek, a pop or peek returns the block in *value
+ * @return 0 if the queue was empty for a pop or peek, or full for a push,
+ * or if there is no queue
+ */
+int ecall_execute_queue_operation(int* value, int op) {
+    if (oqueue == NULL) {
+        return 0;
+    }
+    array<byte_t, 16> block;
+    std::fill(block.begin(), block.end(), 0);
+    std::memcpy(block.data(), value, sizeof (int));
+    IOStats::beginEcall(IO_ARRAY);
+    bool done = oqueue->execute(block, op);
+    IOStats::endEcall();
+    std::memcpy(value, block.data(), sizeof (int));
+    return done;
+}
+
+/**
+ * As ecall_execute_queue_operation, on the stack
+ */
+int ecall_execute_stack_operation(int* value, int op) {
+    if (ostack == NULL) {
+        return 0;
+    }
+    array<byte_t, 16> block;
+    std::fill(block.begin(), block.end(), 0);
+    std::memcpy(block.data(), value, sizeof (int));
+    IOStats::beginEcall(IO_ARRAY);
+    bool done = ostack->execute(block, op);
+    IOStats::endEcall();
+    std::memcpy(value, block.data(), sizeof (int));
+    return done;
+}
+
+/**
+ * @param capacity values held at once over all keys
+ * @param maxChain values held at once for one key, remove walks this many slots
+ */
+void ecall_setup_omultimap(long long capacity, int maxChain) {
+    bytes<Key> tmpkey{0};
+    delete omultimap;
+    omultimap = new OMultimap(capacity, maxChain, tmpkey);
+}
+
+/**
+ * @return 0 if the values of the key or the multimap are full
+ */
+int ecall_multimap_append(const char* bid, long long value) {
+    std::array<byte_t, ID_SIZE> id;
+    std::memcpy(id.data(), bid, ID_SIZE);
+    IOStats::beginEcall(IO_MULTIMAP);
+    bool done = omultimap->append(Bid(id), value);
+    IOStats::endEcall();
+    return done;
+}
+
+/**
+ * @param values newest value first, zero past the values of the key
+ * @return number of values found, at most maxCount
+ */
+int ecall_multimap_get(const char* bid, long long* values, size_t maxCount) {
+    std::array<byte_t, ID_SIZE> id;
+    std::memcpy(id.data(), bid, ID_SIZE);
+    IOStats::beginEcall(IO_MULTIMAP);
+    int count = omultimap->get(Bid(id), values, (int) maxCount);
+    IOStats::endEcall();
+    return count;
+}
+
+/**
+ * @return 0 if the key did not hold the value
+ */
+int ecall_multimap_remove(const char* bid, long long value) {
+    std::array<byte_t, ID_SIZE> id;
+    std::memcpy(id.data(), bid, ID_SIZE);
+    IOStats::beginEcall(IO_MULTIMAP);
+    bool done = omultimap->remove(Bid(id), value);
+    IOStats::endEcall();
+    return done;
+}
+
+/**
+ * @param records keys held at once
+ * @param chunkCount chunks of chunkSize bytes held at once over all values
+ * @param maxChunks chunks of the longest value, every access walks this many
+ */
+void ecall_setup_blob_store(long long records, long long chunkCount, int chunkSize, int maxChunks) {
+    bytes<Key> tmpkey{0};
+    delete blobStore;
+    blobStore = new OBlobStore(records, chunkCount, chunkSize, maxChunks, tmpkey);
+}
+
+/**
+ * @return 0 if the value is too long or the store is full, the old value is kept
+ */
+int ecall_write_blob(const char* bid, const char* data, size_t len) {
+    std::array<byte_t, ID_SIZE> id;
+    std::memcpy(id.data(), bid, ID_SIZE);
+    IOStats::beginEcall(IO_BLOB);
+    bool done = blobStore->write(Bid(id), string(data, len));
+    IOStats::endEcall();
+    return done;
+}
+
+/**
+ * @param data the first maxLen bytes of the value
+ * @return length of the whole value, 0 for a key that has none
+ */
+int ecall_read_blob(const char* bid, char* data, size_t maxLen) {
+    std::array<byte_t, ID_SIZE> id;
+    std::memcpy(id.data(), bid, ID_SIZE);
+    IOStats::beginEcall(IO_BLOB);
+    string value = blobStore->read(Bid(id));
+    IOStats::endEcall();
+    std::memcpy(data, value.data(), std::min(value.size(), maxLen));
+    return (int) value.size();
+}
+
 void ecall_dummy_heap_op() {
     //    oheap->dummyOperation();
 }
@@ -72,23 +573,27 @@ void ecall_print_tree() {
 
 void ecall_setup_oram(int max_size) {
     bytes<Key> tmpkey{0};
+    delete omap;
     omap = new OMAP(max_size, tmpkey);
 }
 
-void ecall_setup_omap_by_client(int max_size,const char *bid, long long rootPos,const char* secretKey){
+void ecall_setup_omap_by_client(int max_size, const char *bid, long long rootPos, const char* secretKey, int store) {
     bytes<Key> tmpkey;
     std::memcpy(tmpkey.data(), secretKey, Key);
     std::array<byte_t, ID_SIZE> id;
     std::memcpy(id.data(), bid, ID_SIZE);
     Bid rootBid(id);
-    omap = new OMAP(max_size, rootBid,rootPos,tmpkey);
+    delete omap;
+    omap = new OMAP(max_size, rootBid, rootPos, tmpkey, store);
 }
 
 void ecall_read_node(const char *bid, char* value) {
     std::array<byte_t, ID_SIZE> id;
     std::memcpy(id.data(), bid, ID_SIZE);
     Bid inputBid(id);
+    IOStats::beginEcall(IO_OMAP_READ);
     string res = omap->find(inputBid);
+    IOStats::endEcall();
     std::memcpy(value, res.c_str(), 16);
 }
 
@@ -97,14 +602,86 @@ void ecall_write_node(const char *bid, const char* value) {
     std::memcpy(id.data(), bid, ID_SIZE);
     Bid inputBid(id);
     string val(value);
+    IOStats::beginEcall(IO_OMAP_WRITE);
     omap->insert(inputBid, val);
+    IOStats::endEcall();
 }
 
 void ecall_delete_node(const char *bid) {
     std::array<byte_t, ID_SIZE> id;
     std::memcpy(id.data(), bid, ID_SIZE);
     Bid inputBid(id);
+    IOStats::beginEcall(IO_OMAP_DELETE);
     omap->deleteNode(inputBid);
+    IOStats::endEcall();
+}
+
+/**
+ * Executes the requests back to back in one enclave transition
+ * @param results 16 bytes per request, the value found by a read and zeros otherwise
+ * @return number of requests executed, the batch stops at an unknown operation
+ */
+int ecall_execute_batch(const omap_request* requests, char* results, size_t count) {
+    int executed = 0;
+    IOStats::beginBatch();
+    for (size_t i = 0; i < count; i++) {
+        std::array<byte_t, ID_SIZE> id;
+        std::memcpy(id.data(), requests[i].key, ID_SIZE);
+        Bid inputBid(id);
+        char* result = results + i * 16;
+        std::memset(result, 0, 16);
+        if (requests[i].op == OMAP_OP_READ) {
+            IOStats::setOperation(IO_OMAP_READ);
+            string res = omap->find(inputBid);
+            std::memcpy(result, res.data(), std::min(res.size(), (size_t) 16));
+        } else if (requests[i].op == OMAP_OP_WRITE) {
+            IOStats::setOperation(IO_OMAP_WRITE);
+            omap->insert(inputBid, string(requests[i].value, strnlen(requests[i].value, 16)));
+        } else if (requests[i].op == OMAP_OP_DELETE) {
+            IOStats::setOperation(IO_OMAP_DELETE);
+            omap->deleteNode(inputBid);
+        } else {
+            break;
+        }
+        executed++;
+    }
+    IOStats::endEcall();
+    return executed;
+}
+
+void ecall_setup_sharded_omap(int shards, int max_size) {
+    bytes<Key> tmpkey{0};
+    shards = std::max(1, std::min(shards, MAX_SHARDS));
+    delete shardedOmap;
+    shardedOmap = new ShardedOMAP(shards, max_size, tmpkey);
+}
+
+/**
+ * Same requests and results as ecall_execute_batch, spread over the shards
+ * @return number of requests executed, the batch is cut at the first unknown operation
+ */
+int ecall_execute_sharded_batch(const omap_request* requests, char* results, size_t count) {
+    vector<ShardRequest> batch;
+    for (size_t i = 0; i < count; i++) {
+        if (requests[i].op != OMAP_OP_READ && requests[i].op != OMAP_OP_WRITE && requests[i].op != OMAP_OP_DELETE) {
+            break;
+        }
+        ShardRequest request = ShardRequest();
+        std::array<byte_t, ID_SIZE> id;
+        std::memcpy(id.data(), requests[i].key, ID_SIZE);
+        request.op = requests[i].op;
+        request.key = Bid(id);
+        std::memcpy(request.value, requests[i].value, 16);
+        batch.push_back(request);
+    }
+    IOStats::beginBatch();
+    int executed = shardedOmap->execute(batch);
+    IOStats::endEcall();
+    std::memset(results, 0, 16 * count);
+    for (int i = 0; i < executed; i++) {
+        std::memcpy(results + i * 16, batch[i].result, 16);
+    }
+    return executed;
 }
 
 double ecall_measure_oram_speed(int testSize) {
@@ -231,6 +808,39 @@ void ecall_measure_btree_read_write_speed(int testSize) {
     printf("Average OMAP Write Time: %.2f\n", totalWriteTime / testSize);
 }
 
+void ecall_measure_stash_scan_speed(int testSize) {
+    vector<Node*> nodes;
+    for (int i = 0; i < testSize; i++) {
+        Node* tmp = new Node();
+        uint32_t randval;
+        sgx_read_rand((unsigned char *) &randval, 4);
+        tmp->key = (long long) randval + 1;
+        tmp->isDummy = false;
+        nodes.push_back(tmp);
+    }
+
+    printf("Begin test\n");
+    int tests = 10000;
+    int matches = 0;
+    double scanTime;
+    ocall_start_timer(535);
+    for (int i = 0; i < tests; i++) {
+        Bid target = nodes[i % testSize]->key;
+        for (Node* node : nodes) {
+            bool match = Node::CTeq(Bid::CTcmp(node->key, target), 0) && !node->isDummy;
+            matches = Node::conditional_select(matches + 1, matches, match);
+        }
+    }
+    ocall_stop_timer(&scanTime, 535);
+    printf("Average Stash Scan Time: %f\n", scanTime / tests);
+    printf("Average Bid Comparison Time: %f\n", scanTime / ((double) tests * testSize));
+    assert(matches >= tests);
+
+    for (Node* node : nodes) {
+        delete node;
+    }
+}
+
 
 double ecall_measure_omap_speed(int testSize) {
     double time1=0, time2=0, time3=0, time4=0, total = 0, totalWrite = 0, totalRead = 0, totalDelete = 0;
@@ -378,7 +988,9 @@ double ecall_measure_eviction_speed(int testSize) {
         }
         printf("Total Eviction Time: %f\n", total / 100);
     }
-    return oram->evicttime / oram->evictcount;
+    double average = oram->evicttime / oram->evictcount;
+    delete oram;
+    return average;
 }
 
 double ecall_measure_oram_setup_speed(int testSize) {
@@ -425,6 +1037,7 @@ double ecall_measure_oram_setup_speed(int testSize) {
     //    Node* res = oram->ReadWrite(id, dummyNode, readpos, readpos, true, false);
     //     assert(!res->isDummy);
     printf("Setup time is:%f\n", time2);
+    delete oram;
 }
 
 double ecall_measure_omap_setup_speed(int testSize) {
@@ -460,9 +1073,62 @@ double ecall_measure_omap_setup_speed(int testSize) {
     Bid testKey = 3;
     string res = omap->find(testKey);
     assert(strcmp(res.c_str(), "test_3") == 0);
+    delete omap;
 
     //    printf("Creating AVL time is:%f\n", omap->treeHandler->times[0][0]);
     //    printf("ORAM Setup:%f\n", omap->treeHandler->times[1][0]);
 }
+/**
+ * Takes effect for ORAMs and heaps created after the call
+ */
+void ecall_set_stash_failure_probability(double probability) {
+    StashConfig::failureProbability = probability;
+}
+
+/**
+ * @param structure 0 -> OMAP's ORAM, 1 -> DOHEAP
+ * @return maximum stash occupancy seen so far, -1 if the structure is not set up
+ */
+int ecall_get_stash_stats(int structure, long long* histogram, size_t len, long long* overflows) {
+    StashStats* stats = NULL;
+    if (structure == 0 && omap != NULL) {
+        stats = &omap->treeHandler->getORAM()->stashStats;
+    } else if (structure == 1 && oheap != NULL) {
+        stats = &oheap->stashStats;
+    }
+    if (stats == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        histogram[i] = i < stats->histogram.size() ? stats->histogram[i] : 0;
+    }
+    *overflows = stats->overflows;
+    return stats->maxOccupancy;
+}
+void ecall_set_tracing(int enabled) {
+    Trace::enabled = enabled != 0;
+}
+
+/**
+ * Pipelined path reads for the ORAMs set up after this call
+ */
+void ecall_set_pipelining(int enabled) {
+    ORAM::pipelining = enabled != 0;
+}
+
+void ecall_flush_trace() {
+    Trace::flush();
+}
+/**
+ * @param operation one of IOOperation
+ * @param counters filled with the IOCounter values of the operation
+ */
+void ecall_get_io_stats(int operation, long long* counters, size_t len) {
+    IOStats::get(operation, counters, len);
+}
+
+void ecall_reset_io_stats() {
+    IOStats::reset();
+}
 #endif /* ORAMENCLAVEINTERFACE_CPP */
 
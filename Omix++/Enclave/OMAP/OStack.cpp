@@ -0,0 +1,37 @@
+#include "OStack.hpp"
+
+OStack::OStack(long long capacity, bytes<Key> key)
+: capacity(capacity) {
+    blocks = new ObliviousArray(capacity, key);
+}
+
+OStack::~OStack() {
+    delete blocks;
+}
+
+bool OStack::execute(array<byte_t, 16>& value, int op) {
+    bool isPush = Node::CTeq(op, 2);
+    bool isPop = Node::CTeq(op, 1);
+    bool hasRoom = Node::CTeq(Node::CTcmp(top, capacity), -1);
+    bool hasBlock = Node::CTeq(Node::CTcmp(top, 0LL), 1);
+    bool done = Node::conditional_select((int) hasRoom, (int) hasBlock, isPush);
+
+    // a push writes above the top, a pop or peek reads the top, an empty stack reads block 0
+    long long index = Node::conditional_select(top, Node::conditional_select(top - 1, 0LL, hasBlock), isPush);
+    index = Node::conditional_select(index, 0LL, done);
+    array<byte_t, 16> mask;
+    byte_t write = Node::conditional_select((byte_t) 0xFF, (byte_t) 0, isPush && done);
+    std::fill(mask.begin(), mask.end(), write);
+    array<byte_t, 16> old = blocks->access(index, value, mask);
+
+    top = Node::conditional_select(top + 1, top, isPush && done);
+    top = Node::conditional_select(top - 1, top, isPop && done);
+    for (int k = 0; k < value.size(); k++) {
+        value[k] = Node::conditional_select(old[k], (byte_t) 0, !isPush && done);
+    }
+    return done;
+}
+
+long long OStack::size() {
+    return top;
+}
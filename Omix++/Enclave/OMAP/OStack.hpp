@@ -0,0 +1,31 @@
+#ifndef OSTACK_H
+#define OSTACK_H
+
+#include "ObliviousArray.hpp"
+
+/**
+ * A bounded LIFO stack of 16 byte blocks in an ObliviousArray, addressed by
+ * the top counter kept in the enclave. Push, pop and peek are each one
+ * access to the array and cannot be told apart from outside.
+ */
+class OStack {
+private:
+    ObliviousArray* blocks;
+    long long capacity;
+    long long top = 0;
+
+public:
+    OStack(long long capacity, bytes<Key> key);
+    virtual ~OStack();
+
+    /**
+     * @param value pushed for op 2, the popped or peeked block on return
+     * @param op 1: pop  2: push  3: peek
+     * @return false if a pop or peek found the stack empty or a push found
+     * it full, the access is made either way
+     */
+    bool execute(array<byte_t, 16>& value, int op);
+    long long size();
+};
+
+#endif /* OSTACK_H */
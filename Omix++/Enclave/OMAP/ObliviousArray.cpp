@@ -0,0 +1,144 @@
+#include "ObliviousArray.hpp"
+#include "sgx_trts.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+ObliviousArray::ObliviousArray(long long size, bytes<Key> key, vector<std::array<byte_t, 16> >* values, size_t payload)
+: size(std::max(size, 1LL)), payloadSize(payload) {
+    int depth = (int) (ceil(log2(this->size)) - 1) + 1;
+    maxOfRandom = (long long) (pow(2, depth));
+
+    vector<unsigned long long> leaves = ORAM::ShuffledLeaves(maxOfRandom);
+    long long slots = (long long) leaves.size();
+
+    vector<Node*> nodes;
+    for (long long i = 0; i < slots; i++) {
+        Node* node = new Node();
+        node->index = i + 1;
+        node->key = Bid(i + 1);
+        node->isDummy = i >= this->size;
+        node->pos = leaves[i];
+        node->height = 1;
+        node->leftID = 0;
+        node->rightID = 0;
+        node->leftPos = 0;
+        node->rightPos = 0;
+        node->modified = false;
+        std::fill(node->value.begin(), node->value.end(), 0);
+        std::fill(node->dum.begin(), node->dum.end(), 0);
+        node->payload.resize(payloadSize, 0);
+        if (values != NULL && i < (long long) values->size()) {
+            node->value = (*values)[i];
+        }
+        nodes.push_back(node);
+    }
+
+    if (this->size <= OARRAY_LOCAL_POSITIONS) {
+        positions.assign(leaves.begin(), leaves.begin() + this->size);
+    } else {
+        vector<std::array<byte_t, 16> > packed((this->size + POSITIONS_PER_BLOCK - 1) / POSITIONS_PER_BLOCK);
+        for (long long i = 0; i < this->size; i++) {
+            unsigned int leaf = (unsigned int) leaves[i];
+            std::memcpy(packed[i / POSITIONS_PER_BLOCK].data() + (i % POSITIONS_PER_BLOCK) * sizeof (unsigned int), &leaf, sizeof (unsigned int));
+        }
+        vector<unsigned long long>().swap(leaves);
+        positionMap = new ObliviousArray((long long) packed.size(), key, &packed);
+    }
+    oram = new ORAM(this->size, key, &nodes, payloadSize);
+}
+
+ObliviousArray::~ObliviousArray() {
+    delete oram;
+    delete positionMap;
+}
+
+unsigned int ObliviousArray::RandomPath() {
+    uint32_t val;
+    sgx_read_rand((unsigned char *) &val, 4);
+    return val % (maxOfRandom);
+}
+
+unsigned int ObliviousArray::updatePosition(long long index, unsigned int newPos) {
+    unsigned int oldPos = 0;
+    if (positionMap == NULL) {
+        for (long long i = 0; i < size; i++) {
+            bool match = Node::CTeq(i, index);
+            oldPos = Node::conditional_select(positions[i], oldPos, match);
+            positions[i] = Node::conditional_select(newPos, positions[i], match);
+        }
+        return oldPos;
+    }
+    int slot = (int) (index % POSITIONS_PER_BLOCK);
+    std::array<byte_t, 16> value, mask;
+    std::fill(mask.begin(), mask.end(), 0);
+    for (int s = 0; s < POSITIONS_PER_BLOCK; s++) {
+        bool match = Node::CTeq(s, slot);
+        for (int b = 0; b < (int) sizeof (unsigned int); b++) {
+            value[s * sizeof (unsigned int) + b] = (byte_t) (newPos >> (b * 8));
+            mask[s * sizeof (unsigned int) + b] = Node::conditional_select((byte_t) 0xFF, (byte_t) 0, match);
+        }
+    }
+    std::array<byte_t, 16> old = positionMap->access(index / POSITIONS_PER_BLOCK, value, mask);
+    for (int s = 0; s < POSITIONS_PER_BLOCK; s++) {
+        unsigned int pos;
+        std::memcpy(&pos, old.data() + s * sizeof (unsigned int), sizeof (unsigned int));
+        oldPos = Node::conditional_select(pos, oldPos, Node::CTeq(s, slot));
+    }
+    return oldPos;
+}
+
+std::array<byte_t, 16> ObliviousArray::access(long long index, const std::array<byte_t, 16>& value, const std::array<byte_t, 16>& mask) {
+    unsigned int newPos = RandomPath();
+    unsigned int pos = updatePosition(index, newPos);
+    oram->start(false);
+    Node* node = oram->Access(Bid(index + 1), pos, newPos, value, mask);
+    oram->finilize(false, !batched);
+    std::array<byte_t, 16> res = node->value;
+    delete node;
+    return res;
+}
+
+std::array<byte_t, 16> ObliviousArray::access(long long index, const std::array<byte_t, 16>& value, const std::array<byte_t, 16>& mask, block& payload, bool writePayload) {
+    unsigned int newPos = RandomPath();
+    unsigned int pos = updatePosition(index, newPos);
+    oram->start(false);
+    Node* node = oram->Access(Bid(index + 1), pos, newPos, value, mask, &payload, writePayload);
+    oram->finilize(false, !batched);
+    std::array<byte_t, 16> res = node->value;
+    payload.swap(node->payload);
+    delete node;
+    return res;
+}
+
+std::array<byte_t, 16> ObliviousArray::read(long long index) {
+    std::array<byte_t, 16> none;
+    std::fill(none.begin(), none.end(), 0);
+    return access(index, none, none);
+}
+
+void ObliviousArray::write(long long index, std::array<byte_t, 16> value) {
+    std::array<byte_t, 16> all;
+    std::fill(all.begin(), all.end(), 0xFF);
+    access(index, value, all);
+}
+
+long long ObliviousArray::length() {
+    return size;
+}
+
+void ObliviousArray::beginBatch() {
+    batched = true;
+    if (positionMap != NULL) {
+        positionMap->beginBatch();
+    }
+}
+
+void ObliviousArray::endBatch() {
+    batched = false;
+    oram->start(false);
+    oram->finilize();
+    if (positionMap != NULL) {
+        positionMap->endBatch();
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef OBLIVIOUSARRAY_H
+#define OBLIVIOUSARRAY_H
+
+#include "ORAM.hpp"
+#include <vector>
+#include <array>
+
+// arrays up to this many blocks keep their position map in the enclave, larger ones in a smaller ObliviousArray
+#ifndef OARRAY_LOCAL_POSITIONS
+#define OARRAY_LOCAL_POSITIONS 4096
+#endif
+
+/**
+ * A fixed-size array of 16 byte blocks on the Path-ORAM core, addressed by
+ * index instead of by key. Block i is stored under Bid i + 1 and an access
+ * is one ORAM access plus the lookup of its leaf. The leaves are kept in the
+ * enclave and scanned in full for small arrays, and packed four to a block
+ * in a recursive ObliviousArray otherwise. Blocks can also carry a payload
+ * of a size fixed per array, which only that array's buckets pay for.
+ */
+class ObliviousArray {
+private:
+    static const int POSITIONS_PER_BLOCK = 4;
+
+    ORAM* oram;
+    ObliviousArray* positionMap = NULL;
+    vector<unsigned int> positions;
+    long long size;
+    long long maxOfRandom;
+    size_t payloadSize;
+    bool batched = false;
+
+    unsigned int RandomPath();
+    /**
+     * Sets the leaf of block index to newPos
+     * @return the leaf it had before
+     */
+    unsigned int updatePosition(long long index, unsigned int newPos);
+
+public:
+    /**
+     * @param size blocks, at least one is kept so that an empty stack or
+     * queue still has a block for its accesses
+     * @param values initial blocks, all zero if NULL
+     * @param payload bytes of payload of every block, initially zero
+     */
+    ObliviousArray(long long size, bytes<Key> key, vector<std::array<byte_t, 16> >* values = NULL, size_t payload = 0);
+    virtual ~ObliviousArray();
+
+    /**
+     * Replaces the bytes of block index selected by mask with those of value,
+     * so a read and a write are the same access
+     * @return the block before the update
+     */
+    std::array<byte_t, 16> access(long long index, const std::array<byte_t, 16>& value, const std::array<byte_t, 16>& mask);
+    /**
+     * Same access for an array with a payload. The payload of the block is
+     * returned in payload, and replaced by the one passed in when
+     * writePayload is set, which must then be of the payload size.
+     */
+    std::array<byte_t, 16> access(long long index, const std::array<byte_t, 16>& value, const std::array<byte_t, 16>& mask, block& payload, bool writePayload);
+    std::array<byte_t, 16> read(long long index);
+    void write(long long index, std::array<byte_t, 16> value);
+    long long length();
+    /**
+     * Until endBatch, accesses keep the buckets they touch in the enclave
+     * and endBatch writes them back at once, the position map included
+     */
+    void beginBatch();
+    void endBatch();
+};
+
+#endif /* OBLIVIOUSARRAY_H */
@@ -0,0 +1,335 @@
+#include "ObliviousGraph.hpp"
+#include "../Enclave.h"
+#include "Enclave_t.h"
+#include "IOStats.hpp"
+#include "ObliviousOperations.h"
+#include "ObliviousArray.hpp"
+#include "OMapEntry.hpp"
+#include <cstring>
+#include <algorithm>
+#include <map>
+
+const long long ObliviousGraph::INF_DISTANCE = 1LL << 62;
+// heavier than any edge weight, which is an int
+static const long long ROOT_WEIGHT = 1LL << 40;
+
+// a record, an edge and a slot entry per vertex and edge, and an edge and a slot entry per spare edge
+ObliviousGraph::ObliviousGraph(int vertexCount, long long edgeCount, bytes<Key> key, long long spareEdges)
+: vertexCount(vertexCount), edgeCount(edgeCount), edgeCapacity(edgeCount + spareEdges), key(key) {
+    omap = new OMAP((int) (2 * (vertexCount + edgeCapacity)), key);
+}
+
+ObliviousGraph::ObliviousGraph(int vertexCount, vector<GraphEntry>* edges, bytes<Key> key, long long spareEdges)
+: vertexCount(vertexCount), edgeCount((long long) edges->size()), edgeCapacity((long long) edges->size() + spareEdges), key(key) {
+    vector<GraphEntry>& entries = *edges;
+    for (long long i = 0; i < edgeCount; i++) {
+        entries[i].sortKey = ((unsigned long long) entries[i].source << 32) | (unsigned long long) entries[i].destination;
+    }
+    for (int v = 1; v <= vertexCount; v++) {
+        GraphEntry record = {(unsigned long long) v << 32, v, 0, 0, 0, 0};
+        entries.push_back(record);
+    }
+    ObliviousOperations::bitonicSort(&entries);
+
+    // parallel edges would share a slot entry, so each run of them keeps its last edge with the lightest
+    // weight and the others become padding, with no source and sorted past every vertex
+    long long count = (long long) entries.size();
+    long long lightest = 0;
+    for (long long i = 0; i < count; i++) {
+        bool same = i > 0 && Bid::CTeq(entries[i].sortKey, entries[i - 1].sortKey);
+        lightest = Bid::conditional_select(lightest, entries[i].weight, same && Bid::CTeq(Bid::CTcmp(lightest, entries[i].weight), -1));
+        entries[i].weight = lightest;
+    }
+    long long parallelEdges = 0;
+    for (long long i = 0; i < count; i++) {
+        bool parallel = i + 1 < count && Bid::CTeq(entries[i].sortKey, entries[i + 1].sortKey);
+        entries[i].sortKey = Bid::conditional_select(1ULL << 63 | (unsigned long long) i, entries[i].sortKey, parallel);
+        entries[i].source = Bid::conditional_select(0LL, entries[i].source, parallel);
+        parallelEdges += parallel;
+    }
+    ObliviousOperations::bitonicSort(&entries);
+    edgeCount -= parallelEdges;
+
+    // every vertex record comes right before its edges, they are numbered from 1
+    vector<long long> rank(count);
+    long long previous = 0, current = 0;
+    for (long long i = 0; i < count; i++) {
+        current = Bid::conditional_select(current + 1, 0LL, Bid::CTeq(entries[i].source, previous));
+        rank[i] = current;
+        previous = entries[i].source;
+    }
+    // the degree is the rank of the last edge of the vertex, carried back to its record
+    // the slot entries follow in the same order, a vertex record gets an unused one so no compaction is needed
+    vector<pair<Bid, string> > pairs(2 * count);
+    long long degree = 0, following = 0;
+    for (long long i = count - 1; i >= 0; i--) {
+        degree = Bid::conditional_select(rank[i], degree, !Bid::CTeq(entries[i].source, following));
+        following = entries[i].source;
+        bool isRecord = Bid::CTeq(entries[i].destination, 0LL);
+        bool isPadding = Bid::CTeq(entries[i].source, 0LL);
+        pairs[i].first = Bid::conditional_select(VertexKey(entries[i].source), EdgeKey(entries[i].source, rank[i]), isRecord);
+        pairs[i].first = Bid::conditional_select(PaddingKey(i, false), pairs[i].first, isPadding);
+        pairs[i].second = OMapEntry::Pack(Bid::conditional_select(INF_DISTANCE, entries[i].destination, isRecord), Bid::conditional_select(degree, entries[i].weight, isRecord));
+        pairs[count + i].first = Bid::conditional_select(PaddingKey(i, true), SlotKey(entries[i].source, entries[i].destination), isPadding);
+        pairs[count + i].second = OMapEntry::Pack(rank[i], 0);
+    }
+    vector<GraphEntry>().swap(entries);
+    omap = new OMAP((int) (2 * (vertexCount + edgeCapacity)), key, &pairs);
+}
+
+ObliviousGraph::~ObliviousGraph() {
+    delete omap;
+}
+
+Bid ObliviousGraph::VertexKey(long long v) {
+    return Bid(v << 32);
+}
+
+Bid ObliviousGraph::EdgeKey(long long v, long long i) {
+    return Bid((v << 32) | i);
+}
+
+Bid ObliviousGraph::SlotKey(long long v, long long w) {
+    Bid k((v << 32) | w);
+    k.id[8] = 1;
+    return k;
+}
+
+Bid ObliviousGraph::PaddingKey(long long i, bool slot) {
+    Bid k(i);
+    if (slot) {
+        k.id[8] = 2;
+    } else {
+        // past the high half of every vertex id, which is an int
+        k.id[4] = k.id[5] = k.id[6] = k.id[7] = 0xFF;
+    }
+    return k;
+}
+
+string ObliviousGraph::read(Bid k) {
+    IOStats::setOperation(IO_OMAP_READ);
+    return omap->find(k);
+}
+
+void ObliviousGraph::write(Bid k, string value) {
+    IOStats::setOperation(IO_OMAP_WRITE);
+    omap->insert(k, value);
+}
+
+void ObliviousGraph::load(const vector<GraphEntry>& edges) {
+    vector<long long> degree(vertexCount + 1, 0);
+    // a parallel edge writes the slot of the first one again, with the lighter weight
+    map<pair<long long, long long>, pair<long long, long long> > slots;
+    for (const GraphEntry& edge : edges) {
+        pair<long long, long long>& slot = slots[make_pair(edge.source, edge.destination)];
+        if (slot.first == 0) {
+            slot = make_pair(++degree[edge.source], edge.weight);
+        }
+        slot.second = std::min(slot.second, edge.weight);
+        write(EdgeKey(edge.source, slot.first), OMapEntry::Pack(edge.destination, slot.second));
+        write(SlotKey(edge.source, edge.destination), OMapEntry::Pack(slot.first, 0));
+    }
+    edgeCount = (long long) slots.size();
+    for (int v = 1; v <= vertexCount; v++) {
+        write(VertexKey(v), OMapEntry::Pack(INF_DISTANCE, degree[v]));
+    }
+}
+
+void ObliviousGraph::update(long long source, long long destination, long long weight, bool remove) {
+    long long slot, unused, dist, degree, last, lastWeight;
+    OMapEntry::Unpack(read(SlotKey(source, destination)), slot, unused);
+    OMapEntry::Unpack(read(VertexKey(source)), dist, degree);
+    OMapEntry::Unpack(read(EdgeKey(source, degree)), last, lastWeight);
+    bool exists = !Bid::CTeq(slot, 0LL);
+    bool removing = remove && exists;
+    long long target = Bid::conditional_select(slot, degree + 1, exists);
+
+    // an addition writes its edge and slot twice, a removal moves the last edge and clears the slot of the removed one
+    Bid record = VertexKey(source);
+    Bid edgeKey = Bid::conditional_select(EdgeKey(source, target), Bid::conditional_select(EdgeKey(source, slot), record, removing), !remove);
+    long long first = Bid::conditional_select(destination, Bid::conditional_select(last, dist, removing), !remove);
+    long long second = Bid::conditional_select(weight, Bid::conditional_select(lastWeight, degree, removing), !remove);
+    write(edgeKey, OMapEntry::Pack(first, second));
+    Bid movedKey = Bid::conditional_select(SlotKey(source, destination), Bid::conditional_select(SlotKey(source, last), record, removing), !remove);
+    first = Bid::conditional_select(target, Bid::conditional_select(slot, dist, removing), !remove);
+    second = Bid::conditional_select(0LL, degree, !remove || removing);
+    write(movedKey, OMapEntry::Pack(first, second));
+    Bid clearedKey = Bid::conditional_select(SlotKey(source, destination), record, !remove || removing);
+    first = Bid::conditional_select(Bid::conditional_select(target, 0LL, !remove), dist, !remove || removing);
+    second = Bid::conditional_select(0LL, degree, !remove || removing);
+    write(clearedKey, OMapEntry::Pack(first, second));
+
+    long long change = Bid::conditional_select(1LL, 0LL, !remove && !exists) - Bid::conditional_select(1LL, 0LL, removing);
+    write(record, OMapEntry::Pack(dist, degree + change));
+    edgeCount += change;
+}
+
+void ObliviousGraph::addEdge(long long source, long long destination, long long weight) {
+    update(source, destination, weight, false);
+}
+
+void ObliviousGraph::removeEdge(long long source, long long destination) {
+    update(source, destination, 0, true);
+}
+
+void ObliviousGraph::updateEdges(const vector<GraphEntry>& updates) {
+    omap->beginBatch();
+    for (const GraphEntry& entry : updates) {
+        update(entry.source, entry.destination, entry.weight, Bid::CTeq(entry.value, 1LL));
+    }
+    omap->endBatch();
+}
+
+void ObliviousGraph::sssp(int source, double* phaseTimes) {
+    ocall_start_timer(962);
+    DOHEAP* heap = new DOHEAP(vertexCount, key, false, true);
+    ocall_stop_timer(&phaseTimes[0], 962);
+    ocall_start_timer(962);
+    long long dist, degree;
+    OMapEntry::Unpack(read(VertexKey(source)), dist, degree);
+    write(VertexKey(source), OMapEntry::Pack(0, degree));
+    array<byte_t, 16> element;
+    long long u = source;
+    std::memcpy(element.data(), &u, sizeof (u));
+    std::memcpy(element.data() + 8, &degree, sizeof (degree));
+    IOStats::setOperation(IO_HEAP);
+    heap->execute(Bid(0LL), element, 2);
+
+    // u is the vertex whose edges are relaxed, next its next edge, a step with no edge left extracts the next u
+    long long du = 0, next = 1;
+    degree = 0;
+    Bid noEdge = EdgeKey(0, 1);
+    // the steps past the real edges extract from the empty heap, so their number does not show
+    for (long long step = 0; step < vertexCount + edgeCapacity; step++) {
+        bool relax = !Bid::CTeq(Bid::CTcmp(next, degree), 1);
+        long long w, weight;
+        OMapEntry::Unpack(read(Bid::conditional_select(EdgeKey(u, next), noEdge, relax)), w, weight);
+        // an extraction reads and writes back the record of the last u, so both kinds of step look alike
+        long long target = Bid::conditional_select(w, u, relax);
+        long long dw, targetDegree;
+        OMapEntry::Unpack(read(VertexKey(target)), dw, targetDegree);
+
+        long long candidate = du + weight;
+        bool improve = relax && Bid::CTeq(Bid::CTcmp(candidate, dw), -1);
+        bool unseen = Bid::CTeq(dw, INF_DISTANCE);
+        int op = Bid::conditional_select(Bid::conditional_select(2, 4, unseen), 3, improve);
+        op = Bid::conditional_select(op, 1, relax);
+        std::memcpy(element.data(), &target, sizeof (target));
+        std::memcpy(element.data() + 8, &targetDegree, sizeof (targetDegree));
+        IOStats::setOperation(IO_HEAP);
+        pair<Bid, array<byte_t, 16> > res = heap->execute(Bid(candidate), element, op);
+        write(VertexKey(target), OMapEntry::Pack(Bid::conditional_select(candidate, dw, improve), targetDegree));
+
+        // an extraction from an empty heap leaves u as it is with no edges, so the next step extracts again
+        long long minDist, minVertex, minDegree;
+        std::memcpy(&minDist, res.first.id.data(), sizeof (minDist));
+        std::memcpy(&minVertex, res.second.data(), sizeof (minVertex));
+        std::memcpy(&minDegree, res.second.data() + 8, sizeof (minDegree));
+        bool found = !relax && Bid::CTeq(Bid::CTcmp(res.first, Bid(INF_DISTANCE)), -1);
+        u = Bid::conditional_select(minVertex, u, found);
+        du = Bid::conditional_select(minDist, du, found);
+        degree = Bid::conditional_select(degree, Bid::conditional_select(minDegree, 0LL, found), relax);
+        next = Bid::conditional_select(next + 1, 1LL, relax);
+    }
+    IOStats::setOperation(IO_OTHER);
+    ocall_stop_timer(&phaseTimes[1], 962);
+    delete heap;
+}
+
+void ObliviousGraph::mst(long long& totalWeight, vector<GraphEntry>& forest, double* phaseTimes) {
+    ocall_start_timer(962);
+    DOHEAP* heap = new DOHEAP(vertexCount + edgeCapacity, key, false);
+    ObliviousArray* inForest = new ObliviousArray(vertexCount + 1, key);
+    // a heap element is the vertex, the vertex it is reached from (0 for a root) and its degree
+    array<byte_t, 16> element;
+    for (int v = 1; v <= vertexCount; v++) {
+        long long dist, degree;
+        OMapEntry::Unpack(read(VertexKey(v)), dist, degree);
+        int parent = 0;
+        std::memcpy(element.data(), &v, sizeof (v));
+        std::memcpy(element.data() + 4, &parent, sizeof (parent));
+        std::memcpy(element.data() + 8, &degree, sizeof (degree));
+        IOStats::setOperation(IO_HEAP);
+        heap->execute(Bid(ROOT_WEIGHT), element, 2);
+    }
+    ocall_stop_timer(&phaseTimes[0], 962);
+    ocall_start_timer(962);
+
+    // V + E entries are inserted and each extraction removes one, next to E relaxations,
+    // with E padded to the capacity by extractions from the empty heap
+    long long steps = vertexCount + 2 * edgeCapacity;
+    forest.resize(steps);
+    totalWeight = 0;
+    array<byte_t, 16> flag, mask;
+    std::fill(flag.begin(), flag.end(), 0);
+    flag[0] = 1;
+    long long u = 1, next = 1, degree = 0;
+    Bid noEdge = EdgeKey(0, 1);
+    for (long long step = 0; step < steps; step++) {
+        bool relax = !Bid::CTeq(Bid::CTcmp(next, degree), 1);
+        long long w, weight;
+        OMapEntry::Unpack(read(Bid::conditional_select(EdgeKey(u, next), noEdge, relax)), w, weight);
+        // an extraction reads the record of u, so both kinds of step look alike
+        long long target = Bid::conditional_select(w, u, relax);
+        long long dw, targetDegree;
+        OMapEntry::Unpack(read(VertexKey(target)), dw, targetDegree);
+        int from = (int) target, parent = (int) u;
+        std::memcpy(element.data(), &from, sizeof (from));
+        std::memcpy(element.data() + 4, &parent, sizeof (parent));
+        std::memcpy(element.data() + 8, &targetDegree, sizeof (targetDegree));
+        IOStats::setOperation(IO_HEAP);
+        pair<Bid, array<byte_t, 16> > res = heap->execute(Bid(weight), element, Bid::conditional_select(2, 1, relax));
+
+        long long minWeight, minDegree;
+        int minVertex;
+        std::memcpy(&minWeight, res.first.id.data(), sizeof (minWeight));
+        std::memcpy(&minVertex, res.second.data(), sizeof (minVertex));
+        std::memcpy(&parent, res.second.data() + 4, sizeof (parent));
+        std::memcpy(&minDegree, res.second.data() + 8, sizeof (minDegree));
+        bool found = !relax && Bid::CTeq(Bid::CTcmp(res.first, Bid(INF_DISTANCE)), -1);
+        long long v = Bid::conditional_select((long long) minVertex, u, found);
+
+        // a relaxation reads the flag of its target, an extraction sets the flag of the vertex it took
+        for (int b = 0; b < 16; b++) {
+            mask[b] = Bid::conditional_select((byte_t) 0xFF, (byte_t) 0, found);
+        }
+        IOStats::setOperation(IO_ARRAY);
+        array<byte_t, 16> old = inForest->access(Bid::conditional_select(target, v, relax), flag, mask);
+        bool joined = found && Bid::CTeq((long long) old[0], 0LL);
+        bool treeEdge = joined && !Bid::CTeq((long long) parent, 0LL);
+        GraphEntry edge = {Bid::conditional_select(0ULL, 1ULL, treeEdge), parent, minVertex, minWeight, 0, 0};
+        forest[step] = edge;
+        totalWeight += Bid::conditional_select(minWeight, 0LL, treeEdge);
+
+        // a stale or empty extraction leaves u with no edges, so the next step extracts again
+        u = Bid::conditional_select(v, u, joined);
+        degree = Bid::conditional_select(degree, Bid::conditional_select(minDegree, 0LL, joined), relax);
+        next = Bid::conditional_select(next + 1, 1LL, relax);
+    }
+    IOStats::setOperation(IO_OTHER);
+
+    // the tree edges are moved to the front, their number is V minus the number of trees
+    long long count = 0;
+    for (const GraphEntry& edge : forest) {
+        count += Bid::conditional_select(1LL, 0LL, Bid::CTeq((long long) edge.sortKey, 0LL));
+    }
+    ObliviousOperations::bitonicSort(&forest);
+    forest.resize(count);
+    ocall_stop_timer(&phaseTimes[1], 962);
+    delete inForest;
+    delete heap;
+}
+
+int ObliviousGraph::vertices() {
+    return vertexCount;
+}
+
+long long ObliviousGraph::edges() {
+    return edgeCount;
+}
+
+long long ObliviousGraph::distance(int v) {
+    long long dist, degree;
+    OMapEntry::Unpack(read(VertexKey(v)), dist, degree);
+    return dist;
+}
@@ -0,0 +1,111 @@
+#ifndef OBLIVIOUSGRAPH_H
+#define OBLIVIOUSGRAPH_H
+
+#include "OMAP.h"
+#include "DOHEAP.hpp"
+#include "GraphEntry.h"
+#include <vector>
+#include <string>
+
+/**
+ * A weighted directed graph kept in one OMAP. Vertex v (1 <= v <= vertexCount)
+ * has a record under key v << 32 holding its distance and degree, and its
+ * i-th out-edge (1 <= i <= degree) is stored under (v << 32) | i holding the
+ * destination and the weight. The slot i of the edge from v to w is indexed
+ * under (v << 32) | w with the tag byte set, 0 once the edge is removed.
+ * Every value is two 8 byte words.
+ */
+class ObliviousGraph {
+private:
+    OMAP* omap;
+    int vertexCount;
+    long long edgeCount;
+    // edges the OMAP is sized for, the public bound of every run while edgeCount stays secret
+    long long edgeCapacity;
+    bytes<Key> key;
+
+    static Bid VertexKey(long long v);
+    static Bid EdgeKey(long long v, long long i);
+    static Bid SlotKey(long long v, long long w);
+    /**
+     * Key of the i-th padding pair of a bulk build, above every edge key for
+     * the edge half and above every slot key for the slot half
+     */
+    static Bid PaddingKey(long long i, bool slot);
+    string read(Bid k);
+    void write(Bid k, string value);
+    /**
+     * Adds, reweights or removes the edge from source to destination with
+     * three OMAP reads and four OMAP writes either way. A removal moves the
+     * last edge of source into the freed slot, a removal of a missing edge
+     * writes the vertex record back unchanged.
+     */
+    void update(long long source, long long destination, long long weight, bool remove);
+
+public:
+    static const long long INF_DISTANCE;
+
+    /**
+     * @param edgeCount number of directed edges the OMAP is sized for
+     * @param spareEdges edges that can be added on top of them later
+     */
+    ObliviousGraph(int vertexCount, long long edgeCount, bytes<Key> key, long long spareEdges = 0);
+    /**
+     * Builds the OMAP in one pass: the edges and a record per vertex are
+     * sorted obliviously by (source, destination), parallel edges are
+     * collapsed into the lightest one, a scan numbers the edges of every
+     * vertex and counts its degree, and the sorted pairs go to the bulk
+     * constructor of the OMAP. The edges are consumed.
+     */
+    ObliviousGraph(int vertexCount, vector<GraphEntry>* edges, bytes<Key> key, long long spareEdges = 0);
+    virtual ~ObliviousGraph();
+
+    /**
+     * Inserts every vertex record and edge into an empty graph, one OMAP
+     * insert each. Parallel edges keep the lightest weight, as in the bulk
+     * build.
+     */
+    void load(const vector<GraphEntry>& edges);
+    /**
+     * Adds the edge, or sets its weight if it exists
+     */
+    void addEdge(long long source, long long destination, long long weight);
+    void removeEdge(long long source, long long destination);
+    /**
+     * Applies the updates in order with the buckets of the OMAP written back
+     * once for the whole batch instead of once per access
+     * @param updates (source, destination, weight), value 1 removes the edge
+     */
+    void updateEdges(const vector<GraphEntry>& updates);
+    /**
+     * Dijkstra from source over DOHEAP. The run is vertexCount + edgeCapacity
+     * steps, and every step does the same OMAP reads, OMAP write and heap
+     * operation whether it extracts a vertex, relaxes an edge or is padding.
+     * The distances are left in the vertex records.
+     * @param phaseTimes heap setup and search times
+     */
+    void sssp(int source, double* phaseTimes);
+    /**
+     * Prim over DOHEAP without decrease: every relaxed edge is inserted and
+     * extractions of vertices already in the forest are dropped, against an
+     * ObliviousArray of in-forest flags. Every vertex also starts as a root
+     * candidate heavier than any edge, so the result is a spanning forest.
+     * The run is vertexCount + 2 * edgeCapacity steps of two OMAP reads, one
+     * heap operation and one array access each, and the vertex records are
+     * not changed.
+     * @param forest the edges of the forest as (source, destination, weight)
+     * @param phaseTimes setup and search times
+     */
+    void mst(long long& totalWeight, vector<GraphEntry>& forest, double* phaseTimes);
+    /**
+     * @return the distance of v after sssp, INF_DISTANCE if v is unreachable
+     */
+    long long distance(int v);
+    int vertices();
+    /**
+     * @return the directed edges held now, which no access depends on
+     */
+    long long edges();
+};
+
+#endif /* OBLIVIOUSGRAPH_H */
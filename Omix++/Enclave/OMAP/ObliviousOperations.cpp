@@ -87,3 +87,45 @@ void ObliviousOperations::compare_and_swap(Node* item_i, Node* item_j, int dir)
     int cmp = Node::CTeq(res, 1);
     Node::conditional_swap(item_i, item_j, Node::CTeq(cmp, dir));
 }
+
+void ObliviousOperations::bitonicSort(vector<GraphEntry>* entries) {
+    bitonic_sort(entries, 0, (long long) entries->size(), 1);
+}
+
+void ObliviousOperations::bitonic_sort(vector<GraphEntry>* entries, long long low, long long n, int dir) {
+    if (n > 1) {
+        long long middle = n / 2;
+        bitonic_sort(entries, low, middle, !dir);
+        bitonic_sort(entries, low + middle, n - middle, dir);
+        bitonic_merge(entries, low, n, dir);
+    }
+}
+
+void ObliviousOperations::bitonic_merge(vector<GraphEntry>* entries, long long low, long long n, int dir) {
+    if (n > 1) {
+        long long m = 1;
+        while (m > 0 && m < n) {
+            m = m << 1;
+        }
+        m = m >> 1;
+
+        for (long long i = low; i < (low + n - m); i++) {
+            compare_and_swap((*entries)[i], (*entries)[i + m], dir);
+        }
+
+        bitonic_merge(entries, low, m, dir);
+        bitonic_merge(entries, low + m, n - m, dir);
+    }
+}
+
+void ObliviousOperations::compare_and_swap(GraphEntry& item_i, GraphEntry& item_j, int dir) {
+    int cmp = Bid::CTeq(Bid::CTcmpWide(item_i.sortKey, item_j.sortKey), 1);
+    unsigned long long mask = ~((unsigned long long) Bid::CTeq(cmp, dir) - 1);
+    unsigned long long* a = reinterpret_cast<unsigned long long*> (&item_i);
+    unsigned long long* b = reinterpret_cast<unsigned long long*> (&item_j);
+    for (size_t k = 0; k < sizeof (GraphEntry) / sizeof (unsigned long long); k++) {
+        unsigned long long t = (a[k] ^ b[k]) & mask;
+        a[k] ^= t;
+        b[k] ^= t;
+    }
+}
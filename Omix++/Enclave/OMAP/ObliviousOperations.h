@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <array>
 #include "ORAM.hpp"
+#include "GraphEntry.h"
 
 using namespace std;
 
@@ -15,6 +16,8 @@ private:
     static void bitonic_merge(vector<Node*>* nodes, int low, int n, int dir);
     static void compare_and_swap(Node* item_i, Node* item_j, int dir);
     static int greatest_power_of_two_less_than(int n);
+    static void bitonic_sort(vector<GraphEntry>* entries, long long low, long long n, int dir);
+    static void bitonic_merge(vector<GraphEntry>* entries, long long low, long long n, int dir);
 
 public:
     static long long INF;
@@ -22,6 +25,14 @@ public:
     virtual ~ObliviousOperations();
     static void oblixmergesort(std::vector<Node*> *data);
     static void bitonicSort(vector<Node*>* nodes);
+    /**
+     * Sorts the entries on sortKey, for any number of entries
+     */
+    static void bitonicSort(vector<GraphEntry>* entries);
+    /**
+     * Orders the two entries on sortKey, ascending if dir is 1
+     */
+    static void compare_and_swap(GraphEntry& item_i, GraphEntry& item_j, int dir);
 
 };
 
@@ -0,0 +1,206 @@
+#include "PageRankGraph.hpp"
+#include "ObliviousOperations.h"
+#include "Enclave_t.h"
+#include "IOStats.hpp"
+#include "StoreHandle.h"
+#include <cstring>
+
+static long long toBits(double value) {
+    long long bits;
+    std::memcpy(&bits, &value, sizeof (bits));
+    return bits;
+}
+
+static double toDouble(long long bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof (value));
+    return value;
+}
+
+PageRankGraph::PageRankGraph(int vertexCount, const vector<GraphEntry>& edges, bytes<Key> key)
+: key(key), vertexCount(vertexCount), damping(0.85), resetRanks(false) {
+    AES::Setup();
+    long long count = (long long) edges.size() + vertexCount;
+    entryCount = ENTRIES_PER_BLOCK;
+    while (entryCount < count) {
+        entryCount <<= 1;
+    }
+    blockCount = entryCount / ENTRIES_PER_BLOCK;
+    plaintext_size = ENTRIES_PER_BLOCK * sizeof (GraphEntry);
+    clen_size = AES::GetCiphertextLength((int) plaintext_size);
+    storeBlockSize = IV + clen_size;
+    ocall_setup_ramStore(&store, blockCount, (int) storeBlockSize);
+    CheckStore(store);
+
+    // padding has source 0 and goes last in every order
+    vector<GraphEntry> block(ENTRIES_PER_BLOCK);
+    for (long long b = 0; b < blockCount; b++) {
+        for (int t = 0; t < ENTRIES_PER_BLOCK; t++) {
+            long long i = b * ENTRIES_PER_BLOCK + t;
+            GraphEntry entry = {~0ULL, 0, -1, 0, 0, 0};
+            if (i < (long long) edges.size()) {
+                entry = edges[i];
+                entry.sortKey = (unsigned long long) entry.source << 1;
+            } else if (i < count) {
+                long long v = i - (long long) edges.size() + 1;
+                GraphEntry record = {((unsigned long long) v << 1) | 1, v, 0, 0, 0, 0};
+                entry = record;
+            }
+            block[t] = entry;
+        }
+        writeBlocks(vector<long long>(1, b), block);
+    }
+    sort();
+    scan(DEGREE, SOURCE);
+}
+
+PageRankGraph::~PageRankGraph() {
+    ocall_release_store(store);
+}
+
+void PageRankGraph::readBlocks(const vector<long long>& indexes, vector<GraphEntry>& entries) {
+    size_t readSize;
+    char* tmp = new char[indexes.size() * storeBlockSize];
+    ocall_nread_ramStore(&readSize, store, indexes.size(), (long long*) indexes.data(), tmp, indexes.size() * storeBlockSize);
+    IOStats::ocall(indexes.size() * sizeof (long long), indexes.size() * storeBlockSize);
+    IOStats::bucketsRead(indexes.size());
+    entries.resize(indexes.size() * ENTRIES_PER_BLOCK);
+    for (unsigned int i = 0; i < indexes.size(); i++) {
+        block ciphertext(tmp + i * readSize, tmp + (i + 1) * readSize);
+        block buffer = AES::Decrypt(key, ciphertext, clen_size);
+        std::memcpy(&entries[i * ENTRIES_PER_BLOCK], buffer.data(), plaintext_size);
+    }
+    delete[] tmp;
+}
+
+void PageRankGraph::writeBlocks(const vector<long long>& indexes, const vector<GraphEntry>& entries) {
+    char* tmp = new char[indexes.size() * storeBlockSize];
+    size_t cipherSize = 0;
+    for (unsigned int i = 0; i < indexes.size(); i++) {
+        const byte_t* data = reinterpret_cast<const byte_t*> (&entries[i * ENTRIES_PER_BLOCK]);
+        block buffer(data, data + plaintext_size);
+        block ciphertext = AES::Encrypt(key, buffer, clen_size, plaintext_size);
+        std::memcpy(tmp + i * ciphertext.size(), ciphertext.data(), ciphertext.size());
+        cipherSize = ciphertext.size();
+    }
+    ocall_nwrite_ramStore(store, indexes.size(), (long long*) indexes.data(), tmp, cipherSize * indexes.size());
+    IOStats::ocall(indexes.size() * sizeof (long long) + cipherSize * indexes.size(), 0);
+    IOStats::bucketsWritten(indexes.size());
+    delete[] tmp;
+}
+
+void PageRankGraph::sort() {
+    vector<GraphEntry> entries;
+    for (long long k = 2; k <= entryCount; k <<= 1) {
+        long long j = k >> 1;
+        for (; j >= ENTRIES_PER_BLOCK; j >>= 1) {
+            long long stride = j / ENTRIES_PER_BLOCK;
+            for (long long b = 0; b < blockCount; b++) {
+                if ((b & stride) != 0) {
+                    continue;
+                }
+                vector<long long> indexes = {b, b + stride};
+                readBlocks(indexes, entries);
+                for (int t = 0; t < ENTRIES_PER_BLOCK; t++) {
+                    long long i = b * ENTRIES_PER_BLOCK + t;
+                    ObliviousOperations::compare_and_swap(entries[t], entries[ENTRIES_PER_BLOCK + t], (i & k) == 0);
+                }
+                writeBlocks(indexes, entries);
+            }
+        }
+        for (long long b = 0; b < blockCount; b++) {
+            vector<long long> indexes(1, b);
+            readBlocks(indexes, entries);
+            for (long long d = j; d > 0; d >>= 1) {
+                for (int t = 0; t < ENTRIES_PER_BLOCK; t++) {
+                    if ((t & d) == 0) {
+                        long long i = b * ENTRIES_PER_BLOCK + t;
+                        ObliviousOperations::compare_and_swap(entries[t], entries[t + d], (i & k) == 0);
+                    }
+                }
+            }
+            writeBlocks(indexes, entries);
+        }
+    }
+}
+
+void PageRankGraph::scan(Pass pass, Order next) {
+    vector<GraphEntry> entries;
+    unsigned long long previous = ~0ULL;
+    long long count = 0;
+    long long carried = 0;
+    double sum = 0;
+    double initial = 1.0 / vertexCount;
+    for (long long b = 0; b < blockCount; b++) {
+        vector<long long> indexes(1, b);
+        readBlocks(indexes, entries);
+        for (GraphEntry& entry : entries) {
+            bool isPadding = Bid::CTeq(entry.source, 0LL);
+            bool isRecord = Bid::CTeq(entry.destination, 0LL);
+            unsigned long long group = entry.sortKey >> 1;
+            bool isNew = !Bid::CTeq(group, previous);
+            previous = group;
+            if (pass == DEGREE) {
+                count = Bid::conditional_select(0LL, count, isNew) + !isRecord;
+                entry.weight = Bid::conditional_select(count, entry.weight, isRecord);
+            } else if (pass == SCATTER) {
+                if (resetRanks) {
+                    entry.value = Bid::conditional_select(toBits(initial), entry.value, isRecord);
+                }
+                long long degree = Bid::conditional_select(entry.weight, 1LL, Bid::CTeq(Bid::CTcmp(entry.weight, 0LL), 1));
+                carried = Bid::conditional_select(toBits(toDouble(entry.value) / degree), carried, isRecord);
+                entry.value = Bid::conditional_select(entry.value, carried, isRecord);
+            } else if (pass == GATHER) {
+                sum = toDouble(Bid::conditional_select(0LL, toBits(sum), isNew));
+                sum += toDouble(Bid::conditional_select(0LL, entry.value, isRecord));
+                double rank = (1 - damping) / vertexCount + damping * sum;
+                entry.value = Bid::conditional_select(toBits(rank), entry.value, isRecord);
+            }
+
+            long long target = Bid::conditional_select(entry.source, entry.destination, isRecord);
+            unsigned long long sortKey;
+            if (next == SOURCE_RECORD_LAST) {
+                sortKey = ((unsigned long long) entry.source << 1) | (unsigned long long) isRecord;
+            } else if (next == SOURCE) {
+                sortKey = ((unsigned long long) entry.source << 32) | (unsigned long long) entry.destination;
+            } else if (next == TARGET) {
+                sortKey = ((unsigned long long) target << 1) | (unsigned long long) isRecord;
+            } else {
+                sortKey = Bid::conditional_select((unsigned long long) entry.source, 1ULL << 62, isRecord);
+            }
+            entry.sortKey = Bid::conditional_select(~0ULL, sortKey, isPadding);
+        }
+        writeBlocks(indexes, entries);
+    }
+}
+
+void PageRankGraph::run(int iterations, double damping, double* ranks, size_t len, double* iterationTime) {
+    this->damping = damping;
+    iterations = iterations < 1 ? 1 : iterations;
+    sort();
+    ocall_start_timer(963);
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        resetRanks = iteration == 0;
+        scan(SCATTER, TARGET);
+        sort();
+        scan(GATHER, iteration == iterations - 1 ? RECORDS : SOURCE);
+        sort();
+    }
+    ocall_stop_timer(iterationTime, 963);
+    *iterationTime /= iterations;
+
+    vector<GraphEntry> entries;
+    for (size_t v = 0; v < len; v++) {
+        ranks[v] = 0;
+    }
+    for (long long b = 0; b * ENTRIES_PER_BLOCK < vertexCount; b++) {
+        readBlocks(vector<long long>(1, b), entries);
+        for (int t = 0; t < ENTRIES_PER_BLOCK; t++) {
+            long long v = b * ENTRIES_PER_BLOCK + t + 1;
+            if (v <= vertexCount && (size_t) v < len) {
+                ranks[v] = toDouble(entries[t].value);
+            }
+        }
+    }
+    scan(KEYS, SOURCE);
+}
@@ -0,0 +1,74 @@
+#ifndef PAGERANKGRAPH_H
+#define PAGERANKGRAPH_H
+
+#include "AES.hpp"
+#include "GraphEntry.h"
+#include <vector>
+
+using namespace std;
+
+/**
+ * A graph kept outside the enclave for PageRank. The edges, a record per
+ * vertex and padding up to a power of two are GraphEntry blocks of
+ * ENTRIES_PER_BLOCK entries, encrypted in an untrusted store. The blocks are
+ * only touched by full scans and by a bitonic sort whose block pairs depend
+ * only on the number of entries, so the accesses depend only on V and E.
+ */
+class PageRankGraph {
+private:
+    static const int ENTRIES_PER_BLOCK = 128;
+
+    enum Pass {
+        DEGREE, // the record of every vertex counts its out-edges
+        SCATTER, // every out-edge takes the rank of its source over the degree
+        GATHER, // every record sums what its in-edges carry into its rank
+        KEYS // only sets the keys
+    };
+
+    enum Order {
+        SOURCE_RECORD_LAST, // out-edges of a vertex before its record
+        SOURCE, // record of a vertex before its out-edges
+        TARGET, // in-edges of a vertex before its record
+        RECORDS // records first in vertex order
+    };
+
+    bytes<Key> key;
+    int store;
+    int vertexCount;
+    long long entryCount;
+    long long blockCount;
+    size_t storeBlockSize, clen_size, plaintext_size;
+    double damping;
+    bool resetRanks;
+
+    void readBlocks(const vector<long long>& indexes, vector<GraphEntry>& entries);
+    void writeBlocks(const vector<long long>& indexes, const vector<GraphEntry>& entries);
+    /**
+     * Bitonic sort of the store on sortKey. Merges with a distance of a block
+     * or more compare two whole blocks, and the shorter ones of a stage run
+     * inside every block.
+     */
+    void sort();
+    /**
+     * Runs the pass over the blocks in order and keys every entry for the
+     * order the next pass needs
+     */
+    void scan(Pass pass, Order next);
+
+public:
+    /**
+     * @param edges directed edges, an undirected graph holds both directions
+     */
+    PageRankGraph(int vertexCount, const vector<GraphEntry>& edges, bytes<Key> key);
+    ~PageRankGraph();
+
+    /**
+     * Every iteration is a sort and a scan to pass the ranks along the
+     * edges, and a sort and a scan to add them up at the targets
+     * @param ranks rank of every vertex id 0..vertexCount
+     * @param iterationTime average time of an iteration
+     */
+    void run(int iterations, double damping, double* ranks, size_t len, double* iterationTime);
+};
+
+#endif /* PAGERANKGRAPH_H */
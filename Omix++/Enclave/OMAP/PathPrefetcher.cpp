@@ -0,0 +1,99 @@
+#include "PathPrefetcher.hpp"
+#include "Enclave_t.h"
+#include "IOStats.hpp"
+
+PathPrefetcher::PathPrefetcher(int storeHandle, bytes<Key> key, int storeBlockSize, size_t clen_size)
+: storeHandle(storeHandle), key(key), storeBlockSize(storeBlockSize), clen_size(clen_size) {
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&changed, NULL);
+    pthread_create(&thread, NULL, run, this);
+}
+
+PathPrefetcher::~PathPrefetcher() {
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+    pthread_join(thread, NULL);
+    pthread_cond_destroy(&changed);
+    pthread_mutex_destroy(&lock);
+}
+
+void* PathPrefetcher::run(void* arg) {
+    PathPrefetcher* prefetcher = (PathPrefetcher*) arg;
+    pthread_mutex_lock(&prefetcher->lock);
+    while (true) {
+        while (!prefetcher->stopping && (!prefetcher->requested || prefetcher->done)) {
+            pthread_cond_wait(&prefetcher->changed, &prefetcher->lock);
+        }
+        if (prefetcher->stopping) {
+            break;
+        }
+        pthread_mutex_unlock(&prefetcher->lock);
+        prefetcher->read();
+        pthread_mutex_lock(&prefetcher->lock);
+        prefetcher->done = true;
+        pthread_cond_broadcast(&prefetcher->changed);
+    }
+    pthread_mutex_unlock(&prefetcher->lock);
+    return NULL;
+}
+
+void PathPrefetcher::read() {
+    buckets.clear();
+    if (indexes.size() == 0) {
+        return;
+    }
+    // charged to the operation of the thread that asked for the path
+    IOStats::setOperation(operation);
+    size_t readSize;
+    char* tmp = new char[indexes.size() * storeBlockSize];
+    ocall_nread_ramStore(&readSize, storeHandle, indexes.size(), indexes.data(), tmp, indexes.size() * storeBlockSize);
+    IOStats::ocall(indexes.size() * sizeof (long long), indexes.size() * storeBlockSize);
+    IOStats::bucketsRead(indexes.size());
+    for (unsigned int i = 0; i < indexes.size(); i++) {
+        block ciphertext(tmp + i*readSize, tmp + (i + 1) * readSize);
+        buckets.push_back(AES::Decrypt(key, ciphertext, clen_size));
+    }
+    delete[] tmp;
+}
+
+void PathPrefetcher::start(unsigned long long leaf, const std::vector<long long>& indexes) {
+    cancel();
+    pthread_mutex_lock(&lock);
+    this->leaf = leaf;
+    this->indexes = indexes;
+    operation = IOStats::operation();
+    requested = true;
+    done = false;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+}
+
+bool PathPrefetcher::pending() {
+    return requested;
+}
+
+bool PathPrefetcher::wait(unsigned long long leaf, std::vector<long long>& indexes, std::vector<block>& buckets) {
+    if (!requested) {
+        return false;
+    }
+    pthread_mutex_lock(&lock);
+    while (!done) {
+        pthread_cond_wait(&changed, &lock);
+    }
+    requested = false;
+    pthread_mutex_unlock(&lock);
+    if (leaf != this->leaf) {
+        return false;
+    }
+    indexes.swap(this->indexes);
+    buckets.swap(this->buckets);
+    return true;
+}
+
+void PathPrefetcher::cancel() {
+    std::vector<long long> indexes;
+    std::vector<block> buckets;
+    wait(leaf, indexes, buckets);
+}
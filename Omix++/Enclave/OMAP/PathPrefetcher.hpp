@@ -0,0 +1,59 @@
+#ifndef PATHPREFETCHER_H
+#define PATHPREFETCHER_H
+
+#include "AES.hpp"
+#include <pthread.h>
+#include <vector>
+
+/**
+ * Helper enclave thread that reads and decrypts the buckets of the next path
+ * of an ORAM while the calling thread evicts the current one. At most one
+ * read is in flight. The thread only fills its own buffers, the buckets are
+ * added to the stash by the ORAM once it waits for them.
+ */
+class PathPrefetcher {
+private:
+    int storeHandle;
+    bytes<Key> key;
+    int storeBlockSize;
+    size_t clen_size;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    bool requested = false;
+    bool done = false;
+    bool stopping = false;
+
+    // the read in flight, owned by the helper thread until done is set
+    unsigned long long leaf;
+    int operation;
+    std::vector<long long> indexes;
+    std::vector<block> buckets;
+
+    static void* run(void* arg);
+    void read();
+
+public:
+    PathPrefetcher(int storeHandle, bytes<Key> key, int storeBlockSize, size_t clen_size);
+    ~PathPrefetcher();
+
+    /**
+     * Starts reading the given buckets of the path to leaf, a read that was
+     * never waited for is dropped first
+     */
+    void start(unsigned long long leaf, const std::vector<long long>& indexes);
+    bool pending();
+    /**
+     * Waits for the read in flight
+     * @return false if it was for another leaf, the buckets are then dropped
+     */
+    bool wait(unsigned long long leaf, std::vector<long long>& indexes, std::vector<block>& buckets);
+    /**
+     * Waits for the read in flight and drops it, so that the store is not
+     * read while buckets are written back
+     */
+    void cancel();
+};
+
+#endif /* PATHPREFETCHER_H */
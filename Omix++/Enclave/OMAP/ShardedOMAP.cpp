@@ -0,0 +1,233 @@
+#include "ShardedOMAP.hpp"
+#include "../Enclave.h"
+#include "Enclave_t.h"
+#include "sgx_trts.h"
+#include "Trace.hpp"
+#include "IOStats.hpp"
+#include <pthread.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static_assert(sizeof (ShardRequest) % sizeof (unsigned long long) == 0, "ShardRequest is swapped word-wise");
+
+int ShardedOMAP::securityParameter = 40;
+
+struct ShardTask {
+    OMAP* omap;
+    ShardRequest* requests;
+    int count;
+};
+
+ShardedOMAP::ShardedOMAP(int shardCount, int maxSize, bytes<Key> key) : maxSize(maxSize) {
+    sgx_read_rand((unsigned char*) hashKey, sizeof (hashKey));
+    int capacity = SubBatchSize(maxSize, shardCount);
+    for (int s = 0; s < shardCount; s++) {
+        shards.push_back(new OMAP(capacity, key));
+    }
+}
+
+ShardedOMAP::~ShardedOMAP() {
+    for (OMAP* shard : shards) {
+        delete shard;
+    }
+}
+
+int ShardedOMAP::shardCount() {
+    return (int) shards.size();
+}
+
+int ShardedOMAP::SubBatchSize(long long count, int shardCount) {
+    if (shardCount <= 1 || count <= 1) {
+        return (int) count;
+    }
+    // P[X >= (1 + e) mu] <= exp(-e^2 mu / (2 + e)), solved for e at 2^-securityParameter / shardCount
+    double mu = (double) count / shardCount;
+    double l = log((double) shardCount) + securityParameter * log(2.0);
+    double e = (l + sqrt(l * l + 8 * l * mu)) / (2 * mu);
+    long long bound = (long long) ceil((1 + e) * mu);
+    return (int) (bound < count ? bound : count);
+}
+
+#define ROTL(x, b) (unsigned long long) (((x) << (b)) | ((x) >> (64 - (b))))
+#define SIPROUND \
+    v0 += v1; v1 = ROTL(v1, 13); v1 ^= v0; v0 = ROTL(v0, 32); \
+    v2 += v3; v3 = ROTL(v3, 16); v3 ^= v2; \
+    v0 += v3; v3 = ROTL(v3, 21); v3 ^= v0; \
+    v2 += v1; v1 = ROTL(v1, 17); v1 ^= v2; v2 = ROTL(v2, 32)
+
+/**
+ * SipHash-2-4 of the ID_SIZE key bytes, the shard is the hash modulo the
+ * number of shards
+ */
+unsigned long long ShardedOMAP::shardOf(Bid key) {
+    unsigned long long v0 = 0x736f6d6570736575ULL ^ hashKey[0];
+    unsigned long long v1 = 0x646f72616e646f6dULL ^ hashKey[1];
+    unsigned long long v2 = 0x6c7967656e657261ULL ^ hashKey[0];
+    unsigned long long v3 = 0x7465646279746573ULL ^ hashKey[1];
+    unsigned char message[16] = {0};
+    std::memcpy(message, key.id.data(), ID_SIZE);
+    message[15] = ID_SIZE;
+    for (int i = 0; i < 16; i += 8) {
+        unsigned long long m;
+        std::memcpy(&m, message + i, sizeof (m));
+        v3 ^= m;
+        SIPROUND;
+        SIPROUND;
+        v0 ^= m;
+    }
+    v2 ^= 0xff;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    return (v0 ^ v1 ^ v2 ^ v3) % shards.size();
+}
+
+void ShardedOMAP::conditionalSwap(ShardRequest& a, ShardRequest& b, int choice) {
+    unsigned long long mask = ~((unsigned long long) choice - 1);
+    char* pa = (char*) &a;
+    char* pb = (char*) &b;
+    for (size_t i = 0; i < sizeof (ShardRequest); i += sizeof (unsigned long long)) {
+        unsigned long long wa, wb;
+        std::memcpy(&wa, pa + i, sizeof (wa));
+        std::memcpy(&wb, pb + i, sizeof (wb));
+        unsigned long long t = (wa ^ wb) & mask;
+        wa ^= t;
+        wb ^= t;
+        std::memcpy(pa + i, &wa, sizeof (wa));
+        std::memcpy(pb + i, &wb, sizeof (wb));
+    }
+}
+
+/**
+ * Bitonic sort on sortKey for any n, as in ObliviousOperations::bitonic_sort
+ */
+void ShardedOMAP::sort(std::vector<ShardRequest>& requests, int low, int n, int dir) {
+    if (n > 1) {
+        int middle = n / 2;
+        sort(requests, low, middle, !dir);
+        sort(requests, low + middle, n - middle, dir);
+        merge(requests, low, n, dir);
+    }
+}
+
+void ShardedOMAP::merge(std::vector<ShardRequest>& requests, int low, int n, int dir) {
+    if (n > 1) {
+        int m = 1;
+        while (m > 0 && m < n) {
+            m = m << 1;
+        }
+        m = m >> 1;
+        for (int i = low; i < (low + n - m); i++) {
+            int cmp = Bid::CTeq(Bid::CTcmp((long long) requests[i].sortKey, (long long) requests[i + m].sortKey), 1);
+            conditionalSwap(requests[i], requests[i + m], Bid::CTeq(cmp, dir));
+        }
+        merge(requests, low, m, dir);
+        merge(requests, low + m, n - m, dir);
+    }
+}
+
+void* ShardedOMAP::runShard(void* arg) {
+    ShardTask* task = (ShardTask*) arg;
+    for (int i = 0; i < task->count; i++) {
+        ShardRequest& request = task->requests[i];
+        std::memset(request.result, 0, 16);
+        // dummies are reads of a random key, so they cannot be told apart from real reads
+        if (request.op == OMAP_OP_WRITE) {
+            IOStats::setOperation(IO_OMAP_WRITE);
+            task->omap->insert(request.key, string(request.value, strnlen(request.value, 16)));
+        } else if (request.op == OMAP_OP_DELETE) {
+            IOStats::setOperation(IO_OMAP_DELETE);
+            task->omap->deleteNode(request.key);
+        } else {
+            IOStats::setOperation(IO_OMAP_READ);
+            string res = task->omap->find(request.key);
+            std::memcpy(request.result, res.data(), std::min(res.size(), (size_t) 16));
+        }
+    }
+    IOStats::setOperation(IO_OTHER);
+    return NULL;
+}
+
+int ShardedOMAP::execute(std::vector<ShardRequest>& requests) {
+    long long count = requests.size();
+    int shardCount = (int) shards.size();
+    if (count == 0) {
+        return 0;
+    }
+    int bound = SubBatchSize(count, shardCount);
+    std::vector<ShardRequest> routed;
+    long long dropped;
+    do {
+        // real requests followed by bound dummies per shard, sorted by shard with the real ones first and
+        // in batch order below that, so the requests on one key run in the order they were made
+        routed.assign(count + (long long) shardCount * bound, ShardRequest());
+        for (long long i = 0; i < count; i++) {
+            routed[i] = requests[i];
+            routed[i].shard = shardOf(requests[i].key);
+            routed[i].index = i;
+            routed[i].isDummy = 0;
+            routed[i].sortKey = (routed[i].shard * 2) << 32 | (unsigned long long) i;
+        }
+        for (long long i = count; i < (long long) routed.size(); i++) {
+            unsigned long long r;
+            sgx_read_rand((unsigned char*) &r, sizeof (r));
+            routed[i].shard = (i - count) / bound;
+            routed[i].index = i;
+            routed[i].isDummy = 1;
+            routed[i].op = OMAP_OP_READ;
+            routed[i].key = (long long) (r % maxSize) + 1;
+            routed[i].sortKey = (routed[i].shard * 2 + 1) << 32 | (unsigned long long) i;
+        }
+        sort(routed, 0, (int) routed.size(), 1);
+
+        // the first bound entries of every shard are kept, the rest sort to the end, and the position
+        // breaks ties since the sort is not stable
+        long long rank = 0;
+        unsigned long long previous = shardCount;
+        unsigned long long position = 0;
+        dropped = 0;
+        for (ShardRequest& request : routed) {
+            rank = Bid::conditional_select(rank + 1, 0LL, Bid::CTeq(request.shard, previous));
+            bool keep = Bid::CTeq(Bid::CTcmp(rank, (long long) bound), -1);
+            request.sortKey = Bid::conditional_select(request.shard, (unsigned long long) shardCount, keep) << 32 | position++;
+            dropped += !keep & !request.isDummy;
+            previous = request.shard;
+        }
+        sort(routed, 0, (int) routed.size(), 1);
+        // a shard overflowed, which happens with probability 2^-securityParameter
+        bound = (int) count;
+    } while (dropped != 0);
+    bound = (int) (routed.size() - count) / shardCount;
+    routed.resize((long long) shardCount * bound);
+
+    bool tracing = Trace::enabled;
+    Trace::enabled = false;
+    std::vector<ShardTask> tasks(shardCount);
+    std::vector<pthread_t> threads(shardCount);
+    for (int s = 0; s < shardCount; s++) {
+        tasks[s].omap = shards[s];
+        tasks[s].requests = routed.data() + (long long) s * bound;
+        tasks[s].count = bound;
+    }
+    // shard 0 runs on the calling thread
+    for (int s = 1; s < shardCount; s++) {
+        pthread_create(&threads[s], NULL, runShard, &tasks[s]);
+    }
+    runShard(&tasks[0]);
+    for (int s = 1; s < shardCount; s++) {
+        pthread_join(threads[s], NULL);
+    }
+    Trace::enabled = tracing;
+
+    // back to batch order, the dummies sort after the real requests
+    for (ShardRequest& request : routed) {
+        request.sortKey = request.index;
+    }
+    sort(routed, 0, (int) routed.size(), 1);
+    for (long long i = 0; i < count; i++) {
+        std::memcpy(requests[i].result, routed[i].result, 16);
+    }
+    return (int) count;
+}
@@ -0,0 +1,70 @@
+#ifndef SHARDEDOMAP_H
+#define SHARDEDOMAP_H
+
+#include "OMAP.h"
+#include <vector>
+
+// Upper bound on the shards, each one runs on its own TCS and a pipelined shard takes a second one (TCSNum is 18)
+#define MAX_SHARDS 8
+
+/**
+ * One entry of a sharded batch. The routing fields are only used inside the
+ * batch, the struct is a multiple of 8 bytes so it can be swapped word-wise.
+ */
+struct ShardRequest {
+    unsigned long long sortKey;
+    unsigned long long shard;
+    unsigned long long index; // position in the batch, dummies come after the real requests
+    unsigned long long isDummy;
+    long long op;
+    Bid key;
+    char value[16];
+    char result[16];
+    char padding[6];
+};
+
+/**
+ * P independent OMAPs, each with its own untrusted store. A key
+ * belongs to the shard given by a keyed hash. A batch is split into P
+ * sub-batches of the same padded size with oblivious sorts, so neither the
+ * sub-batch sizes nor the memory accesses of the routing depend on the keys,
+ * and the sub-batches run in parallel on separate enclave threads.
+ */
+class ShardedOMAP {
+private:
+    std::vector<OMAP*> shards;
+    unsigned long long hashKey[2];
+    int maxSize;
+
+    unsigned long long shardOf(Bid key);
+    static void conditionalSwap(ShardRequest& a, ShardRequest& b, int choice);
+    static void sort(std::vector<ShardRequest>& requests, int low, int n, int dir);
+    static void merge(std::vector<ShardRequest>& requests, int low, int n, int dir);
+    static void* runShard(void* arg);
+
+public:
+    /**
+     * Statistical security parameter of the sub-batch padding: a batch needs
+     * a second, unpadded round with probability at most 2^-securityParameter
+     */
+    static int securityParameter;
+
+    ShardedOMAP(int shardCount, int maxSize, bytes<Key> key);
+    virtual ~ShardedOMAP();
+
+    /**
+     * Balls into bins bound: with count keys hashed to shardCount shards no
+     * shard gets more than this many, except with probability
+     * 2^-securityParameter (Chernoff bound over all shards)
+     */
+    static int SubBatchSize(long long count, int shardCount);
+
+    int shardCount();
+    /**
+     * Executes the batch, the results are left in requests[i].result
+     * @return number of requests executed
+     */
+    int execute(std::vector<ShardRequest>& requests);
+};
+
+#endif /* SHARDEDOMAP_H */
@@ -0,0 +1,38 @@
+#include "StashConfig.hpp"
+#include "Bid.h"
+#include <cmath>
+
+double StashConfig::failureProbability = 0;
+
+unsigned int StashConfig::PermanentStashSize(int z, long long maxSize) {
+    // the bound is proven for Z >= 5 only, smaller buckets such as the default Z = 4 keep the fixed size
+    if (failureProbability <= 0 || failureProbability >= 1 || z < 5) {
+        return DEFAULT_STASH_SIZE;
+    }
+    double accesses = (double) (maxSize > 1 ? maxSize : 1);
+    double size = ceil(log(14.0 * accesses / failureProbability) / log(1 / 0.6002));
+    return (unsigned int) (size < 1 ? 1 : size);
+}
+
+void StashStats::reset(unsigned int stashSize) {
+    histogram.assign(stashSize + 1, 0);
+    maxOccupancy = 0;
+    overflows = 0;
+    evictions = 0;
+}
+
+/**
+ * the histogram is updated with a full scan so that the touched entry does
+ * not reveal the occupancy through the memory access pattern
+ */
+void StashStats::record(int occupancy) {
+    int last = (int) histogram.size() - 1;
+    bool overflow = Bid::CTeq(Bid::CTcmp((long long) occupancy, (long long) last), 1);
+    int bucket = Bid::conditional_select(last, occupancy, overflow);
+    for (int i = 0; i <= last; i++) {
+        histogram[i] = Bid::conditional_select(histogram[i] + 1, histogram[i], Bid::CTeq(i, bucket));
+    }
+    maxOccupancy = Bid::conditional_select(occupancy, maxOccupancy, Bid::CTeq(Bid::CTcmp((long long) occupancy, (long long) maxOccupancy), 1));
+    overflows = Bid::conditional_select(overflows + 1, overflows, overflow);
+    evictions++;
+}
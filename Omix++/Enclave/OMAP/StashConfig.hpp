@@ -0,0 +1,45 @@
+#ifndef STASHCONFIG_H
+#define STASHCONFIG_H
+
+#include <vector>
+
+// Permanent stash size used when no target failure probability is configured
+#define DEFAULT_STASH_SIZE 90
+
+class StashConfig {
+public:
+    /**
+     * Target probability that the stash overflows at least once during
+     * maxSize accesses. 0 keeps DEFAULT_STASH_SIZE, and so does Z < 5.
+     */
+    static double failureProbability;
+
+    /**
+     * Path ORAM stash bound (Stefanov et al.): for Z >= 5 a single access
+     * overflows a stash of R blocks with probability at most 14 * 0.6002^R.
+     * A union bound over maxSize accesses gives the smallest R that meets
+     * the configured failure probability. The paper proves no bound for
+     * Z = 4, the default, so smaller buckets get DEFAULT_STASH_SIZE.
+     * @param z blocks per bucket
+     * @param maxSize number of blocks (and accesses) the ORAM is sized for
+     * @return permanent stash size
+     */
+    static unsigned int PermanentStashSize(int z, long long maxSize);
+};
+
+/**
+ * Occupancy of the stash after each eviction, i.e. the number of real blocks
+ * that could not be written back to the path.
+ */
+class StashStats {
+public:
+    std::vector<long long> histogram;
+    int maxOccupancy = 0;
+    long long overflows = 0;
+    long long evictions = 0;
+
+    void reset(unsigned int stashSize);
+    void record(int occupancy);
+};
+
+#endif /* STASHCONFIG_H */
@@ -0,0 +1,16 @@
+#ifndef STOREHANDLE_H
+#define STOREHANDLE_H
+
+#include <stdexcept>
+
+/**
+ * The setup ocalls return -1 once the untrusted side has no free store, and
+ * every later store ocall would then address a store that is not there
+ */
+inline void CheckStore(int handle) {
+    if (handle < 0) {
+        throw std::runtime_error("No free untrusted store");
+    }
+}
+
+#endif /* STOREHANDLE_H */
@@ -0,0 +1,40 @@
+#include "Trace.hpp"
+#include "Enclave_t.h"
+
+int Trace::phases[TRACE_RING_SIZE];
+unsigned long long Trace::durations[TRACE_RING_SIZE];
+size_t Trace::head = 0;
+unsigned long long Trace::counter = 0;
+bool Trace::enabled = false;
+
+unsigned long long Trace::now() {
+    if (!enabled) {
+        return 0;
+    }
+#ifdef TRACE_RDTSC
+    unsigned int lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((unsigned long long) hi << 32) | lo;
+#else
+    return ++counter;
+#endif
+}
+
+void Trace::record(int phase, unsigned long long start) {
+    if (!enabled) {
+        return;
+    }
+    phases[head] = phase;
+    durations[head] = now() - start;
+    head++;
+    if (head == TRACE_RING_SIZE) {
+        flush();
+    }
+}
+
+void Trace::flush() {
+    if (head != 0) {
+        ocall_flush_trace(phases, durations, head);
+    }
+    head = 0;
+}
@@ -0,0 +1,44 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+
+// Number of events buffered in the enclave before they are flushed in one ocall
+#define TRACE_RING_SIZE 4096
+
+enum TracePhase {
+    TRACE_FETCH = 0,
+    TRACE_DECRYPT,
+    TRACE_SORT,
+    TRACE_ASSIGN,
+    TRACE_ENCRYPT,
+    TRACE_WRITEBACK,
+    TRACE_PHASES
+};
+
+/**
+ * Phase tracing that stays inside the enclave. Durations are kept in a ring
+ * buffer and handed to the App in a single ocall once the buffer is full or
+ * flush() is called, so the instrumentation does not add an enclave exit per
+ * measurement.
+ *
+ * With TRACE_RDTSC (simulation mode, or SGX2 hardware where RDTSC is allowed
+ * inside the enclave) durations are TSC cycles. Otherwise a monotonic counter
+ * is used and durations only count the tracing points passed in between.
+ */
+class Trace {
+private:
+    static int phases[TRACE_RING_SIZE];
+    static unsigned long long durations[TRACE_RING_SIZE];
+    static size_t head;
+    static unsigned long long counter;
+
+public:
+    static bool enabled;
+
+    static unsigned long long now();
+    static void record(int phase, unsigned long long start);
+    static void flush();
+};
+
+#endif /* TRACE_H */
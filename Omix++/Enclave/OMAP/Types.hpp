@@ -14,8 +14,11 @@ using block = std::vector<byte_t>;
 template <size_t N>
 using bytes = std::array<byte_t, N>;
 
-// A bucket contains a number of Blocks
-constexpr int Z = 4;
+// A bucket contains a number of Blocks, ORAM_Z can be overridden at build time for benchmarks
+#ifndef ORAM_Z
+#define ORAM_Z 4
+#endif
+constexpr int Z = ORAM_Z;
 
 enum Op {
     READ,
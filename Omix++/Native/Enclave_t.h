@@ -0,0 +1,105 @@
+/*
+ * Hand-written counterpart of the edger8r output for the native build. It
+ * uses the same include guard as the generated header so that a stale
+ * Enclave/Enclave_t.h from an SGX build is ignored. Keep it in sync with
+ * Enclave/Enclave.edl and Enclave/OMAP/OMAP.edl.
+ */
+#ifndef ENCLAVE_T_H__
+#define ENCLAVE_T_H__
+
+#include <cstddef>
+#include <cstdint>
+#include "sgx_trts.h"
+
+typedef enum omap_operation {
+    OMAP_OP_READ = 0,
+    OMAP_OP_WRITE = 1,
+    OMAP_OP_DELETE = 2,
+} omap_operation;
+
+typedef struct omap_request {
+    int op;
+    char key[10];
+    char value[16];
+} omap_request;
+
+/* ecalls, called directly by the native benchmark */
+void ecall_setup_oram(int max_size);
+void ecall_read_node(const char* bid, char* value);
+void ecall_write_node(const char* bid, const char* value);
+void ecall_delete_node(const char* bid);
+int ecall_execute_batch(const struct omap_request* requests, char* results, size_t count);
+void ecall_setup_sharded_omap(int shards, int max_size);
+int ecall_execute_sharded_batch(const struct omap_request* requests, char* results, size_t count);
+void ecall_setup_omap_by_client(int max_size, const char* bid, long long rootPos, const char* secretKey, int store);
+double ecall_measure_oram_speed(int testSize);
+double ecall_measure_omap_speed(int testSize);
+double ecall_measure_eviction_speed(int testSize);
+double ecall_measure_oram_setup_speed(int testSize);
+double ecall_measure_omap_setup_speed(int testSize);
+void ecall_print_tree();
+void ecall_tree_preorder_keys(long long* keys, size_t len);
+void ecall_measure_btree_read_speed(int testSize);
+void ecall_measure_btree_read_write_speed(int testSize);
+void ecall_measure_stash_scan_speed(int testSize);
+void ecall_set_stash_failure_probability(double probability);
+void ecall_set_tracing(int enabled);
+void ecall_set_pipelining(int enabled);
+void ecall_flush_trace();
+void ecall_get_io_stats(int operation, long long* counters, size_t len);
+void ecall_reset_io_stats();
+int ecall_get_stash_stats(int structure, long long* histogram, size_t len, long long* overflows);
+void ecall_setup_oheap(int maxSize, int decreaseKey);
+void ecall_dummy_heap_op();
+void ecall_set_new_minheap_node(int newMinHeapNodeV, int newMinHeapNodeDist);
+void ecall_extract_min_id(int* id, int* dist);
+void ecall_execute_heap_operation(int* id, int* dist, int op);
+void ecall_execute_heap_batch(int* id, int* dist, size_t count, int op);
+void ecall_stream_graph_edges(const int* sources, const int* destinations, const int* weights, size_t count);
+void ecall_build_graph(int vertex_count, int bulk, long long spare_edges, double* build_time);
+void ecall_add_graph_edge(int source, int destination, int weight);
+void ecall_remove_graph_edge(int source, int destination);
+long long ecall_update_graph_edges(const int* sources, const int* destinations, const int* weights, const int* removes, size_t count);
+void ecall_run_sssp(int source, long long* distances, size_t len, double* phase_times);
+void ecall_build_edge_list(int vertex_count);
+void ecall_run_bfs(int source, int rounds, long long* hops, size_t len, double* time);
+void ecall_run_components(int rounds, long long* labels, size_t len, double* time);
+void ecall_run_mst(int strategy, long long* total_weight, int* sources, int* destinations, int* weights, size_t len, int* edge_count, double* time);
+void ecall_build_pagerank_graph(int vertex_count, double* build_time);
+void ecall_run_pagerank(int iterations, double damping, double* ranks, size_t len, double* iteration_time);
+void ecall_setup_oarray(long long size);
+void ecall_read_oarray(long long index, char* value);
+void ecall_write_oarray(long long index, const char* value);
+void ecall_setup_oqueue(int capacity);
+void ecall_setup_ostack(int capacity);
+int ecall_execute_queue_operation(int* value, int op);
+int ecall_execute_stack_operation(int* value, int op);
+void ecall_setup_omultimap(long long capacity, int max_chain);
+int ecall_multimap_append(const char* bid, long long value);
+int ecall_multimap_get(const char* bid, long long* values, size_t max_count);
+int ecall_multimap_remove(const char* bid, long long value);
+void ecall_setup_blob_store(long long records, long long chunk_count, int chunk_size, int max_chunks);
+int ecall_write_blob(const char* bid, const char* data, size_t len);
+int ecall_read_blob(const char* bid, char* data, size_t max_len);
+
+/* ocalls, forwarded to the App's handlers by NativeOcalls.cpp */
+sgx_status_t SGX_CDECL ocall_print_string(const char* str);
+sgx_status_t SGX_CDECL ocall_start_timer(int timerID);
+sgx_status_t SGX_CDECL ocall_stop_timer(double* retval, int timerID);
+sgx_status_t SGX_CDECL ocall_flush_trace(const int* phases, const unsigned long long* durations, size_t len);
+
+sgx_status_t SGX_CDECL ocall_setup_ramStore(int* retval, size_t num, int size);
+sgx_status_t SGX_CDECL ocall_nread_ramStore(size_t* retval, int store, size_t blockCount, long long* indexes, char* blk, size_t len);
+sgx_status_t SGX_CDECL ocall_nwrite_ramStore(int store, size_t blockCount, long long* indexes, const char* blk, size_t len);
+sgx_status_t SGX_CDECL ocall_initialize_ramStore(int store, long long begin, long long end, const char* block, size_t len);
+sgx_status_t SGX_CDECL ocall_write_ramStore(int store, long long pos, const char* block, size_t len);
+
+sgx_status_t SGX_CDECL ocall_setup_heapStore(int* retval, size_t num, int size);
+sgx_status_t SGX_CDECL ocall_nread_heapStore(size_t* retval, int store, size_t blockCount, long long* indexes, char* blk, size_t len);
+sgx_status_t SGX_CDECL ocall_nwrite_heapStore(int store, size_t blockCount, long long* indexes, const char* blk, size_t len);
+sgx_status_t SGX_CDECL ocall_initialize_heapStore(int store, long long begin, long long end, const char* block, size_t len);
+sgx_status_t SGX_CDECL ocall_write_heapStore(int store, long long pos, const char* block, size_t len);
+
+sgx_status_t SGX_CDECL ocall_release_store(int store);
+
+#endif /* ENCLAVE_T_H__ */
@@ -0,0 +1,181 @@
+/*
+ * Hand-written counterpart of the untrusted edger8r output for the native
+ * build, for the code it shares with the App (App/Experiments.cpp). The
+ * ecalls take the enclave id and return their value through a pointer as in
+ * the App, and run the enclave code linked in. It uses the same include
+ * guard as the generated header and is force-included, so that a stale
+ * App/Enclave_u.h from an SGX build is ignored. Add an ecall here when the
+ * shared code starts to call it.
+ */
+#ifndef ENCLAVE_U_H__
+#define ENCLAVE_U_H__
+
+#include "sgx_eid.h"
+#include "Enclave_t.h"
+
+inline sgx_status_t ecall_setup_oram(sgx_enclave_id_t eid, int max_size) {
+    ecall_setup_oram(max_size);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_read_node(sgx_enclave_id_t eid, const char* bid, char* value) {
+    ecall_read_node(bid, value);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_write_node(sgx_enclave_id_t eid, const char* bid, const char* value) {
+    ecall_write_node(bid, value);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_get_io_stats(sgx_enclave_id_t eid, int operation, long long* counters, size_t len) {
+    ecall_get_io_stats(operation, counters, len);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_reset_io_stats(sgx_enclave_id_t eid) {
+    ecall_reset_io_stats();
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_setup_oheap(sgx_enclave_id_t eid, int maxSize, int decreaseKey) {
+    ecall_setup_oheap(maxSize, decreaseKey);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_execute_heap_operation(sgx_enclave_id_t eid, int* id, int* dist, int op) {
+    ecall_execute_heap_operation(id, dist, op);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_stream_graph_edges(sgx_enclave_id_t eid, const int* sources, const int* destinations, const int* weights, size_t count) {
+    ecall_stream_graph_edges(sources, destinations, weights, count);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_build_graph(sgx_enclave_id_t eid, int vertex_count, int bulk, long long spare_edges, double* build_time) {
+    ecall_build_graph(vertex_count, bulk, spare_edges, build_time);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_add_graph_edge(sgx_enclave_id_t eid, int source, int destination, int weight) {
+    ecall_add_graph_edge(source, destination, weight);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_remove_graph_edge(sgx_enclave_id_t eid, int source, int destination) {
+    ecall_remove_graph_edge(source, destination);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_update_graph_edges(sgx_enclave_id_t eid, long long* retval, const int* sources, const int* destinations, const int* weights, const int* removes, size_t count) {
+    *retval = ecall_update_graph_edges(sources, destinations, weights, removes, count);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_run_sssp(sgx_enclave_id_t eid, int source, long long* distances, size_t len, double* phase_times) {
+    ecall_run_sssp(source, distances, len, phase_times);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_build_edge_list(sgx_enclave_id_t eid, int vertex_count) {
+    ecall_build_edge_list(vertex_count);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_run_bfs(sgx_enclave_id_t eid, int source, int rounds, long long* hops, size_t len, double* time) {
+    ecall_run_bfs(source, rounds, hops, len, time);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_run_components(sgx_enclave_id_t eid, int rounds, long long* labels, size_t len, double* time) {
+    ecall_run_components(rounds, labels, len, time);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_run_mst(sgx_enclave_id_t eid, int strategy, long long* total_weight, int* sources, int* destinations, int* weights, size_t len, int* edge_count, double* time) {
+    ecall_run_mst(strategy, total_weight, sources, destinations, weights, len, edge_count, time);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_build_pagerank_graph(sgx_enclave_id_t eid, int vertex_count, double* build_time) {
+    ecall_build_pagerank_graph(vertex_count, build_time);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_run_pagerank(sgx_enclave_id_t eid, int iterations, double damping, double* ranks, size_t len, double* iteration_time) {
+    ecall_run_pagerank(iterations, damping, ranks, len, iteration_time);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_setup_oarray(sgx_enclave_id_t eid, long long size) {
+    ecall_setup_oarray(size);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_read_oarray(sgx_enclave_id_t eid, long long index, char* value) {
+    ecall_read_oarray(index, value);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_write_oarray(sgx_enclave_id_t eid, long long index, const char* value) {
+    ecall_write_oarray(index, value);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_setup_oqueue(sgx_enclave_id_t eid, int capacity) {
+    ecall_setup_oqueue(capacity);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_setup_ostack(sgx_enclave_id_t eid, int capacity) {
+    ecall_setup_ostack(capacity);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_execute_queue_operation(sgx_enclave_id_t eid, int* retval, int* value, int op) {
+    *retval = ecall_execute_queue_operation(value, op);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_execute_stack_operation(sgx_enclave_id_t eid, int* retval, int* value, int op) {
+    *retval = ecall_execute_stack_operation(value, op);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_setup_omultimap(sgx_enclave_id_t eid, long long capacity, int max_chain) {
+    ecall_setup_omultimap(capacity, max_chain);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_multimap_append(sgx_enclave_id_t eid, int* retval, const char* bid, long long value) {
+    *retval = ecall_multimap_append(bid, value);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_multimap_get(sgx_enclave_id_t eid, int* retval, const char* bid, long long* values, size_t max_count) {
+    *retval = ecall_multimap_get(bid, values, max_count);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_multimap_remove(sgx_enclave_id_t eid, int* retval, const char* bid, long long value) {
+    *retval = ecall_multimap_remove(bid, value);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_setup_blob_store(sgx_enclave_id_t eid, long long records, long long chunk_count, int chunk_size, int max_chunks) {
+    ecall_setup_blob_store(records, chunk_count, chunk_size, max_chunks);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_write_blob(sgx_enclave_id_t eid, int* retval, const char* bid, const char* data, size_t len) {
+    *retval = ecall_write_blob(bid, data, len);
+    return SGX_SUCCESS;
+}
+
+inline sgx_status_t ecall_read_blob(sgx_enclave_id_t eid, int* retval, const char* bid, char* data, size_t max_len) {
+    *retval = ecall_read_blob(bid, data, max_len);
+    return SGX_SUCCESS;
+}
+
+#endif /* ENCLAVE_U_H__ */
@@ -0,0 +1,132 @@
+/*
+ * Checks the oblivious array, queue and stack against a vector and a deque:
+ * random reads and writes, and pushes, pops and peeks that overflow and
+ * drain them, at small sizes and at one past the local position map, and
+ * setups of size 0 or below, which must leave no structure instead of
+ * aborting. Exits non-zero on any mismatch, so `make native-test` fails.
+ *
+ * usage: omix_native_arraytest [operations=300]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+#include "Enclave_t.h"
+#include "Enclave.h"
+
+static int failures = 0;
+
+static void expect(const char* name, long long at, long long got, long long expected) {
+    if (got != expected) {
+        if (failures < 10) {
+            printf("%s at %lld: got %lld expected %lld\n", name, at, got, expected);
+        }
+        failures++;
+    }
+}
+
+static void checkArray(long long size, int operations, std::mt19937& rng) {
+    ecall_setup_oarray(size);
+    std::vector<long long> expected(size, 0);
+    for (int n = 0; n < operations; n++) {
+        long long index = rng() % size;
+        char value[16];
+        if (rng() % 2 == 0) {
+            long long written = rng();
+            std::memset(value, 0, sizeof (value));
+            std::memcpy(value, &written, sizeof (written));
+            ecall_write_oarray(index, value);
+            expected[index] = written;
+        } else {
+            ecall_read_oarray(index, value);
+            long long read;
+            std::memcpy(&read, value, sizeof (read));
+            expect("Array read", index, read, expected[index]);
+        }
+    }
+}
+
+/**
+ * @param stack 1 for the stack, 0 for the queue
+ */
+static void checkQueue(int capacity, int stack, int operations, std::mt19937& rng) {
+    const char* name = stack ? "Stack" : "Queue";
+    std::deque<int> expected;
+    for (int n = 0; n < operations; n++) {
+        // pushes a little more often than pops, so the structure fills up and drains
+        int op = rng() % 5 < 2 ? 2 : rng() % 3 == 0 ? 3 : 1;
+        int pushed = op == 2 ? (int) (rng() % 1000000) + 1 : 0;
+        // a push returns zero in value
+        int value = pushed;
+        int done = stack ? ecall_execute_stack_operation(&value, op) : ecall_execute_queue_operation(&value, op);
+        if (op == 2) {
+            bool room = (int) expected.size() < capacity;
+            expect(name, n, done, room);
+            if (room) {
+                expected.push_back(pushed);
+            }
+            continue;
+        }
+        bool empty = expected.empty();
+        expect(name, n, done, !empty);
+        int front = empty ? 0 : stack ? expected.back() : expected.front();
+        expect(name, n, value, front);
+        if (op == 1 && !empty) {
+            if (stack) {
+                expected.pop_back();
+            } else {
+                expected.pop_front();
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int operations = argc > 1 ? atoi(argv[1]) : 300;
+    std::mt19937 rng(17);
+
+    // a size below 1 leaves no structure, and the accesses do nothing
+    for (int size = -1; size <= 0; size++) {
+        ecall_setup_oarray(size);
+        char value[16];
+        std::memset(value, 0x5A, sizeof (value));
+        ecall_write_oarray(0, value);
+        ecall_read_oarray(0, value);
+        expect("Read without an array", size, value[0], 0);
+        ecall_setup_oqueue(size);
+        ecall_setup_ostack(size);
+        int block = 7;
+        expect("Push without a queue", size, ecall_execute_queue_operation(&block, 2), 0);
+        expect("Pop without a queue", size, ecall_execute_queue_operation(&block, 1), 0);
+        expect("Push without a stack", size, ecall_execute_stack_operation(&block, 2), 0);
+        expect("Pop without a stack", size, ecall_execute_stack_operation(&block, 1), 0);
+    }
+
+    // indexes past either end are not in the array
+    ecall_setup_oarray(4);
+    char value[16];
+    std::memset(value, 0x5A, sizeof (value));
+    ecall_write_oarray(4, value);
+    ecall_write_oarray(-1, value);
+    for (long long index = -1; index <= 4; index++) {
+        ecall_read_oarray(index, value);
+        expect("Read of an untouched block", index, value[0], 0);
+    }
+
+    long long sizes[] = {1, 3, 64, 4097};
+    for (int i = 0; i < 4; i++) {
+        checkArray(sizes[i], operations, rng);
+    }
+    int capacities[] = {1, 2, 5, 16};
+    for (int i = 0; i < 4; i++) {
+        ecall_setup_oqueue(capacities[i]);
+        checkQueue(capacities[i], 0, operations, rng);
+        ecall_setup_ostack(capacities[i]);
+        checkQueue(capacities[i], 1, operations, rng);
+    }
+
+    printf("Array, queue and stack mismatches: %d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+/*
+ * Benchmark driver of the native build: the same experiments as the App, but
+ * with the enclave code linked in directly so it can run under perf,
+ * sanitizers or a debugger without the SGX SDK.
+ *
+ * usage: omix_native_bench <maxSize> <experiment> [key=value ...]
+ *   0: OMAP speed   1: B-tree read   2: B-tree read/write   3: stash scan
+ *   5: OMAP speed with phase tracing   7: YCSB workload (options as in the App)
+ *   8: single against batched reads, [batchSize] follows the experiment
+ *   9: sharded OMAP throughput against shard count and batch size,
+ *      [shardList=1,2,4,8] [batchList=32,128,512] follow the experiment
+ *  10: sequential against pipelined path reads
+ *  11: single against batched heap inserts and extract-mins, [batchList=16,64,256] follows the experiment
+ *  12-22: graph algorithms and the array, queue, stack, multimap, blob store and
+ *      decrease-key experiments shared with the App, see App/Experiments.h
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+#include <vector>
+#include <unistd.h>
+#include "Enclave_t.h"
+#include "../App/Workload.h"
+#include "../App/Experiments.h"
+
+void printTraceHistograms();
+void traceTotals(int phase, unsigned long long* count, unsigned long long* total);
+void resetTraceTotals();
+
+class NativeWorkloadTarget : public WorkloadTarget {
+public:
+
+    static void toBid(long long key, char* bid) {
+        // Bid stores its least significant byte first in ID_SIZE (10) bytes
+        std::memset(bid, 0, 10);
+        for (int i = 0; i < 8; i++) {
+            bid[i] = (char) (key >> (i * 8));
+        }
+    }
+
+    void read(long long key, char* value) {
+        char bid[16];
+        toBid(key, bid);
+        ecall_read_node(bid, value);
+    }
+
+    void write(long long key, const char* value) {
+        char bid[16];
+        toBid(key, bid);
+        ecall_write_node(bid, value);
+    }
+
+    void remove(long long key) {
+        char bid[16];
+        toBid(key, bid);
+        ecall_delete_node(bid);
+    }
+};
+
+int main(int argc, char* argv[]) {
+    int maxSize = argc > 1 ? atoi(argv[1]) : 1024;
+    int experiment = argc > 2 ? atoi(argv[2]) : 0;
+
+    if (experiment == 0) {
+        ecall_measure_omap_speed(maxSize);
+    } else if (experiment == 1) {
+        ecall_measure_btree_read_speed(maxSize);
+    } else if (experiment == 2) {
+        ecall_measure_btree_read_write_speed(maxSize);
+    } else if (experiment == 3) {
+        ecall_measure_stash_scan_speed(maxSize);
+    } else if (experiment == 5) {
+        ecall_set_tracing(1);
+        ecall_measure_omap_speed(maxSize);
+        ecall_flush_trace();
+        printTraceHistograms();
+    } else if (experiment == 7) {
+        WorkloadConfig config;
+        config.recordCount = maxSize / 2;
+        config.capacity = maxSize;
+        for (int i = 3; i < argc; i++) {
+            if (!config.parse(argv[i])) {
+                printf("Unknown workload option: %s\n", argv[i]);
+                return -1;
+            }
+        }
+        ecall_setup_oram(maxSize);
+        NativeWorkloadTarget target;
+        Workload workload(config, &target);
+        workload.load();
+        workload.run();
+        if (config.output.empty()) {
+            workload.report(std::cout);
+        } else {
+            std::ofstream file(config.output.c_str());
+            workload.report(file);
+        }
+    } else if (experiment == 8) {
+        int batchSize = argc > 3 ? atoi(argv[3]) : 64;
+        int tests = 256;
+        ecall_setup_oram(maxSize);
+        std::vector<omap_request> requests(batchSize);
+        std::vector<char> results(16 * batchSize);
+        for (int i = 1; i <= maxSize / 2; i += batchSize) {
+            int count = std::min(batchSize, maxSize / 2 - i + 1);
+            for (int j = 0; j < count; j++) {
+                requests[j].op = OMAP_OP_WRITE;
+                NativeWorkloadTarget::toBid(i + j, requests[j].key);
+                snprintf(requests[j].value, 16, "v%d", i + j);
+            }
+            ecall_execute_batch(requests.data(), results.data(), count);
+        }
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < tests; i++) {
+            char bid[16], value[16];
+            NativeWorkloadTarget::toBid(rand() % (maxSize / 2) + 1, bid);
+            ecall_read_node(bid, value);
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (int i = 0; i < tests; i += batchSize) {
+            int count = std::min(batchSize, tests - i);
+            for (int j = 0; j < count; j++) {
+                requests[j].op = OMAP_OP_READ;
+                NativeWorkloadTarget::toBid(rand() % (maxSize / 2) + 1, requests[j].key);
+            }
+            ecall_execute_batch(requests.data(), results.data(), count);
+        }
+        auto end = std::chrono::steady_clock::now();
+        printf("Batch Size: %d\n", batchSize);
+        printf("Single Read Average Time: %f\n", std::chrono::duration<double, std::micro>(middle - begin).count() / tests);
+        printf("Batched Read Average Time: %f\n", std::chrono::duration<double, std::micro>(end - middle).count() / tests);
+    } else if (experiment == 9) {
+        std::vector<int> shardCounts, batchSizes;
+        std::stringstream shardList(argc > 3 ? argv[3] : "1,2,4,8");
+        std::stringstream batchList(argc > 4 ? argv[4] : "32,128,512");
+        std::string item;
+        while (std::getline(shardList, item, ',')) {
+            shardCounts.push_back(atoi(item.c_str()));
+        }
+        while (std::getline(batchList, item, ',')) {
+            batchSizes.push_back(atoi(item.c_str()));
+        }
+        int largest = *std::max_element(batchSizes.begin(), batchSizes.end());
+        std::vector<omap_request> requests(largest);
+        std::vector<char> results(16 * largest);
+        // the shards only run in parallel with a core each
+        printf("Cores: %ld\n", sysconf(_SC_NPROCESSORS_ONLN));
+        for (int shards : shardCounts) {
+            ecall_setup_sharded_omap(shards, maxSize);
+            for (int i = 1; i <= maxSize / 2; i += largest) {
+                int count = std::min(largest, maxSize / 2 - i + 1);
+                for (int j = 0; j < count; j++) {
+                    requests[j].op = OMAP_OP_WRITE;
+                    NativeWorkloadTarget::toBid(i + j, requests[j].key);
+                    snprintf(requests[j].value, 16, "v%d", i + j);
+                }
+                ecall_execute_sharded_batch(requests.data(), results.data(), count);
+            }
+            for (int batchSize : batchSizes) {
+                for (int j = 0; j < batchSize; j++) {
+                    requests[j].op = j % 2 == 0 ? OMAP_OP_READ : OMAP_OP_WRITE;
+                    NativeWorkloadTarget::toBid(rand() % (maxSize / 2) + 1, requests[j].key);
+                    snprintf(requests[j].value, 16, "r%d", batchSize);
+                }
+                auto begin = std::chrono::steady_clock::now();
+                ecall_execute_sharded_batch(requests.data(), results.data(), batchSize);
+                auto end = std::chrono::steady_clock::now();
+                printf("Shards %d Batch %d Throughput: %f\n", shards, batchSize, batchSize / std::chrono::duration<double>(end - begin).count());
+            }
+        }
+    } else if (experiment == 10) {
+        int tests = 256;
+        const char* modes[] = {"Sequential", "Pipelined"};
+        for (int pipelined = 0; pipelined < 2; pipelined++) {
+            ecall_set_pipelining(pipelined);
+            ecall_setup_oram(maxSize);
+            for (int i = 1; i <= maxSize / 2; i++) {
+                char bid[16], value[16] = {0};
+                NativeWorkloadTarget::toBid(i, bid);
+                snprintf(value, 16, "v%d", i);
+                ecall_write_node(bid, value);
+            }
+            ecall_flush_trace();
+            resetTraceTotals();
+            ecall_set_tracing(1);
+            auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < tests; i++) {
+                char bid[16], value[16];
+                NativeWorkloadTarget::toBid(rand() % (maxSize / 2) + 1, bid);
+                ecall_read_node(bid, value);
+            }
+            auto end = std::chrono::steady_clock::now();
+            ecall_set_tracing(0);
+            ecall_flush_trace();
+            unsigned long long count, total;
+            // phase 0 is the fetch, the time the access is blocked on path reads
+            traceTotals(0, &count, &total);
+            printf("%s Read Average Time: %f\n", modes[pipelined], std::chrono::duration<double, std::micro>(end - begin).count() / tests);
+            printf("%s Fetch Cycles per Read: %f\n", modes[pipelined], (double) total / tests);
+        }
+        ecall_set_pipelining(0);
+    } else if (experiment == 11) {
+        std::stringstream list(argc > 3 ? argv[3] : "16,64,256");
+        std::string item;
+        const char* phases[] = {"Single Insert", "Batched Insert", "Single Extract-Min", "Batched Extract-Min"};
+        while (std::getline(list, item, ',')) {
+            int batchSize = atoi(item.c_str());
+            std::vector<int> ids(batchSize), dists(batchSize);
+            ecall_setup_oheap(maxSize, 0);
+            printf("Batch Size: %d\n", batchSize);
+            for (int phase = 0; phase < 4; phase++) {
+                for (int i = 0; i < batchSize; i++) {
+                    ids[i] = phase * batchSize + i + 1;
+                    dists[i] = rand() % maxSize;
+                }
+                ecall_reset_io_stats();
+                auto begin = std::chrono::steady_clock::now();
+                if (phase % 2 == 1) {
+                    ecall_execute_heap_batch(ids.data(), dists.data(), batchSize, phase < 2 ? 2 : 1);
+                } else {
+                    for (int i = 0; i < batchSize; i++) {
+                        ecall_execute_heap_operation(&ids[i], &dists[i], phase < 2 ? 2 : 1);
+                    }
+                }
+                auto end = std::chrono::steady_clock::now();
+                long long stats[2];
+                ecall_get_io_stats(3, stats, 2);
+                printf("%s Average Time: %f\n", phases[phase], std::chrono::duration<double, std::micro>(end - begin).count() / batchSize);
+                printf("%s Ocalls per Element: %f\n", phases[phase], (double) stats[1] / batchSize);
+            }
+        }
+    } else if (experiment >= 12 && experiment <= 22) {
+        return runExperiment(0, maxSize, experiment, std::vector<std::string>(argv + std::min(argc, 3), argv + argc));
+    } else {
+        printf("Unknown experiment %d\n", experiment);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Checks the word-wise Bid comparators against the byte-wise ones they
+ * replaced, on edge cases and random ids. Exits non-zero on any mismatch, so
+ * `make native-test` fails.
+ *
+ * usage: omix_native_bidtest [random=1000000]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "Bid.h"
+#include "Enclave.h"
+
+// the comparators as they were, from the most significant byte down
+static int referenceCmp(const byte_t* lhs, const byte_t* rhs, int size) {
+    int res = 0;
+    bool found = false;
+    for (int i = size - 1; i >= 0; i--) {
+        int cmpRes = Bid::CTcmp(lhs[i], rhs[i]);
+        res = Bid::conditional_select(cmpRes, res, !found);
+        found = Bid::conditional_select(true, found, !Bid::CTeq(cmpRes, 0) && !found);
+    }
+    return res;
+}
+
+static int failures = 0;
+
+static void check(const Bid& a, const Bid& b) {
+    int expected = referenceCmp(a.id.data(), b.id.data(), ID_SIZE);
+    int got = Bid::CTcmp(a, b);
+    bool operators = (a < b) == (expected == -1) && (a > b) == (expected == 1) && (a == b) == (expected == 0)
+            && (a != b) == (expected != 0) && (a <= b) == (expected != 1) && (a >= b) == (expected != -1);
+    if (got != expected || !operators) {
+        if (failures < 10) {
+            printf("Bid mismatch: got %d expected %d, ids", got, expected);
+            for (int i = ID_SIZE - 1; i >= 0; i--) {
+                printf(" %02x/%02x", a.id[i], b.id[i]);
+            }
+            printf("\n");
+        }
+        failures++;
+    }
+}
+
+static void check(const std::array<byte_t, 16>& a, const std::array<byte_t, 16>& b) {
+    int expected = referenceCmp(a.data(), b.data(), 16);
+    int got = Bid::CTcmp(a, b);
+    if (got != expected) {
+        if (failures < 10) {
+            printf("Value mismatch: got %d expected %d\n", got, expected);
+        }
+        failures++;
+    }
+}
+
+static void checkBoth(const Bid& a, const Bid& b) {
+    check(a, b);
+    check(b, a);
+    check(a, a);
+}
+
+int main(int argc, char* argv[]) {
+    long long random = argc > 1 ? atoll(argv[1]) : 1000000;
+    std::mt19937_64 rng(42);
+
+    std::vector<Bid> edges;
+    Bid zero;
+    edges.push_back(zero);
+    Bid infinity;
+    infinity.setInfinity();
+    edges.push_back(infinity);
+    long long values[] = {1, -1, 255, 256, -256, 1LL << 56, -(1LL << 56), 9223372036854775807LL, -9223372036854775807LL - 1};
+    for (long long v : values) {
+        edges.push_back(Bid(v));
+    }
+    // a single byte set at each end and in the middle, to 0x01, 0x80 and 0xFF
+    int positions[] = {0, 7, 8, ID_SIZE - 1};
+    byte_t bytes[] = {0x01, 0x80, 0xFF};
+    for (int p : positions) {
+        for (byte_t b : bytes) {
+            Bid bid;
+            bid.id[p] = b;
+            edges.push_back(bid);
+            Bid rest = infinity;
+            rest.id[p] = 0x00;
+            edges.push_back(rest);
+        }
+    }
+    for (size_t i = 0; i < edges.size(); i++) {
+        for (size_t j = 0; j < edges.size(); j++) {
+            checkBoth(edges[i], edges[j]);
+        }
+    }
+
+    for (long long n = 0; n < random; n++) {
+        Bid a, b;
+        for (int i = 0; i < ID_SIZE; i++) {
+            a.id[i] = (byte_t) rng();
+        }
+        // half of the pairs share a random prefix from the top, so lower bytes decide
+        b = a;
+        int shared = (int) (rng() % (ID_SIZE + 1));
+        for (int i = 0; i < ID_SIZE - shared; i++) {
+            b.id[i] = (byte_t) rng();
+        }
+        if (n % 2 == 0) {
+            for (int i = 0; i < ID_SIZE; i++) {
+                b.id[i] = (byte_t) rng();
+            }
+        }
+        checkBoth(a, b);
+
+        std::array<byte_t, 16> x, y;
+        for (int i = 0; i < 16; i++) {
+            x[i] = (byte_t) rng();
+            y[i] = x[i];
+        }
+        int first = (int) (rng() % 17);
+        for (int i = 0; i < first; i++) {
+            y[i] = (byte_t) rng();
+        }
+        check(x, y);
+        check(y, x);
+    }
+
+    printf("Bid comparator mismatches: %d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/*
+ * Checks OBlobStore against a map of strings: random writes and reads of
+ * values of up to the longest length and past it, writes that fail for
+ * lack of chunks or of records, which must not add a key, and the reserved
+ * all-ones key, which is refused. Exits non-zero on any mismatch, so
+ * `make native-test` fails.
+ *
+ * usage: omix_native_blobtest [operations=200]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "Enclave_t.h"
+#include "Enclave.h"
+
+static int failures = 0;
+
+static void toBid(long long key, char* bid) {
+    // Bid stores its least significant byte first in ID_SIZE (10) bytes
+    std::memset(bid, 0, 10);
+    for (int i = 0; i < 8; i++) {
+        bid[i] = (char) (key >> (i * 8));
+    }
+}
+
+static void expect(const char* name, long long key, long long got, long long expected) {
+    if (got != expected) {
+        if (failures < 10) {
+            printf("%s of key %lld: got %lld expected %lld\n", name, key, got, expected);
+        }
+        failures++;
+    }
+}
+
+static int write(long long key, const std::string& value) {
+    char bid[16];
+    toBid(key, bid);
+    return ecall_write_blob(bid, value.data(), value.size());
+}
+
+static void checkRead(long long key, const std::string& expected) {
+    char bid[16];
+    toBid(key, bid);
+    std::vector<char> data(expected.size() + 1, 0);
+    int length = ecall_read_blob(bid, data.data(), data.size());
+    if (length != (int) expected.size() || std::string(data.data(), expected.size()) != expected) {
+        if (failures < 10) {
+            printf("Read of key %lld: got %d bytes expected %d\n", key, length, (int) expected.size());
+        }
+        failures++;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int operations = argc > 1 ? atoi(argv[1]) : 200;
+    std::mt19937 rng(13);
+
+    // 2 records of up to 2 chunks of 16 bytes, with 2 chunks in all
+    ecall_setup_blob_store(2, 2, 16, 2);
+    std::string full(32, 'a');
+    expect("Write", 1, write(1, full), 1);
+    for (long long key = 2; key <= 64; key++) {
+        expect("Write with no free chunk", key, write(key, std::string(16, 'b')), 0);
+    }
+    expect("Write of an empty value", 2, write(2, ""), 1);
+    expect("Write with no free record", 3, write(3, ""), 0);
+    checkRead(3, "");
+    expect("Write of a shorter value", 1, write(1, std::string(16, 'c')), 1);
+    expect("Write into the freed chunk", 2, write(2, std::string(16, 'd')), 1);
+    checkRead(1, std::string(16, 'c'));
+    checkRead(2, std::string(16, 'd'));
+
+    // no chunks at all, only empty values fit
+    ecall_setup_blob_store(2, 0, 16, 2);
+    expect("Write of an empty value without chunks", 1, write(1, ""), 1);
+    expect("Write without chunks", 2, write(2, "x"), 0);
+    checkRead(1, "");
+    checkRead(2, "");
+
+    char bid[16], data[16];
+    std::memset(bid, 0xFF, 10);
+    expect("Write of the padding key", -1, ecall_write_blob(bid, "x", 1), 0);
+    expect("Read of the padding key", -1, ecall_read_blob(bid, data, sizeof (data)), 0);
+
+    // random writes on 6 keys of up to 4 chunks of 8 bytes, some longer than that
+    const int keys = 6, chunkSize = 8, maxChunks = 4;
+    ecall_setup_blob_store(keys, keys * maxChunks, chunkSize, maxChunks);
+    std::map<long long, std::string> expected;
+    for (int n = 0; n < operations; n++) {
+        long long key = rng() % keys + 1;
+        if (rng() % 2 == 0) {
+            std::string value(rng() % (chunkSize * maxChunks + 4), '\0');
+            for (size_t i = 0; i < value.size(); i++) {
+                value[i] = (char) ('a' + rng() % 26);
+            }
+            bool fits = value.size() <= (size_t) chunkSize * maxChunks;
+            expect("Write", key, write(key, value), fits);
+            if (fits) {
+                expected[key] = value;
+            }
+        } else {
+            checkRead(key, expected[key]);
+        }
+    }
+    for (long long key = 1; key <= keys; key++) {
+        checkRead(key, expected[key]);
+    }
+
+    printf("Blob mismatches: %d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+/*
+ * Checks the graph ecalls against the plain algorithms of App/Graph.cpp on
+ * random multigraphs, with parallel edges of different weights and
+ * self-loops on top, built both by inserts and in bulk: SSSP on the graph
+ * and after an edge with parallel copies is removed, sort-and-scan BFS and
+ * connected components, PageRank, the spanning forests of Prim and of
+ * Borůvka, and SSSP after single and batched edge updates. Exits non-zero
+ * on any mismatch, so `make native-test` fails.
+ *
+ * usage: omix_native_graphtest [graphs=6] [vertices=32]
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "Enclave_t.h"
+#include "Enclave.h"
+#include "../App/Graph.h"
+
+static int failures = 0;
+
+static void stream(const Graph& graph) {
+    for (long long i = 0; i < graph.edgeCount(); i += 4096) {
+        size_t count = (size_t) std::min(4096LL, graph.edgeCount() - i);
+        ecall_stream_graph_edges(graph.sources.data() + i, graph.destinations.data() + i, graph.weights.data() + i, count);
+    }
+}
+
+static void checkLabels(const char* name, const std::vector<long long>& labels, const std::vector<long long>& expected) {
+    for (size_t v = 1; v < labels.size(); v++) {
+        if (labels[v] != expected[v]) {
+            if (failures < 10) {
+                printf("%s: label of %d is %lld expected %lld\n", name, (int) v, labels[v], expected[v]);
+            }
+            failures++;
+        }
+    }
+}
+
+static void checkShortestPaths(const char* name, const Graph& graph) {
+    std::vector<long long> distances(graph.vertexCount + 1);
+    double phaseTimes[3];
+    ecall_run_sssp(1, distances.data(), distances.size(), phaseTimes);
+    checkLabels(name, distances, graph.shortestPaths(1));
+}
+
+static void checkTraversals(const Graph& graph) {
+    stream(graph);
+    ecall_build_edge_list(graph.vertexCount);
+    std::vector<long long> labels(graph.vertexCount + 1);
+    double time;
+    // without padding, and padded to more rounds than any path needs
+    int rounds[] = {0, graph.vertexCount + 3};
+    for (int i = 0; i < 2; i++) {
+        ecall_run_bfs(1, rounds[i], labels.data(), labels.size(), &time);
+        checkLabels("BFS", labels, graph.hops(1));
+        ecall_run_components(rounds[i], labels.data(), labels.size(), &time);
+        checkLabels("Components", labels, graph.components());
+    }
+}
+
+static void checkPageRank(const Graph& graph, int iterations) {
+    stream(graph);
+    double buildTime, iterationTime;
+    ecall_build_pagerank_graph(graph.vertexCount, &buildTime);
+    std::vector<double> ranks(graph.vertexCount + 1);
+    ecall_run_pagerank(iterations, 0.85, ranks.data(), ranks.size(), &iterationTime);
+    std::vector<double> expected = graph.pageRank(iterations, 0.85);
+    for (int v = 1; v <= graph.vertexCount; v++) {
+        if (std::abs(ranks[v] - expected[v]) > 1e-9) {
+            if (failures < 10) {
+                printf("PageRank: rank of %d is %g expected %g\n", v, ranks[v], expected[v]);
+            }
+            failures++;
+        }
+    }
+}
+
+static void checkSpanningForests(const Graph& graph) {
+    // Prim runs on the adjacency OMAP and Borůvka on the edge list, each build consumes the streamed edges
+    double buildTime;
+    stream(graph);
+    ecall_build_graph(graph.vertexCount, 1, 0, &buildTime);
+    stream(graph);
+    ecall_build_edge_list(graph.vertexCount);
+    const char* strategies[] = {"Prim", "Boruvka"};
+    for (int strategy = 0; strategy < 2; strategy++) {
+        std::vector<int> sources(graph.vertexCount), destinations(graph.vertexCount), weights(graph.vertexCount);
+        long long totalWeight;
+        int edgeCount;
+        double time;
+        ecall_run_mst(strategy, &totalWeight, sources.data(), destinations.data(), weights.data(), sources.size(), &edgeCount, &time);
+        sources.resize(edgeCount);
+        destinations.resize(edgeCount);
+        weights.resize(edgeCount);
+        int errors = graph.forestErrors(sources, destinations, weights, totalWeight);
+        if (errors != 0) {
+            if (failures < 10) {
+                printf("%s: %d errors in a forest of %d edges and weight %lld\n", strategies[strategy], errors, edgeCount, totalWeight);
+            }
+            failures += errors;
+        }
+    }
+}
+
+static void checkUpdates(Graph graph, int updates, int seed) {
+    std::mt19937 rng(seed);
+    graph.simplify();
+    stream(graph);
+    double buildTime;
+    ecall_build_graph(graph.vertexCount, 1, 2LL * updates, &buildTime);
+    // every other update removes an existing edge, the others add or reweight a random one, both directions each
+    std::vector<int> sources, destinations, weights, removes;
+    for (int i = 0; i < updates; i++) {
+        bool remove = i % 2 == 0 && graph.edgeCount() > 0;
+        int s, d, weight = rng() % 16 + 1;
+        if (remove) {
+            size_t edge = rng() % graph.edgeCount();
+            s = graph.sources[edge];
+            d = graph.destinations[edge];
+        } else {
+            s = rng() % graph.vertexCount + 1;
+            d = (s + rng() % (graph.vertexCount - 1)) % graph.vertexCount + 1;
+        }
+        graph.update(s, d, weight, remove);
+        int ends[] = {s, d};
+        for (int direction = 0; direction < 2; direction++) {
+            sources.push_back(ends[direction]);
+            destinations.push_back(ends[1 - direction]);
+            weights.push_back(weight);
+            removes.push_back(remove);
+        }
+    }
+    // the first half goes one ecall per update, the second half in one batch
+    size_t half = sources.size() / 2;
+    for (size_t i = 0; i < half; i++) {
+        if (removes[i]) {
+            ecall_remove_graph_edge(sources[i], destinations[i]);
+        } else {
+            ecall_add_graph_edge(sources[i], destinations[i], weights[i]);
+        }
+    }
+    long long edgeCount = ecall_update_graph_edges(sources.data() + half, destinations.data() + half, weights.data() + half, removes.data() + half, sources.size() - half);
+    if (edgeCount != graph.edgeCount()) {
+        if (failures < 10) {
+            printf("Updates: %lld directed edges expected %lld\n", edgeCount, graph.edgeCount());
+        }
+        failures++;
+    }
+    checkShortestPaths("Updates", graph);
+}
+
+int main(int argc, char* argv[]) {
+    int graphs = argc > 1 ? atoi(argv[1]) : 6;
+    int vertices = argc > 2 ? atoi(argv[2]) : 32;
+
+    for (int seed = 1; seed <= graphs; seed++) {
+        Graph graph;
+        graph.random(vertices, 4, 16, seed);
+        // a heavier and a lighter copy of the first edge in both directions, and a self-loop on both ends
+        int s = graph.sources[0], d = graph.destinations[0], w = graph.weights[0];
+        int extra[][3] = {{s, d, w + 5}, {d, s, w + 5}, {s, d, 1}, {d, s, 1}, {s, s, 2}, {d, d, 2}};
+        for (int i = 0; i < 6; i++) {
+            graph.sources.push_back(extra[i][0]);
+            graph.destinations.push_back(extra[i][1]);
+            graph.weights.push_back(extra[i][2]);
+        }
+        // SSSP leaves its distances in the graph, so every run gets a new build
+        for (int bulk = 0; bulk <= 1; bulk++) {
+            for (int removed = 0; removed <= 1; removed++) {
+                Graph copy = graph;
+                stream(copy);
+                double buildTime;
+                ecall_build_graph(copy.vertexCount, bulk, 0, &buildTime);
+                if (removed) {
+                    // every copy of the edge goes, in both directions
+                    ecall_remove_graph_edge(s, d);
+                    ecall_remove_graph_edge(d, s);
+                    copy.update(s, d, 0, true);
+                }
+                const char* names[][2] = {{"Insert", "Insert, removed"}, {"Bulk", "Bulk, removed"}};
+                checkShortestPaths(names[bulk][removed], copy);
+            }
+        }
+        checkTraversals(graph);
+        checkSpanningForests(graph);
+        checkUpdates(graph, 16, seed);
+
+        Graph unweighted;
+        unweighted.random(vertices, 4, 1, seed);
+        checkPageRank(unweighted, 10);
+    }
+
+    printf("Graph mismatches: %d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+/*
+ * Checks DOHEAP decrease-key: to a lower and a higher key, of a missing id,
+ * of ids past maxSize and of an element that is still in the stash, which
+ * the public operations cannot leave there on purpose. The heap is then
+ * emptied and every extraction checked, with the subtree minimum records in
+ * the enclave and outside it. The same cases then go through the heap
+ * ecalls on random keys, with every other element decreased right after its
+ * insert. Exits non-zero on any mismatch, so `make native-test` fails.
+ *
+ * usage: omix_native_heaptest [maxSize=64]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "DOHEAP.hpp"
+#include "Enclave_t.h"
+#include "Enclave.h"
+
+class HeapTest {
+private:
+    DOHEAP* heap;
+    int failures = 0;
+
+    static array<byte_t, 16> Element(unsigned long long id) {
+        array<byte_t, 16> value;
+        std::fill(value.begin(), value.end(), 0);
+        std::memcpy(value.data(), &id, sizeof (id));
+        return value;
+    }
+
+    void expect(const char* name, Bid got, Bid expected) {
+        if (got != expected) {
+            printf("%s: got key %lld expected %lld\n", name, got.getValue(), expected.getValue());
+            failures++;
+        }
+    }
+
+    Bid decrease(unsigned long long id, long long key) {
+        return heap->execute(Bid(key), Element(id), 4).first;
+    }
+
+public:
+
+    int run() {
+        bytes<Key> key{0};
+        heap = new DOHEAP(64, key, false, true);
+        Bid infinity;
+        infinity.setInfinity();
+        for (unsigned long long id = 1; id <= 8; id++) {
+            heap->execute(Bid((long long) (100 + id * 10)), Element(id), 2);
+        }
+        // id 9 as an insert leaves it when neither eviction can place it
+        HeapNode* node = new HeapNode();
+        node->pos = heap->RandomPath();
+        node->key = Bid(500LL);
+        node->value = Element(9);
+        node->index = 1;
+        node->isDummy = false;
+        heap->UpdateLeaf(9, node->pos, true);
+        heap->stash.insert(node);
+
+        expect("In stash", decrease(9, 5), Bid(500LL));
+        expect("Lower", decrease(3, 1), Bid(130LL));
+        expect("Higher", decrease(4, 1000), Bid(140LL));
+        expect("Missing", decrease(20, 1), infinity);
+        expect("Past maxSize", decrease(65, 1), infinity);
+        expect("Far past maxSize", decrease(1ULL << 40, 1), infinity);
+
+        unsigned long long order[] = {3, 9, 1, 2, 4, 5, 6, 7, 8};
+        long long keys[] = {1, 5, 110, 120, 140, 150, 160, 170, 180};
+        for (int i = 0; i < 9; i++) {
+            pair<Bid, array<byte_t, 16> > res = heap->execute(Bid(0LL), Element(0), 1);
+            expect("Extraction", res.first, Bid(keys[i]));
+            if (res.second != Element(order[i])) {
+                printf("Extraction %d: wrong element\n", i);
+                failures++;
+            }
+        }
+        expect("Empty", heap->execute(Bid(0LL), Element(0), 1).first, infinity);
+        delete heap;
+        return failures;
+    }
+};
+
+static int ecallFailures = 0;
+
+static void expectKey(const char* name, int id, int got, int expected) {
+    // a missing id reads back as the infinite key, which is negative as an int
+    if (expected < 0 ? got >= 0 : got != expected) {
+        if (ecallFailures < 10) {
+            printf("%s of id %d: got key %d expected %d\n", name, id, got, expected);
+        }
+        ecallFailures++;
+    }
+}
+
+static void decrease(const char* name, int id, int key, int expected) {
+    int value = id, dist = key;
+    ecall_execute_heap_operation(&value, &dist, 4);
+    expectKey(name, id, dist, expected);
+}
+
+static void checkEcalls(int maxSize) {
+    std::mt19937 rng(19);
+    int count = maxSize / 2;
+    ecall_setup_oheap(maxSize, 1);
+    std::vector<int> keys(count + 1);
+    for (int id = 1; id <= count; id++) {
+        // the ecall overwrites both arguments
+        int value = id, key = 1000 + rng() % 1000;
+        keys[id] = key;
+        ecall_execute_heap_operation(&value, &key, 2);
+        if (id % 2 == 0) {
+            decrease("Decrease after insert", id, keys[id] - 500, keys[id]);
+            keys[id] -= 500;
+        }
+    }
+    for (int id = 1; id <= count; id += 2) {
+        if (id % 4 == 1) {
+            decrease("Lower", id, keys[id] - 700, keys[id]);
+            keys[id] -= 700;
+        } else {
+            decrease("Higher", id, keys[id] + 5000, keys[id]);
+        }
+    }
+    for (int id = count + 1; id <= maxSize; id++) {
+        decrease("Missing", id, 1, -1);
+    }
+    for (int id = maxSize + 1; id <= maxSize + 4; id++) {
+        decrease("Past maxSize", id, 1, -1);
+    }
+
+    // the extractions come in key order with the keys set above, then the heap is empty
+    int previous = 0;
+    for (int i = 0; i < count; i++) {
+        int value = 0, dist = 0;
+        ecall_execute_heap_operation(&value, &dist, 1);
+        if (value < 1 || value > count || keys[value] < 0 || dist < previous) {
+            if (ecallFailures < 10) {
+                printf("Extraction %d: got id %d with key %d after key %d\n", i, value, dist, previous);
+            }
+            ecallFailures++;
+            continue;
+        }
+        expectKey("Extraction", value, dist, keys[value]);
+        keys[value] = -1;
+        previous = dist;
+    }
+    int value = 0, dist = 0;
+    ecall_execute_heap_operation(&value, &dist, 1);
+    expectKey("Empty", value, dist, -1);
+}
+
+int main(int argc, char* argv[]) {
+    int maxSize = argc > 1 ? atoi(argv[1]) : 64;
+    int failures = 0;
+    // with the subtree minimum records in the enclave, then encrypted outside it
+    long long limits[] = {DOHEAP::metadataInEnclaveLimit, 0};
+    for (int i = 0; i < 2; i++) {
+        DOHEAP::metadataInEnclaveLimit = limits[i];
+        HeapTest test;
+        failures += test.run();
+        checkEcalls(maxSize);
+    }
+    failures += ecallFailures;
+    printf("Decrease-key mismatches: %d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,370 @@
+/*
+ * Microbenchmarks of the ORAM hot paths, built with 'make native'.
+ *
+ * usage: omix_native_microbench [depths=14,10] [baseline=file] [save=file]
+ *
+ * Every case reports ns/op and heap allocations/op as CSV. With baseline= the
+ * change against a previous run is added, save= writes the results so they
+ * can serve as the next baseline. Z is a compile time constant, other bucket
+ * sizes are measured by rebuilding with NATIVE_CXXFLAGS=-DORAM_Z=<z>.
+ */
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <new>
+#include "ORAM.hpp"
+#include "DOHEAP.hpp"
+#include "ObliviousOperations.h"
+#include "HeapObliviousOperations.h"
+#include "Trace.hpp"
+
+void traceTotals(int phase, unsigned long long* count, unsigned long long* total);
+void resetTraceTotals();
+
+static std::atomic<long long> allocations(0);
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void* operator new[](size_t size) {
+    allocations++;
+    void* p = malloc(size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+struct BenchmarkResult {
+    string name;
+    string params;
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+class Microbenchmark {
+private:
+    vector<BenchmarkResult> results;
+    mt19937_64 rng;
+    double nsPerCycle;
+
+    /**
+     * Times run() over the iterations, setup() and teardown() are excluded
+     * @param ops operations done by one run()
+     */
+    template <class Setup, class Run, class Teardown>
+    void measure(string name, string params, int iterations, int ops, Setup setup, Run run, Teardown teardown) {
+        double ns = 0;
+        long long allocs = 0;
+        for (int i = 0; i < iterations; i++) {
+            setup();
+            long long allocsBefore = allocations;
+            auto begin = chrono::steady_clock::now();
+            run();
+            auto end = chrono::steady_clock::now();
+            allocs += allocations - allocsBefore;
+            ns += chrono::duration<double, nano>(end - begin).count();
+            teardown();
+        }
+        add(name, params, ns / ((double) iterations * ops), (double) allocs / ((double) iterations * ops));
+    }
+
+    void add(string name, string params, double nsPerOp, double allocsPerOp) {
+        BenchmarkResult result = {name, params, nsPerOp, allocsPerOp};
+        results.push_back(result);
+    }
+
+    static void nothing() {
+    }
+
+    /**
+     * Trace durations are TSC cycles, they are converted with the ratio of
+     * cycles to wall time over a short busy wait
+     */
+    void calibrate() {
+        Trace::enabled = true;
+        unsigned long long c0 = Trace::now();
+        auto t0 = chrono::steady_clock::now();
+        while (chrono::steady_clock::now() - t0 < chrono::milliseconds(50)) {
+        }
+        unsigned long long c1 = Trace::now();
+        auto t1 = chrono::steady_clock::now();
+        Trace::enabled = false;
+        nsPerCycle = chrono::duration<double, nano>(t1 - t0).count() / (double) (c1 - c0);
+    }
+
+    Node* randomNode() {
+        Node* node = new Node();
+        node->index = rng();
+        node->evictionNode = rng() % 1024;
+        node->isDummy = rng() % 4 == 0;
+        node->key = (long long) rng();
+        return node;
+    }
+
+    HeapNode* randomHeapNode() {
+        HeapNode* node = new HeapNode();
+        node->index = rng();
+        node->evictionNode = rng() % 1024;
+        node->isDummy = rng() % 4 == 0;
+        node->key = (long long) rng();
+        return node;
+    }
+
+public:
+
+    Microbenchmark() : rng(1) {
+        calibrate();
+    }
+
+    void primitives() {
+        const int batch = 1000;
+        vector<Bid> bids;
+        for (int i = 0; i <= batch; i++) {
+            bids.push_back(Bid((long long) rng()));
+        }
+        volatile int sink = 0;
+        measure("Bid::CTcmp", "-", 1000, batch, nothing, [&]() {
+            for (int i = 0; i < batch; i++) {
+                sink += Bid::CTcmp(bids[i], bids[i + 1]);
+            }
+        }, nothing);
+
+        Node* a = randomNode();
+        Node* b = randomNode();
+        measure("Node::conditional_swap", "-", 1000, batch, nothing, [&]() {
+            for (int i = 0; i < batch; i++) {
+                Node::conditional_swap(a, b, i & 1);
+            }
+        }, nothing);
+        delete a;
+        delete b;
+
+        HeapNode* c = randomHeapNode();
+        HeapNode* d = randomHeapNode();
+        measure("HeapNode::conditional_swap", "B=" + to_string(sizeof (HeapNode)), 1000, batch, nothing, [&]() {
+            for (int i = 0; i < batch; i++) {
+                HeapNode::conditional_swap(c, d, i & 1);
+            }
+        }, nothing);
+        delete c;
+        delete d;
+
+        bytes<Key> key{0};
+        size_t plaintextSize = Z * NODE_SIZE;
+        size_t clen = AES::GetCiphertextLength((int) plaintextSize);
+        block plaintext(plaintextSize, 7);
+        block ciphertext = AES::Encrypt(key, plaintext, clen, plaintextSize);
+        string params = "Z=" + to_string(Z);
+        measure("AES::Encrypt/bucket", params, 2000, 1, nothing, [&]() {
+            ciphertext = AES::Encrypt(key, plaintext, clen, plaintextSize);
+        }, nothing);
+        measure("AES::Decrypt/bucket", params, 2000, 1, nothing, [&]() {
+            plaintext = AES::Decrypt(key, ciphertext, clen);
+        }, nothing);
+
+        size_t heapPlaintextSize = Z * sizeof (HeapNode);
+        size_t heapClen = AES::GetCiphertextLength((int) heapPlaintextSize);
+        block heapPlaintext(heapPlaintextSize, 7);
+        block heapCiphertext;
+        measure("AES::Encrypt/heap-bucket", params + " B=" + to_string(sizeof (HeapNode)), 2000, 1, nothing, [&]() {
+            heapCiphertext = AES::Encrypt(key, heapPlaintext, heapClen, heapPlaintextSize);
+        }, nothing);
+    }
+
+    void sorts(int depth) {
+        // what one eviction sorts: the permanent stash plus a path of dummies
+        int n = StashConfig::PermanentStashSize(Z, 1LL << depth) + Z * (depth + 1);
+        string params = "depth=" + to_string(depth) + " n=" + to_string(n);
+        vector<Node*> nodes;
+        auto fill = [&]() {
+            for (int i = 0; i < n; i++) {
+                nodes.push_back(randomNode());
+            }
+        };
+        auto clear = [&]() {
+            for (Node* node : nodes) {
+                delete node;
+            }
+            nodes.clear();
+        };
+        measure("ObliviousOperations::oblixmergesort", params, 200, 1, fill, [&]() {
+            ObliviousOperations::oblixmergesort(&nodes);
+        }, clear);
+        measure("ObliviousOperations::bitonicSort", params, 200, 1, fill, [&]() {
+            ObliviousOperations::bitonicSort(&nodes);
+        }, clear);
+    }
+
+    void oram(int depth) {
+        bytes<Key> key{0};
+        ORAM* oram = new ORAM(1LL << depth, key, false, true);
+        string params = "depth=" + to_string(depth) + " Z=" + to_string(Z);
+        int iterations = 200;
+
+        measure("ORAM::FetchPath", params, iterations, 1, [&]() {
+            oram->start(false);
+            oram->currentLeaf = oram->RandomPath();
+        }, [&]() {
+            oram->FetchPath(oram->currentLeaf);
+        }, [&]() {
+            oram->evict(true);
+        });
+
+        resetTraceTotals();
+        measure("ORAM::evict", params, iterations, 1, [&]() {
+            oram->start(false);
+            oram->currentLeaf = oram->RandomPath();
+            oram->FetchPath(oram->currentLeaf);
+            Trace::enabled = true;
+        }, [&]() {
+            oram->evict(true);
+        }, [&]() {
+            Trace::enabled = false;
+        });
+        Trace::flush();
+        const char* phases[TRACE_PHASES] = {"fetch", "decrypt", "sort", "assignment", "encrypt", "write-back"};
+        for (int phase = TRACE_SORT; phase < TRACE_PHASES; phase++) {
+            unsigned long long count, total;
+            traceTotals(phase, &count, &total);
+            add(string("ORAM::evict/") + phases[phase], params, total * nsPerCycle / iterations, 0);
+        }
+        delete oram;
+    }
+
+    void heap(int depth) {
+        // what one heap eviction sorts, as in sorts()
+        int n = StashConfig::PermanentStashSize(Z, 1LL << depth) + Z * (depth + 1);
+        vector<HeapNode*> nodes;
+        measure("HeapObliviousOperations::oblixmergesort", "depth=" + to_string(depth) + " n=" + to_string(n) + " B=" + to_string(sizeof (HeapNode)), 200, 1, [&]() {
+            for (int i = 0; i < n; i++) {
+                nodes.push_back(randomHeapNode());
+            }
+        }, [&]() {
+            HeapObliviousOperations::oblixmergesort(&nodes);
+        }, [&]() {
+            for (HeapNode* node : nodes) {
+                delete node;
+            }
+            nodes.clear();
+        });
+
+        bytes<Key> key{0};
+        DOHEAP* heap = new DOHEAP(1LL << depth, key, false);
+        string params = "depth=" + to_string(depth) + " Z=" + to_string(Z);
+        measure("DOHEAP::UpdateMin", params, 200, 1, [&]() {
+            heap->currentLeaf = heap->RandomPath();
+        }, [&]() {
+            heap->UpdateMin();
+        }, [&]() {
+            heap->EvictBuckets();
+        });
+
+        // a full operation, with enough elements that every extraction finds one
+        std::array<byte_t, 16> value{};
+        long long filled = 256;
+        for (long long i = 1; i <= filled; i++) {
+            std::memcpy(value.data(), &i, sizeof (i));
+            heap->insert(Bid((long long) rng() % (1LL << depth) + 1), value);
+        }
+        long long next = filled + 1;
+        measure("DOHEAP::execute/insert", params, 100, 1, [&]() {
+            std::memcpy(value.data(), &next, sizeof (next));
+            next++;
+        }, [&]() {
+            heap->execute(Bid((long long) rng() % (1LL << depth) + 1), value, 2);
+        }, nothing);
+        measure("DOHEAP::execute/extract", params, 100, 1, nothing, [&]() {
+            heap->execute(Bid(0LL), value, 1);
+        }, nothing);
+        delete heap;
+    }
+
+    void report(string baselineFile, string saveFile) {
+        map<string, double> baseline;
+        if (!baselineFile.empty()) {
+            ifstream in(baselineFile.c_str());
+            string line;
+            getline(in, line);
+            while (getline(in, line)) {
+                stringstream row(line);
+                string name, params, ns;
+                getline(row, name, ',');
+                getline(row, params, ',');
+                getline(row, ns, ',');
+                baseline[name + "," + params] = atof(ns.c_str());
+            }
+        }
+        stringstream out;
+        out << "name,params,ns_per_op,allocs_per_op" << (baseline.empty() ? "" : ",baseline_ns_per_op,change_pct") << "\n";
+        for (BenchmarkResult& r : results) {
+            char line[512];
+            snprintf(line, sizeof (line), "%s,%s,%.2f,%.2f", r.name.c_str(), r.params.c_str(), r.nsPerOp, r.allocsPerOp);
+            out << line;
+            if (!baseline.empty()) {
+                string id = r.name + "," + r.params;
+                if (baseline.count(id) != 0 && baseline[id] > 0) {
+                    snprintf(line, sizeof (line), ",%.2f,%+.1f", baseline[id], (r.nsPerOp - baseline[id]) * 100 / baseline[id]);
+                    out << line;
+                } else {
+                    out << ",,";
+                }
+            }
+            out << "\n";
+        }
+        std::cout << out.str();
+        if (!saveFile.empty()) {
+            ofstream file(saveFile.c_str());
+            file << out.str();
+        }
+    }
+};
+
+int main(int argc, char* argv[]) {
+    vector<int> depths = {14, 10};
+    string baseline, save;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option.compare(0, 7, "depths=") == 0) {
+            depths.clear();
+            stringstream list(option.substr(7));
+            string depth;
+            while (getline(list, depth, ',')) {
+                depths.push_back(atoi(depth.c_str()));
+            }
+        } else if (option.compare(0, 9, "baseline=") == 0) {
+            baseline = option.substr(9);
+        } else if (option.compare(0, 5, "save=") == 0) {
+            save = option.substr(5);
+        } else {
+            std::cout << "Unknown option: " << option << std::endl;
+            return -1;
+        }
+    }
+    std::sort(depths.rbegin(), depths.rend());
+
+    Microbenchmark bench;
+    bench.primitives();
+    for (int depth : depths) {
+        bench.sorts(depth);
+        bench.oram(depth);
+        bench.heap(depth);
+    }
+    bench.report(baseline, save);
+    return 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * Checks OMultimap against a map of vectors: appends, gets and removes on
+ * random keys, removes of values and keys that are not there, appends to
+ * full chains and to a full multimap, which must fail without adding a
+ * key, appends of new keys once capacity keys are held, even emptied ones,
+ * and the reserved all-ones key, which is refused. Exits non-zero on
+ * any mismatch, so `make native-test` fails.
+ *
+ * usage: omix_native_multimaptest [operations=400]
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+#include "Enclave_t.h"
+#include "Enclave.h"
+
+static int failures = 0;
+
+static void toBid(long long key, char* bid) {
+    // Bid stores its least significant byte first in ID_SIZE (10) bytes
+    std::memset(bid, 0, 10);
+    for (int i = 0; i < 8; i++) {
+        bid[i] = (char) (key >> (i * 8));
+    }
+}
+
+static void expect(const char* name, long long key, long long got, long long expected) {
+    if (got != expected) {
+        if (failures < 10) {
+            printf("%s of key %lld: got %lld expected %lld\n", name, key, got, expected);
+        }
+        failures++;
+    }
+}
+
+static void checkGet(long long key, std::vector<long long> want, int maxChain) {
+    char bid[16];
+    toBid(key, bid);
+    std::vector<long long> found(maxChain, -1);
+    int count = ecall_multimap_get(bid, found.data(), found.size());
+    for (int i = count; i < maxChain; i++) {
+        expect("Padding of get", key, found[i], 0);
+    }
+    found.resize(std::max(0, std::min(count, maxChain)));
+    std::sort(found.begin(), found.end());
+    std::sort(want.begin(), want.end());
+    if (found != want) {
+        if (failures < 10) {
+            printf("Get of key %lld: got %d values expected %d\n", key, count, (int) want.size());
+        }
+        failures++;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int operations = argc > 1 ? atoi(argv[1]) : 400;
+    std::mt19937 rng(11);
+    char bid[16];
+
+    // removes of keys that are not there add none, so the OMAP of 8 keys takes them all
+    ecall_setup_omultimap(8, 4);
+    for (long long key = 1; key <= 64; key++) {
+        toBid(key, bid);
+        expect("Remove of a missing key", key, ecall_multimap_remove(bid, 7), 0);
+    }
+    for (long long key = 1; key <= 8; key++) {
+        toBid(key, bid);
+        expect("Append", key, ecall_multimap_append(bid, key), 1);
+    }
+    for (long long key = 1; key <= 8; key++) {
+        checkGet(key, std::vector<long long>(1, key), 4);
+    }
+
+    // a full multimap fails appends of new keys without adding them
+    ecall_setup_omultimap(4, 2);
+    for (long long key = 1; key <= 2; key++) {
+        toBid(key, bid);
+        expect("Append", key, ecall_multimap_append(bid, 10 * key), 1);
+        expect("Append", key, ecall_multimap_append(bid, 10 * key + 1), 1);
+        expect("Append to a full chain", key, ecall_multimap_append(bid, 10 * key + 2), 0);
+    }
+    for (long long key = 3; key <= 64; key++) {
+        toBid(key, bid);
+        expect("Append to a full multimap", key, ecall_multimap_append(bid, key), 0);
+    }
+    toBid(1, bid);
+    expect("Remove", 1, ecall_multimap_remove(bid, 10), 1);
+    toBid(3, bid);
+    expect("Append after a remove", 3, ecall_multimap_append(bid, 30), 1);
+    checkGet(1, std::vector<long long>(1, 11), 2);
+    checkGet(3, std::vector<long long>(1, 30), 2);
+    checkGet(4, std::vector<long long>(), 2);
+
+    // a key keeps its entry after its last value is removed, so it still counts against capacity
+    ecall_setup_omultimap(2, 2);
+    for (long long key = 1; key <= 2; key++) {
+        toBid(key, bid);
+        expect("Append", key, ecall_multimap_append(bid, key), 1);
+        expect("Remove", key, ecall_multimap_remove(bid, key), 1);
+    }
+    for (long long key = 3; key <= 64; key++) {
+        toBid(key, bid);
+        expect("Append with every key held", key, ecall_multimap_append(bid, key), 0);
+    }
+    toBid(1, bid);
+    expect("Append to an emptied key", 1, ecall_multimap_append(bid, 5), 1);
+    checkGet(1, std::vector<long long>(1, 5), 2);
+
+    std::memset(bid, 0xFF, 10);
+    expect("Append of the padding key", -1, ecall_multimap_append(bid, 1), 0);
+    expect("Remove of the padding key", -1, ecall_multimap_remove(bid, 1), 0);
+
+    // random operations on 8 keys of up to 6 values
+    const int keys = 8, maxChain = 6;
+    ecall_setup_omultimap(keys * maxChain, maxChain);
+    std::map<long long, std::vector<long long> > expected;
+    for (int n = 0; n < operations; n++) {
+        long long key = rng() % keys + 1;
+        std::vector<long long>& values = expected[key];
+        toBid(key, bid);
+        int op = rng() % 3;
+        if (op == 0) {
+            long long value = rng() % 20 + 1;
+            bool room = (int) values.size() < maxChain;
+            expect("Append", key, ecall_multimap_append(bid, value), room);
+            if (room) {
+                values.push_back(value);
+            }
+        } else if (op == 1) {
+            long long value = rng() % 20 + 1;
+            std::vector<long long>::iterator it = std::find(values.begin(), values.end(), value);
+            expect("Remove", key, ecall_multimap_remove(bid, value), it != values.end());
+            if (it != values.end()) {
+                values.erase(it);
+            }
+        } else {
+            checkGet(key, values, maxChain);
+        }
+    }
+    for (long long key = 1; key <= keys; key++) {
+        checkGet(key, expected[key], maxChain);
+    }
+
+    printf("Multimap mismatches: %d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
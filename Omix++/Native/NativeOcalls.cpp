@@ -0,0 +1,133 @@
+/*
+ * The ocalls of the native build are plain function calls into the App's
+ * handlers. Those handlers have the same names as the trusted wrappers, so
+ * the App side is compiled into its own namespace. Every standard header it
+ * needs is included first, so the includes inside the namespace are no-ops.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <chrono>
+#include <random>
+#include <mutex>
+#include <atomic>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/sysinfo.h>
+#include "Enclave_t.h"
+
+namespace untrusted {
+#include "../App/OMAP/RAMStore.cpp"
+#include "../App/OMAP/Utilities.cpp"
+#include "../App/OMAP/RAMStoreEnclaveInterface.h"
+#include "../Common/Common.h"
+}
+
+sgx_status_t sgx_read_rand(unsigned char* rand, size_t length) {
+    static std::mt19937_64 rng(std::random_device{}());
+    static std::mutex lock;
+    std::lock_guard<std::mutex> guard(lock);
+    for (size_t i = 0; i < length; i++) {
+        rand[i] = (unsigned char) rng();
+    }
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_print_string(const char* str) {
+    untrusted::ocall_print_string(str);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_start_timer(int timerID) {
+    untrusted::ocall_start_timer(timerID);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_stop_timer(double* retval, int timerID) {
+    *retval = untrusted::ocall_stop_timer(timerID);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_flush_trace(const int* phases, const unsigned long long* durations, size_t len) {
+    untrusted::ocall_flush_trace(phases, durations, len);
+    return SGX_SUCCESS;
+}
+
+void printTraceHistograms() {
+    untrusted::printTraceHistograms();
+}
+
+void traceTotals(int phase, unsigned long long* count, unsigned long long* total) {
+    *count = untrusted::traceCount[phase];
+    *total = untrusted::traceTotal[phase];
+}
+
+void resetTraceTotals() {
+    std::memset(untrusted::traceHistogram, 0, sizeof (untrusted::traceHistogram));
+    std::memset(untrusted::traceCount, 0, sizeof (untrusted::traceCount));
+    std::memset(untrusted::traceTotal, 0, sizeof (untrusted::traceTotal));
+}
+
+sgx_status_t ocall_setup_ramStore(int* retval, size_t num, int size) {
+    *retval = untrusted::ocall_setup_ramStore(num, size);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_nread_ramStore(size_t* retval, int store, size_t blockCount, long long* indexes, char* blk, size_t len) {
+    *retval = untrusted::ocall_nread_ramStore(store, blockCount, indexes, blk, len);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_nwrite_ramStore(int store, size_t blockCount, long long* indexes, const char* blk, size_t len) {
+    untrusted::ocall_nwrite_ramStore(store, blockCount, indexes, blk, len);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_initialize_ramStore(int store, long long begin, long long end, const char* block, size_t len) {
+    untrusted::ocall_initialize_ramStore(store, begin, end, block, len);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_write_ramStore(int store, long long pos, const char* block, size_t len) {
+    untrusted::ocall_write_ramStore(store, pos, block, len);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_setup_heapStore(int* retval, size_t num, int size) {
+    *retval = untrusted::ocall_setup_heapStore(num, size);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_nread_heapStore(size_t* retval, int store, size_t blockCount, long long* indexes, char* blk, size_t len) {
+    *retval = untrusted::ocall_nread_heapStore(store, blockCount, indexes, blk, len);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_nwrite_heapStore(int store, size_t blockCount, long long* indexes, const char* blk, size_t len) {
+    untrusted::ocall_nwrite_heapStore(store, blockCount, indexes, blk, len);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_initialize_heapStore(int store, long long begin, long long end, const char* block, size_t len) {
+    untrusted::ocall_initialize_heapStore(store, begin, end, block, len);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_write_heapStore(int store, long long pos, const char* block, size_t len) {
+    untrusted::ocall_write_heapStore(store, pos, block, len);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ocall_release_store(int store) {
+    untrusted::ocall_release_store(store);
+    return SGX_SUCCESS;
+}
@@ -0,0 +1,30 @@
+/*
+ * Force-included into every enclave source of the native build. The standard
+ * headers are pulled in before printf is renamed so that only the enclave's
+ * own printf (Enclave.cpp) becomes enclave_printf.
+ */
+#ifndef NATIVEPRELUDE_H
+#define NATIVEPRELUDE_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cassert>
+#include <cstdarg>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+#include "Enclave_t.h"
+
+#define printf enclave_printf
+
+#endif /* NATIVEPRELUDE_H */
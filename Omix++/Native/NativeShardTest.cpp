@@ -0,0 +1,83 @@
+/*
+ * Checks that a sharded batch returns what the requests would return one
+ * after the other: every batch writes one key several times and reads it
+ * back, among random reads and writes of other keys, and the results are
+ * compared with a map. Exits non-zero on any mismatch, so `make native-test`
+ * fails.
+ *
+ * usage: omix_native_shardtest [batches=20]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "Enclave_t.h"
+#include "Enclave.h"
+
+static void toBid(long long key, char* bid) {
+    // Bid stores its least significant byte first in ID_SIZE (10) bytes
+    std::memset(bid, 0, 10);
+    for (int i = 0; i < 8; i++) {
+        bid[i] = (char) (key >> (i * 8));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int batches = argc > 1 ? atoi(argv[1]) : 20;
+    const int maxSize = 256;
+    const int keys = 32;
+    const int repeats = 20;
+    std::mt19937 rng(7);
+    int failures = 0;
+
+    for (int shards = 1; shards <= 4; shards *= 2) {
+        ecall_setup_sharded_omap(shards, maxSize);
+        std::map<long long, std::string> expected;
+        for (int b = 0; b < batches; b++) {
+            std::vector<omap_request> requests;
+            // the same key written repeats times and then read repeats times
+            for (int r = 0; r < 2 * repeats; r++) {
+                omap_request request = omap_request();
+                request.op = r < repeats ? OMAP_OP_WRITE : OMAP_OP_READ;
+                toBid(5, request.key);
+                snprintf(request.value, 16, "w%d_%d", b, r);
+                requests.push_back(request);
+            }
+            for (int r = 0; r < 2 * repeats; r++) {
+                omap_request request = omap_request();
+                request.op = rng() % 2 == 0 ? OMAP_OP_READ : OMAP_OP_WRITE;
+                toBid(rng() % keys + 6, request.key);
+                snprintf(request.value, 16, "x%d_%d", b, r);
+                requests.insert(requests.begin() + rng() % (requests.size() + 1), request);
+            }
+            std::vector<char> results(16 * requests.size());
+            int executed = ecall_execute_sharded_batch(requests.data(), results.data(), requests.size());
+            if (executed != (int) requests.size()) {
+                printf("Shards %d batch %d: executed %d of %d\n", shards, b, executed, (int) requests.size());
+                failures++;
+                continue;
+            }
+            for (size_t i = 0; i < requests.size(); i++) {
+                long long key = 0;
+                std::memcpy(&key, requests[i].key, sizeof (key));
+                if (requests[i].op == OMAP_OP_WRITE) {
+                    expected[key] = std::string(requests[i].value, strnlen(requests[i].value, 16));
+                    continue;
+                }
+                std::string got(&results[16 * i], strnlen(&results[16 * i], 16));
+                if (got != expected[key]) {
+                    if (failures < 10) {
+                        printf("Shards %d batch %d request %d key %lld: got \"%s\" expected \"%s\"\n", shards, b, (int) i, key, got.c_str(), expected[key].c_str());
+                    }
+                    failures++;
+                }
+            }
+        }
+    }
+
+    printf("Sharded batch mismatches: %d\n", failures);
+    return failures == 0 ? 0 : 1;
+}
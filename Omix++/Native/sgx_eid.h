@@ -0,0 +1,12 @@
+/*
+ * Native stand-in for the SGX enclave id. There is no enclave in the native
+ * build, the id is passed along and ignored.
+ */
+#ifndef _SGX_EID_H_
+#define _SGX_EID_H_
+
+#include <cstdint>
+
+typedef uint64_t sgx_enclave_id_t;
+
+#endif /* _SGX_EID_H_ */
@@ -0,0 +1,17 @@
+/*
+ * Native stand-in for the SGX trusted runtime. The randomness is not meant to
+ * be cryptographically strong, it only has to drive the ORAM for profiling.
+ */
+#ifndef _SGX_TRTS_H_
+#define _SGX_TRTS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+typedef int sgx_status_t;
+#define SGX_SUCCESS 0
+#define SGX_CDECL
+
+sgx_status_t sgx_read_rand(unsigned char* rand, size_t length);
+
+#endif /* _SGX_TRTS_H_ */